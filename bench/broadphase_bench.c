@@ -0,0 +1,159 @@
+#include "faf_cars.h"
+#include "faf_levels.h"
+#include "scene.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Times the collision broadphases on the shipped levels.
+// Run from the repository root so the level sprites load.
+// Each configuration simulates the same race (same seed, same inputs),
+// so the car positions printed at the end should match across broadphases.
+// Then times scene_query_box() against testing every collidable body's box,
+// with car-sized boxes scattered over the level.
+
+const size_t BENCH_NUM_CARS = 6;
+const size_t BENCH_NUM_TICKS = 1200;
+const double BENCH_DT = 1. / 120.;
+const unsigned BENCH_SEED = 42;
+const size_t BENCH_NUM_QUERIES = 20000;
+const double BENCH_QUERY_SIZE = 100;
+
+const char *BENCH_BROADPHASE_NAMES[] = {"grid", "sweep and prune", "aabb tree",
+                                        "brute force"};
+const char *BENCH_LEVEL_NAMES[] = {"desert", "ice", "forest"};
+
+void bench_run(faf_level_t level, scene_broadphase_t broadphase) {
+    srand(BENCH_SEED);
+    list_t *cars = list_init(BENCH_NUM_CARS, NULL);
+    list_t *ai_colliders = list_init(BENCH_NUM_CARS, NULL);
+    body_t *player = faf_make_car(0, true, 0);
+    list_add(cars, player);
+    for (size_t i = 1; i < BENCH_NUM_CARS; i++) {
+        body_t *ai_car = faf_make_car((faf_car_t)i, false, 0);
+        list_add(cars, ai_car);
+        list_add(ai_colliders, faf_make_ai_car_collider(ai_car));
+    }
+
+    scene_options_t options = {.soa_physics = true, .broadphase = broadphase, .grid_cell_size = 0};
+    scene_t *scene = faf_make_level_with_options(level, cars, ai_colliders, options);
+    double step = faf_get_road_width() / (BENCH_NUM_CARS + 1);
+    for (size_t i = 0; i < list_size(cars); i++) {
+        body_t *car = list_get(cars, i);
+        body_set_centroid(car, (vector_t){.x = 150 + step * (i + 1), .y = 250});
+        scene_add_body_in_layer(scene, car, FAF_OBJECT_LAYER);
+    }
+    for (size_t i = 0; i < list_size(ai_colliders); i++) {
+        scene_add_body_in_layer(scene, list_get(ai_colliders, i), FAF_HIDDEN_LAYER);
+    }
+    faf_car_on_key(UP_ARROW, KEY_PRESSED, 0, player);
+
+    collision_reset_stats();
+    clock_t start = clock();
+    for (size_t t = 0; t < BENCH_NUM_TICKS; t++) {
+        scene_tick(scene, BENCH_DT);
+    }
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    // A cheap fingerprint of the race, to check the broadphases agree
+    double checksum = 0;
+    for (size_t i = 0; i < list_size(cars); i++) {
+        vector_t c = body_get_centroid(list_get(cars, i));
+        checksum += c.x + 3 * c.y;
+    }
+    printf("%-8s %-16s %8.1f us/tick  (checksum %.6f)\n", BENCH_LEVEL_NAMES[level],
+           BENCH_BROADPHASE_NAMES[broadphase], 1e6 * seconds / BENCH_NUM_TICKS, checksum);
+
+    // How often the remembered separating axis rejected a pair on its own
+    collision_stats_t stats = collision_get_stats();
+    size_t narrow = stats.tests - stats.box_rejections;
+    printf("%-8s %-16s %8zu narrow tests, %zu warm-started, %zu hit (%.1f%%)\n", "", "",
+           narrow, stats.warm_starts, stats.warm_hits,
+           stats.warm_starts ? 100.0 * stats.warm_hits / stats.warm_starts : 0.0);
+
+    scene_free(scene);
+    list_free(cars);
+    list_free(ai_colliders);
+}
+
+double bench_rand(double min, double max) {
+    return min + (max - min) * rand() / RAND_MAX;
+}
+
+// Finds the collidable bodies overlapping a box by testing every one
+size_t bench_query_brute_force(list_t *bodies, aabb_t box) {
+    size_t found = 0;
+    for (size_t i = 0; i < list_size(bodies); i++) {
+        aabb_t b = body_get_aabb(list_get(bodies, i));
+        if (b.min.x <= box.max.x && box.min.x <= b.max.x
+            && b.min.y <= box.max.y && box.min.y <= b.max.y) {
+            found++;
+        }
+    }
+    return found;
+}
+
+void bench_queries(faf_level_t level) {
+    list_t *cars = list_init(0, NULL);
+    list_t *ai_colliders = list_init(0, NULL);
+    scene_options_t options = {.soa_physics = true, .broadphase = SCENE_BROADPHASE_GRID,
+                               .grid_cell_size = 0};
+    scene_t *scene = faf_make_level_with_options(level, cars, ai_colliders, options);
+    body_t **members;
+    aabb_t everywhere = {.min = {.x = -1e9, .y = -1e9}, .max = {.x = 1e9, .y = 1e9}};
+    size_t num_members = scene_query_box(scene, FAF_COLLIDABLE_GROUP, everywhere, &members);
+    list_t *bodies = list_init(num_members, NULL);
+    for (size_t i = 0; i < num_members; i++) {
+        list_add(bodies, members[i]);
+    }
+
+    aabb_t *boxes = malloc(sizeof(aabb_t) * BENCH_NUM_QUERIES);
+    vector_t dimensions = scene_get_dimensions(scene);
+    srand(BENCH_SEED);
+    for (size_t q = 0; q < BENCH_NUM_QUERIES; q++) {
+        double x = bench_rand(0, dimensions.x - BENCH_QUERY_SIZE);
+        double y = bench_rand(0, dimensions.y - BENCH_QUERY_SIZE);
+        boxes[q] = (aabb_t){.min = {.x = x, .y = y},
+                            .max = {.x = x + BENCH_QUERY_SIZE, .y = y + BENCH_QUERY_SIZE}};
+    }
+
+    size_t found_tree = 0;
+    clock_t start = clock();
+    for (size_t q = 0; q < BENCH_NUM_QUERIES; q++) {
+        found_tree += scene_query_box(scene, FAF_COLLIDABLE_GROUP, boxes[q], &members);
+    }
+    double tree_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    size_t found_brute = 0;
+    start = clock();
+    for (size_t q = 0; q < BENCH_NUM_QUERIES; q++) {
+        found_brute += bench_query_brute_force(bodies, boxes[q]);
+    }
+    double brute_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("%-8s %zu bodies, query %8.3f us (tree) %8.3f us (brute force), found %zu / %zu\n",
+           BENCH_LEVEL_NAMES[level], num_members, 1e6 * tree_seconds / BENCH_NUM_QUERIES,
+           1e6 * brute_seconds / BENCH_NUM_QUERIES, found_tree, found_brute);
+
+    free(boxes);
+    list_free(bodies);
+    scene_free(scene);
+    list_free(cars);
+    list_free(ai_colliders);
+}
+
+int main(int argc, char *argv[]) {
+    faf_level_t levels[] = {DESERT_LEVEL, ICE_LEVEL, FOREST_LEVEL};
+    scene_broadphase_t broadphases[] = {SCENE_BROADPHASE_GRID, SCENE_BROADPHASE_SWEEP_PRUNE,
+                                        SCENE_BROADPHASE_AABB_TREE,
+                                        SCENE_BROADPHASE_BRUTE_FORCE};
+    for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+        for (size_t j = 0; j < sizeof(broadphases) / sizeof(broadphases[0]); j++) {
+            bench_run(levels[i], broadphases[j]);
+        }
+    }
+    for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+        bench_queries(levels[i]);
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "forces.h"
+#include "gravity_field.h"
+#include "scene.h"
+#include "shape.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Times N-body gravity: create_newtonian_gravity() on every pair against a
+// gravity field, summed exactly and with the quadtree at two accuracies.
+// Every configuration starts from the same cloud of bodies at rest, so after
+// one tick each body's velocity is just its acceleration times the tick.
+// The approximations are scored by how far those velocities are from the
+// exact ones, as a fraction of the exact velocities' RMS.
+
+const double BENCH_WORLD_SIZE = 100000;
+const double BENCH_RADIUS = 2;
+const double BENCH_MIN_DENSITY = 0.5;
+const double BENCH_MAX_DENSITY = 2;
+const double BENCH_G = 100;
+const double BENCH_DT = 1. / 60.;
+const size_t BENCH_NUM_TICKS = 5;
+const unsigned BENCH_SEED = 42;
+const size_t BENCH_SIZES[] = {250, 1000, 4000, 16000};
+// The pairwise and exact modes take O(N^2) per tick, so they stop here
+const size_t BENCH_MAX_PAIRWISE = 1000;
+const size_t BENCH_MAX_EXACT = 4000;
+
+typedef enum bench_mode {
+    BENCH_PAIRWISE,
+    BENCH_EXACT,
+    BENCH_THETA_HALF,
+    BENCH_THETA_ONE
+} bench_mode_t;
+
+const char *BENCH_MODE_NAMES[] = {"pairwise", "field exact", "field theta 0.5", "field theta 1.0"};
+const double BENCH_MODE_THETAS[] = {0, 0, 0.5, 1.0};
+
+double bench_rand(double min, double max) {
+    return min + (max - min) * rand() / RAND_MAX;
+}
+
+// Builds a cloud of n bodies spread evenly over a disc
+scene_t *bench_make_scene(size_t n, bench_mode_t mode, body_t **bodies) {
+    srand(BENCH_SEED);
+    vector_t dimensions = {.x = BENCH_WORLD_SIZE, .y = BENCH_WORLD_SIZE};
+    scene_t *scene = scene_init(dimensions);
+    scene_begin_build(scene);
+    rgb_color_t color = {.r = 1, .g = 1, .b = 1};
+    vector_t center = {.x = BENCH_WORLD_SIZE / 2, .y = BENCH_WORLD_SIZE / 2};
+    for (size_t i = 0; i < n; i++) {
+        double density = bench_rand(BENCH_MIN_DENSITY, BENCH_MAX_DENSITY);
+        bodies[i] = shape_init_circle(BENCH_RADIUS, color, density, NULL, NULL);
+        double r = BENCH_WORLD_SIZE / 2 * sqrt(bench_rand(0, 1));
+        double angle = bench_rand(0, 2 * M_PI);
+        body_set_centroid(bodies[i], vec_add(center, vec_multiply(r, (vector_t){.x = cos(angle),
+                                                                                .y = sin(angle)})));
+        scene_add_body(scene, bodies[i]);
+    }
+    if (mode == BENCH_PAIRWISE) {
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = i + 1; j < n; j++) {
+                create_newtonian_gravity(scene, BENCH_G, bodies[i], bodies[j]);
+            }
+        }
+    }
+    else {
+        gravity_field_t *field = create_gravity_field(scene, BENCH_G, BENCH_MODE_THETAS[mode]);
+        for (size_t i = 0; i < n; i++) {
+            gravity_field_add_body(field, bodies[i]);
+        }
+    }
+    scene_end_build(scene);
+    return scene;
+}
+
+// Runs one tick and records each body's velocity
+void bench_first_velocities(size_t n, bench_mode_t mode, vector_t *velocities) {
+    body_t **bodies = malloc(sizeof(body_t *) * n);
+    scene_t *scene = bench_make_scene(n, mode, bodies);
+    scene_tick(scene, BENCH_DT);
+    for (size_t i = 0; i < n; i++) {
+        velocities[i] = body_get_velocity(bodies[i]);
+    }
+    scene_free(scene);
+    free(bodies);
+}
+
+double bench_us_per_tick(size_t n, bench_mode_t mode) {
+    body_t **bodies = malloc(sizeof(body_t *) * n);
+    scene_t *scene = bench_make_scene(n, mode, bodies);
+    clock_t start = clock();
+    for (size_t t = 0; t < BENCH_NUM_TICKS; t++) {
+        scene_tick(scene, BENCH_DT);
+    }
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    scene_free(scene);
+    free(bodies);
+    return 1e6 * seconds / BENCH_NUM_TICKS;
+}
+
+// The RMS difference between two sets of velocities, relative to the RMS of the second
+double bench_relative_error(size_t n, vector_t *velocities, vector_t *exact) {
+    double diff = 0;
+    double total = 0;
+    for (size_t i = 0; i < n; i++) {
+        vector_t d = vec_subtract(velocities[i], exact[i]);
+        diff += vec_dot(d, d);
+        total += vec_dot(exact[i], exact[i]);
+    }
+    return sqrt(diff / total);
+}
+
+int main(int argc, char *argv[]) {
+    for (size_t s = 0; s < sizeof(BENCH_SIZES) / sizeof(BENCH_SIZES[0]); s++) {
+        size_t n = BENCH_SIZES[s];
+        vector_t *exact = malloc(sizeof(vector_t) * n);
+        vector_t *velocities = malloc(sizeof(vector_t) * n);
+        bool have_exact = n <= BENCH_MAX_EXACT;
+        if (have_exact) {
+            bench_first_velocities(n, BENCH_EXACT, exact);
+        }
+        for (bench_mode_t mode = BENCH_PAIRWISE; mode <= BENCH_THETA_ONE; mode++) {
+            if ((mode == BENCH_PAIRWISE && n > BENCH_MAX_PAIRWISE)
+                || (mode == BENCH_EXACT && !have_exact)) {
+                continue;
+            }
+            printf("%6zu bodies  %-16s %12.1f us/tick", n, BENCH_MODE_NAMES[mode],
+                   bench_us_per_tick(n, mode));
+            if (have_exact && mode != BENCH_EXACT) {
+                bench_first_velocities(n, mode, velocities);
+                printf("  (error %.2e)", bench_relative_error(n, velocities, exact));
+            }
+            printf("\n");
+        }
+        free(exact);
+        free(velocities);
+    }
+    return 0;
+}
\ No newline at end of file
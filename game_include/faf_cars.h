@@ -3,6 +3,7 @@
 
 #include "body.h"
 #include "sdl_wrapper.h"
+#include "terrain.h"
 #include "window.h"
 #include <stdbool.h>
 
@@ -16,17 +17,6 @@ typedef enum {
     ASTON_MARTON_VANQUISH
 } faf_car_t;
 
-// Information about the surface a car is on
-typedef struct surface_info surface_info_t;
-
-/**
- * Creates a surface info struct for a given surface.
- *
- * @param surf_coef the surface coefficient for the surface
- * @return a pointer to the initialized info.
- */
-surface_info_t *faf_surface_init(double surf_coef);
-
 /**
  * Creates a car of a given type.
  *
@@ -80,24 +70,89 @@ double faf_car_get_curr_gas(body_t *car);
 double faf_car_get_max_gas(body_t *car);
 
 /**
- * On-hit function for collisions with ai_collider.
+ * On-hit function for an AI collider running into a car or obstacle,
+ * which its AI car steers away from.
  * 
- * @param ai_collider the player ai_collider to check
- * @param other the other body in collision
+ * @param ai_collider the AI collider
+ * @param hazard the car or obstacle
  * @param axis the axis of collision
  * @param aux an auxiliary value
  */
-void faf_ai_collider_on_hit(body_t *ai_collider, body_t *other, vector_t axis, void *aux);
+void faf_ai_collider_on_hit_hazard(body_t *ai_collider, body_t *hazard, vector_t axis, void *aux);
 
 /**
- * On-hit function for collisions with a car.
+ * On-hit function for an AI collider running into gas,
+ * which its AI car steers towards on the hardest difficulty.
  * 
- * @param car the player car to check
- * @param other the other body in collision
+ * @param ai_collider the AI collider
+ * @param gas the gas
+ * @param axis the axis of collision
+ * @param aux an auxiliary value
+ */
+void faf_ai_collider_on_hit_gas(body_t *ai_collider, body_t *gas, vector_t axis, void *aux);
+
+/**
+ * On-hit function for an AI collider running into an effect, which its AI car
+ * steers towards if it helps and away from if it hurts.
+ * 
+ * @param ai_collider the AI collider
+ * @param effect_body the effect
+ * @param axis the axis of collision
+ * @param aux an auxiliary value
+ */
+void faf_ai_collider_on_hit_effect(body_t *ai_collider, body_t *effect_body, vector_t axis, void *aux);
+
+/**
+ * On-hit function for collisions between two cars.
+ * 
+ * @param car the first car
+ * @param other the second car
+ * @param axis the axis of collision
+ * @param aux a pointer to the elasticity of the collision
+ */
+void faf_car_on_hit_car(body_t *car, body_t *other, vector_t axis, void *aux);
+
+/**
+ * On-hit function for a car hitting an obstacle.
+ * 
+ * @param car the car
+ * @param obstacle the obstacle
+ * @param axis the axis of collision
+ * @param aux an auxiliary value
+ */
+void faf_car_on_hit_obstacle(body_t *car, body_t *obstacle, vector_t axis, void *aux);
+
+/**
+ * On-hit function for a car picking up an effect.
+ * Effects are triggers, so the scene removes the effect afterwards.
+ * 
+ * @param car the car
+ * @param effect_body the effect
+ * @param axis the axis of collision
+ * @param aux an auxiliary value
+ */
+void faf_car_on_hit_effect(body_t *car, body_t *effect_body, vector_t axis, void *aux);
+
+/**
+ * On-hit function for a car picking up gas.
+ * Gas is a trigger, so the scene removes the gas afterwards.
+ * 
+ * @param car the car
+ * @param gas the gas
  * @param axis the axis of collision
  * @param aux an auxiliary value
  */
-void faf_car_on_hit(body_t *car, body_t *other, vector_t axis, void *aux);
+void faf_car_on_hit_gas(body_t *car, body_t *gas, vector_t axis, void *aux);
+
+/**
+ * On-hit function for a car running over a decoration.
+ * 
+ * @param car the car
+ * @param decoration the decoration
+ * @param axis the axis of collision
+ * @param aux an auxiliary value
+ */
+void faf_car_on_hit_decoration(body_t *car, body_t *decoration, vector_t axis, void *aux);
 
 /**
  * Sets the window for the car.
@@ -107,6 +162,15 @@ void faf_car_on_hit(body_t *car, body_t *other, vector_t axis, void *aux);
  */
 void faf_car_set_window(body_t *car, window_t *window);
 
+/**
+ * Sets the terrain the car drives on; the car's friction comes from
+ * the surface under its centroid.
+ * 
+ * @param car the car
+ * @param terrain the terrain of the car's level
+ */
+void faf_car_set_terrain(body_t *car, terrain_t *terrain);
+
 /**
  * Gets the window for the car.
  * 
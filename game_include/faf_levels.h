@@ -10,6 +10,27 @@ extern const size_t FAF_FOREGROUND_LAYER;
 extern const size_t FAF_OBJECT_LAYER;
 extern const size_t FAF_CAR_LAYER;
 
+// Collision group definitions
+extern const size_t FAF_CAR_GROUP;
+extern const size_t FAF_AI_COLLIDER_GROUP;
+extern const size_t FAF_COLLIDABLE_GROUP;
+
+// Collision category definitions (see body_set_collision_filter())
+extern const size_t FAF_CAR_CATEGORY;
+extern const size_t FAF_AI_COLLIDER_CATEGORY;
+extern const size_t FAF_OBSTACLE_CATEGORY;
+extern const size_t FAF_EFFECT_CATEGORY;
+extern const size_t FAF_GAS_CATEGORY;
+extern const size_t FAF_DECORATION_CATEGORY;
+
+/**
+ * Returns the collision mask bit for a collision category.
+ *
+ * @param category one of the collision categories above
+ * @return the category's mask bit
+ */
+uint32_t faf_category_bit(size_t category);
+
 // Different levels in the game
 typedef enum {
     DESERT_LEVEL = 0,
@@ -41,4 +62,17 @@ double faf_get_road_width();
  */
 scene_t *faf_make_level(faf_level_t type, list_t *cars, list_t *ai_colliders);
 
+/**
+ * Same as faf_make_level(), but creates the scene with the given options,
+ * e.g. to compare broadphases.
+ * 
+ * @param type the type of level to create
+ * @param cars the list of cars in the level
+ * @param ai_colliders the list of AI colliders in the level
+ * @param options the options to create the scene with
+ * @return the scene for the level
+ */
+scene_t *faf_make_level_with_options(faf_level_t type, list_t *cars, list_t *ai_colliders,
+                                     scene_options_t options);
+
 #endif // #ifndef __FAF_LEVELS_H__
\ No newline at end of file
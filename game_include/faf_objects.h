@@ -6,7 +6,6 @@
 
 typedef enum {
     FAF_CAR_OBJ,
-    FAF_SURFACE_OBJ,
     FAF_OBSTACLE_OBJ,
     FAF_EFFECT_OBJ,
     FAF_GAS_OBJ,
@@ -1,3 +1,4 @@
+#include "array.h"
 #include "color.h"
 #include "faf_audio.h"
 #include "faf_cars.h"
@@ -97,17 +98,14 @@ const double ASTON_MARTON_VANQUISH_GAS_MAX = 1525;
 const char *ASTON_MARTON_VANQUISH_FILENAME = "assets/car/AstonMartinVanquish.png";
 const char *ASTON_MARTON_VANQUISH_FILENAME_FLAMES = "assets/car/AstonMartinVanquishFlames.png";
 
-typedef struct surface_info {
-    faf_object_t type;
-    double surf_coefficient;
-} surface_info_t;
-
 typedef struct car_effect {
     body_func_t f;
     double total_time;
     double time_elapsed;
 } car_effect_t;
 
+ARRAY_DECLARE(car_effect_array, car_effect_t)
+
 typedef struct car_info {
     faf_object_t obj_type;
     faf_car_t car_type;
@@ -137,24 +135,17 @@ typedef struct car_info {
     SDL_Surface *normal;
     SDL_Surface *accelerated;
 
-    list_t *effects;
+    car_effect_array_t effects;
 
     window_t *window;
+    // The ground the car drives on, or NULL if it is not in a level
+    terrain_t *terrain;
 } faf_car_info_t;
 
-surface_info_t *faf_surface_init(double surf_coef) {
-    surface_info_t *info = malloc(sizeof(surface_info_t));
-    assert(info);
-
-    info->type = FAF_SURFACE_OBJ;
-    info->surf_coefficient = surf_coef;
-
-    return info;
-}
-
 void free_car_info(faf_car_info_t *info) {
     assert(info);
 
+    car_effect_array_free(&info->effects);
     free(info);
 }
 
@@ -173,8 +164,10 @@ faf_car_info_t *make_car_info(faf_car_t car_type, bool is_player_car, double sta
     info->turning_left = false;
     info->time = start_time;
     info->dimensions = FAF_CAR_DIMENSIONS;
-    info->effects = list_init(CAR_INIT_NUM_EFFECTS, free);
+    car_effect_array_init(&info->effects, CAR_INIT_NUM_EFFECTS);
     info->window = NULL;
+    info->terrain = NULL;
+    info->surf_coef = 0;
 
     switch (car_type) {
         case FERRARI_488_GTE: {
@@ -377,10 +370,21 @@ void car_turn_left(body_t *ai_car, void *dt) {
     }
 }
 
+// Returns the car an AI collider protects, or NULL if the car has been freed
+body_t *faf_ai_collider_get_car(body_t *ai_collider) {
+    body_handle_t *car_handle = body_get_info(ai_collider);
+    assert(car_handle);
+    return body_from_handle(*car_handle);
+}
+
 void faf_ai_collider_tick(body_t *ai_collider, void *dt) {
     assert(ai_collider);
 
-    body_t *ai_car = body_get_info(ai_collider);
+    body_t *ai_car = faf_ai_collider_get_car(ai_collider);
+    if (!ai_car) {
+        body_remove(ai_collider);
+        return;
+    }
     double displacement = 2.5;
     if (faf_get_difficulty() == 2) {
         displacement = 1.5;
@@ -440,13 +444,10 @@ body_t *faf_make_player_indicator(body_t *player_car) {
 void faf_car_add_effect(body_t *car, body_func_t f, double total_time) {
     assert(car);
 
-    car_effect_t *effect = malloc(sizeof(car_effect_t));
-    effect->f = f;
-    effect->total_time = total_time;
-    effect->time_elapsed = 0.;
+    car_effect_t effect = {.f = f, .total_time = total_time, .time_elapsed = 0.};
 
     faf_car_info_t *info = body_get_info(car);
-    list_add(info->effects, effect);
+    car_effect_array_add(&info->effects, effect);
 }
 
 void faf_car_tick_AI(body_t *ai_car, void *dt) {
@@ -504,6 +505,11 @@ void faf_car_tick(body_t *car, void *dt) {
                         faf_get_scene_dimensions().x - info->dimensions.x / 2);
     body_set_centroid(car, (vector_t){.x = x_pos, .y = body_get_centroid(car).y});
 
+    // The friction comes from whatever ground is under the car
+    if (info->terrain) {
+        info->surf_coef = terrain_surface_at(info->terrain, body_get_centroid(car)).coefficient;
+    }
+
     if (!info->is_player_car) {
         faf_car_tick_AI(car, dt);
     }
@@ -589,6 +595,11 @@ void faf_car_tick(body_t *car, void *dt) {
     }
 }
 
+// remove_if() predicate for effects that have run for their full duration
+bool car_effect_expired(car_effect_t *effect, void *aux) {
+    return effect->time_elapsed >= effect->total_time;
+}
+
 void faf_car_register_tick(body_t *car, void *dt) {
     assert(car);
     faf_car_info_t *info = (faf_car_info_t *)body_get_info(car);
@@ -596,18 +607,14 @@ void faf_car_register_tick(body_t *car, void *dt) {
 
     faf_car_tick(car, dt);
 
-    size_t e_idx = 0;
-    while (e_idx < list_size(info->effects)) {
-        car_effect_t *effect = list_get(info->effects, e_idx);
+    for (size_t i = 0; i < car_effect_array_size(&info->effects); i++) {
+        car_effect_t *effect = car_effect_array_get(&info->effects, i);
         effect->time_elapsed += *((double *)dt);
         if (effect->time_elapsed < effect->total_time) {
             effect->f(car, dt);
-            e_idx++;
-        }
-        else {
-            list_remove(info->effects, e_idx);
         }
     }
+    car_effect_array_remove_if(&info->effects, car_effect_expired, NULL);
 }
 
 body_t *faf_make_car(faf_car_t type, bool is_player_car, double start_time) {
@@ -670,147 +677,166 @@ void faf_ai_car_seek(body_t *ai_car, body_t *other) {
     }
 }
 
-void faf_ai_collider_on_hit(body_t *ai_collider, body_t *other, vector_t axis, void *aux) {
+// Returns the AI car an AI collider belongs to, or NULL if the car is gone
+body_t *faf_ai_collider_get_live_car(body_t *ai_collider) {
     assert(ai_collider);
-    faf_car_info_t *car_info = body_get_info(body_get_info(ai_collider));
-    assert(car_info->obj_type == FAF_CAR_OBJ);
-    assert(other);
-    faf_object_t *other_info = body_get_info(other);
-    assert(other_info);
+    body_t *ai_car = faf_ai_collider_get_car(ai_collider);
+    if (!ai_car) {
+        return NULL;
+    }
+    faf_car_info_t *car_info = body_get_info(ai_car);
     assert(car_info);
+    assert(car_info->obj_type == FAF_CAR_OBJ);
     assert(!car_info->is_player_car);
-    body_t *ai_car = body_get_info(ai_collider);
+    return ai_car;
+}
 
-    switch (*other_info) {
-        case FAF_CAR_OBJ:
-        case FAF_OBSTACLE_OBJ: {
-            faf_ai_car_avoid(ai_car, other);
-            break;
-        }
-        case FAF_GAS_OBJ: {
-            if (faf_get_difficulty() == 3) {
-                faf_ai_car_seek(ai_car, other);
+void faf_ai_collider_on_hit_hazard(body_t *ai_collider, body_t *hazard, vector_t axis, void *aux) {
+    assert(hazard);
+    body_t *ai_car = faf_ai_collider_get_live_car(ai_collider);
+    if (ai_car) {
+        faf_ai_car_avoid(ai_car, hazard);
+    }
+}
+
+void faf_ai_collider_on_hit_gas(body_t *ai_collider, body_t *gas, vector_t axis, void *aux) {
+    assert(gas);
+    body_t *ai_car = faf_ai_collider_get_live_car(ai_collider);
+    if (ai_car && faf_get_difficulty() == 3) {
+        faf_ai_car_seek(ai_car, gas);
+    }
+}
+
+void faf_ai_collider_on_hit_effect(body_t *ai_collider, body_t *effect_body, vector_t axis, void *aux) {
+    assert(effect_body);
+    body_t *ai_car = faf_ai_collider_get_live_car(ai_collider);
+    if (!ai_car) {
+        return;
+    }
+    faf_object_info_t *object_info = body_get_info(effect_body);
+    assert(object_info);
+    faf_effect_t effect = faf_objects_get_effect_type(object_info);
+    switch (effect) {
+        case FAF_SPEED:
+        case FAF_STRENGTH:
+        case FAF_GREEN_ENERGY: {
+            if (faf_get_difficulty() != 1) {
+                faf_ai_car_seek(ai_car, effect_body);
             }
             break;
         }
-        case FAF_EFFECT_OBJ: {
-            faf_object_info_t *object_info = (faf_object_info_t *)other_info;
-            faf_effect_t effect = faf_objects_get_effect_type(object_info);
-            switch (effect) {
-                case FAF_SPEED:
-                case FAF_STRENGTH:
-                case FAF_GREEN_ENERGY: {
-                    if (faf_get_difficulty() != 1) {
-                        faf_ai_car_seek(ai_car, other);
-                    }
-                    break;
-                }
-                case FAF_SLOWDOWN:
-                case FAF_GASLEAK:
-                case FAF_LOSE_CONTROL: {
-                    faf_ai_car_avoid(ai_car, other);
-                    break;
-                }
-                default: {
-                    break;
-                }
-            }
+        case FAF_SLOWDOWN:
+        case FAF_GASLEAK:
+        case FAF_LOSE_CONTROL: {
+            faf_ai_car_avoid(ai_car, effect_body);
+            break;
         }
         default: {
-            return;
+            break;
         }
     }
 }
 
-void faf_car_on_hit(body_t *car, body_t *other, vector_t axis, void *aux) {
+void faf_car_on_hit_car(body_t *car, body_t *other, vector_t axis, void *aux) {
     assert(car);
+    assert(other);
     faf_car_info_t *car_info = body_get_info(car);
+    faf_car_info_t *other_car_info = body_get_info(other);
     assert(car_info->obj_type == FAF_CAR_OBJ);
-    assert(other);
-    faf_object_t *other_info = body_get_info(other);
-    assert(other_info);
+    assert(other_car_info->obj_type == FAF_CAR_OBJ);
 
-    switch (*other_info) {
-        case FAF_SURFACE_OBJ: {
-            surface_info_t *surface_info = (surface_info_t *)other_info;
-            car_info->surf_coef = surface_info->surf_coefficient;
+    // Each pair of cars is only reported once, so the car with strength may be either one
+    if (other_car_info->strength_enabled && !car_info->strength_enabled) {
+        body_t *swap = car;
+        car = other;
+        other = swap;
+        faf_car_info_t *swap_info = car_info;
+        car_info = other_car_info;
+        other_car_info = swap_info;
+    }
+    vector_t impulse = body_calculate_impulse(car, other, axis, *(double *)aux);
+    if (car_info->is_player_car || other_car_info->is_player_car) {
+        faf_audio_honk();
+    }
+    if (car_info->strength_enabled) {
+        body_add_impulse(other, vec_multiply(-5, impulse));
+        faf_car_add_effect(other, (body_func_t)car_lose_control, 0.25);
+    }
+    else {
+        body_add_impulse(car, impulse);
+        body_add_impulse(other, vec_negate(impulse));
+        faf_car_add_effect(car, (body_func_t)car_lose_control, 0.25);
+        faf_car_add_effect(other, (body_func_t)car_lose_control, 0.25);
+    }
+}
+
+void faf_car_on_hit_obstacle(body_t *car, body_t *obstacle, vector_t axis, void *aux) {
+    assert(car);
+    assert(obstacle);
+    faf_car_info_t *car_info = body_get_info(car);
+    assert(car_info->obj_type == FAF_CAR_OBJ);
+
+    if (!car_info->strength_enabled) {
+        body_set_velocity(car, VEC_ZERO);
+    }
+    body_remove(obstacle);
+}
+
+void faf_car_on_hit_effect(body_t *car, body_t *effect_body, vector_t axis, void *aux) {
+    assert(car);
+    assert(effect_body);
+    faf_object_info_t *object_info = body_get_info(effect_body);
+    assert(object_info);
+
+    faf_effect_t effect = faf_objects_get_effect_type(object_info);
+    switch (effect) {
+        case FAF_SPEED: {
+            faf_car_add_effect(car, (body_func_t)car_speed, FAF_CAR_EFFECT_TIME);
             break;
         }
-        case FAF_CAR_OBJ: {
-            vector_t impulse = body_calculate_impulse(car, other, axis, *(double *)aux);
-            if (car != other && car_info->is_player_car) {
-                faf_audio_honk();
-            }
-            if (car_info->strength_enabled) {
-                body_add_impulse(other, vec_multiply(-5, impulse));
-                faf_car_add_effect(other, (body_func_t)car_lose_control, 0.25);
-            }
-            else {
-                body_add_impulse(car, impulse);
-                body_add_impulse(other, vec_negate(impulse));
-                faf_car_add_effect(car, (body_func_t)car_lose_control, 0.25);
-                faf_car_add_effect(other, (body_func_t)car_lose_control, 0.25);
-            }
+        case FAF_STRENGTH: {
+            faf_car_add_effect(car, (body_func_t)car_strength, FAF_CAR_EFFECT_TIME);
             break;
         }
-        case FAF_OBSTACLE_OBJ: {
-            if (!car_info->strength_enabled) {
-                body_set_velocity(car, VEC_ZERO);
-            }
-            body_remove(other);
+        case FAF_GREEN_ENERGY: {
+            faf_car_add_effect(car, (body_func_t)car_green_energy, FAF_CAR_EFFECT_TIME);
             break;
         }
-        case FAF_EFFECT_OBJ: {
-            faf_object_info_t *object_info = (faf_object_info_t *)other_info;
-            faf_effect_t effect = faf_objects_get_effect_type(object_info);
-            switch (effect) {
-                case FAF_SPEED: {
-                    faf_car_add_effect(car, (body_func_t)car_speed, FAF_CAR_EFFECT_TIME);
-                    break;
-                }
-                case FAF_STRENGTH: {
-                    faf_car_add_effect(car, (body_func_t)car_strength, FAF_CAR_EFFECT_TIME);
-                    break;
-                }
-                case FAF_GREEN_ENERGY: {
-                    faf_car_add_effect(car, (body_func_t)car_green_energy, FAF_CAR_EFFECT_TIME);
-                    break;
-                }
-                case FAF_SLOWDOWN: {
-                    faf_car_add_effect(car, (body_func_t)car_slowdown, FAF_CAR_EFFECT_TIME);
-                    break;
-                }
-                case FAF_GASLEAK: {
-                    faf_car_add_effect(car, (body_func_t)car_gasleak, FAF_CAR_EFFECT_TIME);
-                    break;
-                }
-                case FAF_LOSE_CONTROL: {
-                    faf_car_add_effect(car, (body_func_t)car_lose_control, FAF_CAR_EFFECT_TIME);
-                    break;
-                }
-                case FAF_NULL: {
-                    break;
-                }
-            }
-            body_remove(other);
+        case FAF_SLOWDOWN: {
+            faf_car_add_effect(car, (body_func_t)car_slowdown, FAF_CAR_EFFECT_TIME);
             break;
         }
-        case FAF_GAS_OBJ: {
-            body_remove(other);
-            double gas_boost = car_info->gas_max / 3.;
-            car_info->gas_curr = mathlib_min(car_info->gas_curr + gas_boost, car_info->gas_max);
+        case FAF_GASLEAK: {
+            faf_car_add_effect(car, (body_func_t)car_gasleak, FAF_CAR_EFFECT_TIME);
             break;
         }
-        case FAF_DECORATION_OBJ: {
-            body_remove(other);
+        case FAF_LOSE_CONTROL: {
+            faf_car_add_effect(car, (body_func_t)car_lose_control, FAF_CAR_EFFECT_TIME);
             break;
         }
-        case FAF_OTHER_OBJ: {
+        case FAF_NULL: {
             break;
         }
     }
 }
 
+void faf_car_on_hit_gas(body_t *car, body_t *gas, vector_t axis, void *aux) {
+    assert(car);
+    assert(gas);
+    faf_car_info_t *car_info = body_get_info(car);
+    assert(car_info->obj_type == FAF_CAR_OBJ);
+
+    double gas_boost = car_info->gas_max / 3.;
+    car_info->gas_curr = mathlib_min(car_info->gas_curr + gas_boost, car_info->gas_max);
+}
+
+void faf_car_on_hit_decoration(body_t *car, body_t *decoration, vector_t axis, void *aux) {
+    assert(car);
+    assert(decoration);
+
+    body_remove(decoration);
+}
+
 void faf_car_set_window(body_t *car, window_t *window) {
     assert(car);
     faf_car_info_t *info = body_get_info(car);
@@ -819,6 +845,14 @@ void faf_car_set_window(body_t *car, window_t *window) {
     info->window = window;
 }
 
+void faf_car_set_terrain(body_t *car, terrain_t *terrain) {
+    assert(car);
+    faf_car_info_t *info = body_get_info(car);
+    assert(info);
+
+    info->terrain = terrain;
+}
+
 window_t *faf_car_get_window(body_t *car) {
     assert(car);
     faf_car_info_t *info = body_get_info(car);
@@ -7,6 +7,7 @@
 #include "mathlib.h"
 #include "scene.h"
 #include "shape.h"
+#include "terrain.h"
 #include "vector.h"
 #include <assert.h>
 #include <stdlib.h>
@@ -18,6 +19,19 @@ const size_t FAF_FOREGROUND_LAYER = 2;
 const size_t FAF_OBJECT_LAYER = 3;
 const size_t FAF_CAR_LAYER = 4;
 
+// Collision group definitions
+const size_t FAF_CAR_GROUP = 0;
+const size_t FAF_AI_COLLIDER_GROUP = 1;
+const size_t FAF_COLLIDABLE_GROUP = 2;
+
+// Collision category definitions; 0 is left to bodies without a filter
+const size_t FAF_CAR_CATEGORY = 1;
+const size_t FAF_AI_COLLIDER_CATEGORY = 2;
+const size_t FAF_OBSTACLE_CATEGORY = 3;
+const size_t FAF_EFFECT_CATEGORY = 4;
+const size_t FAF_GAS_CATEGORY = 5;
+const size_t FAF_DECORATION_CATEGORY = 6;
+
 // General scene properties
 const rgb_color_t FAF_REGULAR_ROAD_COLOR = {.r = (float)0.1, .g = (float)0.1, .b = (float)0.1};
 const rgb_color_t FAF_ROAD_STRIPE_COLOR = {.r = (float)1, .g = (float)1, .b = (float)1};
@@ -53,6 +67,65 @@ const double FAF_ICE_ICE_COEF = 0.1;
 const rgb_color_t FAF_FOREST_BACKGROUND_COLOR = {.r = (float)0.12, .g = (float)0.55, .b = (float)0.13};
 const double FAF_FOREST_TREES_COEF = 0.7;
 
+uint32_t faf_category_bit(size_t category) {
+    return (uint32_t)1 << category;
+}
+
+// The categories each category collides with. The game only has handlers for cars and
+// AI colliders hitting things, so items never collide with each other
+uint32_t faf_collision_mask(size_t category) {
+    uint32_t items = faf_category_bit(FAF_OBSTACLE_CATEGORY) | faf_category_bit(FAF_EFFECT_CATEGORY)
+        | faf_category_bit(FAF_GAS_CATEGORY);
+    if (category == FAF_CAR_CATEGORY) {
+        return faf_category_bit(FAF_CAR_CATEGORY) | faf_category_bit(FAF_AI_COLLIDER_CATEGORY)
+            | items | faf_category_bit(FAF_DECORATION_CATEGORY);
+    }
+    if (category == FAF_AI_COLLIDER_CATEGORY) {
+        // AI cars ignore decorations
+        return faf_category_bit(FAF_CAR_CATEGORY) | items;
+    }
+    if (category == FAF_DECORATION_CATEGORY) {
+        return faf_category_bit(FAF_CAR_CATEGORY);
+    }
+    return faf_category_bit(FAF_CAR_CATEGORY) | faf_category_bit(FAF_AI_COLLIDER_CATEGORY);
+}
+
+// Puts a collision body in the category for its object type
+void faf_set_collision_filter(body_t *body) {
+    faf_object_t *obj_type = body_get_info(body);
+    assert(obj_type);
+
+    size_t category;
+    switch (*obj_type) {
+        case FAF_CAR_OBJ: {
+            category = FAF_CAR_CATEGORY;
+            break;
+        }
+        case FAF_OBSTACLE_OBJ: {
+            category = FAF_OBSTACLE_CATEGORY;
+            break;
+        }
+        case FAF_EFFECT_OBJ: {
+            category = FAF_EFFECT_CATEGORY;
+            break;
+        }
+        case FAF_GAS_OBJ: {
+            category = FAF_GAS_CATEGORY;
+            break;
+        }
+        case FAF_DECORATION_OBJ: {
+            category = FAF_DECORATION_CATEGORY;
+            break;
+        }
+        default: {
+            // Collides with nothing
+            body_set_collision_filter(body, BODY_DEFAULT_CATEGORY, 0);
+            return;
+        }
+    }
+    body_set_collision_filter(body, category, faf_collision_mask(category));
+}
+
 vector_t faf_get_scene_dimensions() {
     return FAF_DIMENSIONS;
 }
@@ -62,6 +135,13 @@ double faf_get_road_width() {
 }
 
 scene_t *faf_make_level(faf_level_t type, list_t *cars, list_t *ai_colliders) {
+    scene_options_t options = {.soa_physics = true, .broadphase = SCENE_BROADPHASE_GRID,
+                               .grid_cell_size = 0};
+    return faf_make_level_with_options(type, cars, ai_colliders, options);
+}
+
+scene_t *faf_make_level_with_options(faf_level_t type, list_t *cars, list_t *ai_colliders,
+                                     scene_options_t options) {
     rgb_color_t side_color;
     double side_coef;
 
@@ -85,7 +165,9 @@ scene_t *faf_make_level(faf_level_t type, list_t *cars, list_t *ai_colliders) {
 
     assert(cars);
 
-    scene_t *scene = scene_init(FAF_DIMENSIONS);
+    scene_t *scene = scene_init_with_options(FAF_DIMENSIONS, options);
+    // Everything below lives and dies with the scene, so allocate it from the scene's arena
+    scene_begin_build(scene);
     list_t *collision_bodies = list_init(FAF_INIT_NUM_BODIES_IN_SCENE, NULL);
 
     // Add decorations on the side of the road
@@ -104,96 +186,95 @@ scene_t *faf_make_level(faf_level_t type, list_t *cars, list_t *ai_colliders) {
     faf_object_spawn_obstacles(scene, FAF_DIMENSIONS, collision_bodies, FAF_ROAD_WIDTH,
                                FAF_NUM_OBSTACLES, type);
 
-    // Add the road
-    for (int i = 0; i < (int)(FAF_ROAD_WIDTH / FAF_BLOCK_WIDTH); i++) {
-        for (int j = 0; j < (int)(FAF_DIMENSIONS.y / FAF_BLOCK_LENGTH); j++) {
-            surface_info_t *surf_info = faf_surface_init(FAF_ROAD_COEF);
-            body_t *road = shape_init_rectangle(FAF_BLOCK_WIDTH, FAF_BLOCK_LENGTH, FAF_REGULAR_ROAD_COLOR,
-                                                FAF_DEFAULT_DENSITY, surf_info, free);
-            vector_t center = {.x = FAF_SIDE_WIDTH + FAF_BLOCK_WIDTH / 2 + i * FAF_BLOCK_WIDTH,
-                               .y = FAF_BLOCK_LENGTH / 2 + j * FAF_BLOCK_LENGTH};
-            body_set_centroid(road, center);
-            scene_add_body_in_layer(scene, road, FAF_FOREGROUND_LAYER);
-            list_add(collision_bodies, road);
-        }
-    }
+    // Add the ground: the road down the middle, with the level's side surface on either side.
+    // Cars look up the surface under them instead of colliding with it
+    terrain_surface_t side_surface = {.coefficient = side_coef, .color = side_color};
+    terrain_surface_t road_surface = {.coefficient = FAF_ROAD_COEF, .color = FAF_REGULAR_ROAD_COLOR};
+    vector_t cell_size = {.x = FAF_BLOCK_WIDTH, .y = FAF_BLOCK_LENGTH};
+    terrain_t *terrain = terrain_init(FAF_DIMENSIONS, cell_size, side_surface);
+    size_t road = terrain_add_surface(terrain, road_surface);
+    aabb_t road_area = {.min = {.x = FAF_SIDE_WIDTH, .y = 0},
+                        .max = {.x = FAF_SIDE_WIDTH + FAF_ROAD_WIDTH, .y = FAF_DIMENSIONS.y}};
+    terrain_fill(terrain, road_area, road);
+    scene_set_terrain(scene, terrain, FAF_BACKGROUND_LAYER);
 
     // Add stripes on the road
     for (double curr_y = 0; curr_y < 0.995 * FAF_DIMENSIONS.y; curr_y += FAF_ROAD_STRIPE_SPACING) {
         for (size_t i = 1; i < FAF_ROAD_LANES; i++) {
-            faf_object_t *obj_type = malloc(sizeof(faf_object_t));
+            faf_object_t *obj_type = scene_alloc(scene, sizeof(faf_object_t));
             *obj_type = FAF_OTHER_OBJ;
             body_t *stripe = shape_init_rectangle(FAF_ROAD_STRIPE_WIDTH, FAF_ROAD_STRIPE_HEIGHT, 
                                                   FAF_ROAD_STRIPE_COLOR, FAF_DEFAULT_DENSITY,
-                                                  obj_type, free);
+                                                  obj_type, NULL);
             double dist_from_side = (FAF_DIMENSIONS.x - FAF_ROAD_WIDTH) / 2;
             double curr_x = i * FAF_ROAD_WIDTH / FAF_ROAD_LANES + dist_from_side;
             vector_t center = {.x = curr_x, .y = curr_y};
             body_set_centroid(stripe, center);
+            body_make_static(stripe);
             scene_add_body_in_layer(scene, stripe, FAF_FOREGROUND_LAYER);
         }
     }
 
-    // Add the background
-    for (int i = 0; i < (int)(FAF_SIDE_WIDTH / FAF_BLOCK_WIDTH); i++) {
-        for (int j = 0; j < (int)(FAF_DIMENSIONS.y / FAF_BLOCK_LENGTH); j++) {
-            // Left side
-            surface_info_t *surf_l_info = faf_surface_init(side_coef);
-            body_t *background_left = shape_init_rectangle(FAF_BLOCK_WIDTH, FAF_BLOCK_LENGTH, side_color,
-                                                            FAF_DEFAULT_DENSITY, surf_l_info, free);
-            vector_t center_l = {.x = FAF_BLOCK_WIDTH / 2 + i * FAF_BLOCK_WIDTH, .y = FAF_BLOCK_LENGTH / 2 + j * FAF_BLOCK_LENGTH};
-            body_set_centroid(background_left, center_l);
-            scene_add_body_in_layer(scene, background_left, FAF_BACKGROUND_LAYER);
-            list_add(collision_bodies, background_left);
-            // Right side
-            surface_info_t *surf_r_info = faf_surface_init(side_coef);
-            body_t *background_right = shape_init_rectangle(FAF_BLOCK_WIDTH, FAF_BLOCK_LENGTH, side_color,
-                                                            FAF_DEFAULT_DENSITY, surf_r_info, free);
-            vector_t center_r = {.x = FAF_ROAD_WIDTH + FAF_SIDE_WIDTH + FAF_BLOCK_WIDTH / 2 + i * FAF_BLOCK_WIDTH,
-                                .y = FAF_BLOCK_LENGTH / 2 + j * FAF_BLOCK_LENGTH};
-            body_set_centroid(background_right, center_r);
-            scene_add_body_in_layer(scene, background_right, FAF_BACKGROUND_LAYER);
-            list_add(collision_bodies, background_right);
-        }
-    }
-
     // Add finish line
-    faf_object_t *obj_type = malloc(sizeof(faf_object_t));
+    faf_object_t *obj_type = scene_alloc(scene, sizeof(faf_object_t));
     *obj_type = FAF_OTHER_OBJ;
     body_t *finish_line = shape_init_rectangle_with_sprite(FAF_FINISH_LINE_DIMENSIONS.x, FAF_FINISH_LINE_DIMENSIONS.y,
-                                                           FAF_FINISH_LINE_COLOR, FAF_DEFAULT_DENSITY, obj_type, free,
+                                                           FAF_FINISH_LINE_COLOR, FAF_DEFAULT_DENSITY, obj_type, NULL,
                                                            "assets/object/FinishLine.png", FAF_FINISH_LINE_DIMENSIONS);
     vector_t center = {.x = FAF_DIMENSIONS.x / 2, .y = FAF_DIMENSIONS.y - 3 * FAF_FINISH_LINE_DIMENSIONS.y / 2};
     body_set_centroid(finish_line, center);
+    body_make_static(finish_line);
     scene_add_body_in_layer(scene, finish_line, FAF_FOREGROUND_LAYER);
 
     // Add all cars to collision bodies
     for (size_t i = 0; i < list_size(cars); i++) {
         body_t *car = list_get(cars, i);
+        faf_car_set_terrain(car, terrain);
         list_add(collision_bodies, car);
     }
 
-    // Register all cars for collision with bodies
-    double *aux = malloc(sizeof(double));
-    *aux = FAF_ELASTICITY;
+    // Cars and AI colliders are tested against every collision body (including the cars),
+    // and the collision filters drop the pairs that don't interact
+    for (size_t i = 0; i < list_size(collision_bodies); i++) {
+        body_t *body = list_get(collision_bodies, i);
+        faf_set_collision_filter(body);
+        scene_add_to_collision_group(scene, body, FAF_COLLIDABLE_GROUP);
+    }
     for (size_t i = 0; i < list_size(cars); i++) {
-        body_t *car = list_get(cars, i);
-        for (size_t j = 0; j < list_size(collision_bodies); j++) {
-            body_t *other = list_get(collision_bodies, j);
-            create_collision(scene, car, other, (collision_handler_t)faf_car_on_hit, aux, free);
-        }
+        scene_add_to_collision_group(scene, list_get(cars, i), FAF_CAR_GROUP);
     }
-
-    // Register all AI colliders for collision with bodies
     for (size_t i = 0; i < list_size(ai_colliders); i++) {
-        body_t *collider = list_get(ai_colliders, i);
-        for (size_t j = 0; j < list_size(collision_bodies); j++) {
-            body_t *other = list_get(collision_bodies, j);
-            create_collision(scene, collider, other, (collision_handler_t)faf_ai_collider_on_hit, aux, free);
-        }
+        body_t *ai_collider = list_get(ai_colliders, i);
+        body_set_collision_filter(ai_collider, FAF_AI_COLLIDER_CATEGORY,
+                                  faf_collision_mask(FAF_AI_COLLIDER_CATEGORY));
+        scene_add_to_collision_group(scene, ai_collider, FAF_AI_COLLIDER_GROUP);
     }
 
+    create_category_collision(scene, FAF_CAR_GROUP, FAF_COLLIDABLE_GROUP);
+    create_category_collision(scene, FAF_AI_COLLIDER_GROUP, FAF_COLLIDABLE_GROUP);
+    double *aux = scene_alloc(scene, sizeof(double));
+    *aux = FAF_ELASTICITY;
+    create_category_handler(scene, FAF_CAR_CATEGORY, FAF_CAR_CATEGORY,
+                            (collision_handler_t)faf_car_on_hit_car, aux, NULL);
+    create_category_handler(scene, FAF_CAR_CATEGORY, FAF_OBSTACLE_CATEGORY,
+                            (collision_handler_t)faf_car_on_hit_obstacle, NULL, NULL);
+    create_category_handler(scene, FAF_CAR_CATEGORY, FAF_EFFECT_CATEGORY,
+                            (collision_handler_t)faf_car_on_hit_effect, NULL, NULL);
+    create_category_handler(scene, FAF_CAR_CATEGORY, FAF_GAS_CATEGORY,
+                            (collision_handler_t)faf_car_on_hit_gas, NULL, NULL);
+    create_category_handler(scene, FAF_CAR_CATEGORY, FAF_DECORATION_CATEGORY,
+                            (collision_handler_t)faf_car_on_hit_decoration, NULL, NULL);
+    create_category_handler(scene, FAF_AI_COLLIDER_CATEGORY, FAF_CAR_CATEGORY,
+                            (collision_handler_t)faf_ai_collider_on_hit_hazard, NULL, NULL);
+    create_category_handler(scene, FAF_AI_COLLIDER_CATEGORY, FAF_OBSTACLE_CATEGORY,
+                            (collision_handler_t)faf_ai_collider_on_hit_hazard, NULL, NULL);
+    create_category_handler(scene, FAF_AI_COLLIDER_CATEGORY, FAF_EFFECT_CATEGORY,
+                            (collision_handler_t)faf_ai_collider_on_hit_effect, NULL, NULL);
+    create_category_handler(scene, FAF_AI_COLLIDER_CATEGORY, FAF_GAS_CATEGORY,
+                            (collision_handler_t)faf_ai_collider_on_hit_gas, NULL, NULL);
+
     list_free(collision_bodies);
+    scene_end_build(scene);
 
     return scene;
 }
\ No newline at end of file
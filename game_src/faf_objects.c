@@ -43,9 +43,8 @@ typedef struct faf_object_info {
     faf_effect_t effect_type;
 } faf_object_info_t;
 
-faf_object_info_t *make_info(faf_object_t type, faf_effect_t effect_type) {
-    faf_object_info_t *info = malloc(sizeof(faf_object_info_t));
-    assert(info);
+faf_object_info_t *make_info(scene_t *scene, faf_object_t type, faf_effect_t effect_type) {
+    faf_object_info_t *info = scene_alloc(scene, sizeof(faf_object_info_t));
     info->object_type = type;
     info->effect_type = effect_type;
     return info;
@@ -97,13 +96,20 @@ void spawn_and_register_item(scene_t *scene, vector_t scene_dim, list_t *list,
                              double road_width, double obj_radius, const char *filename,
                              faf_object_t obj_type, faf_effect_t effect_type,
                              position_generator_t position_generator, rgb_color_t obj_color) {
-    faf_object_info_t *info = make_info(obj_type, effect_type);
+    faf_object_info_t *info = make_info(scene, obj_type, effect_type);
     body_t *item = shape_init_circle_with_sprite(obj_radius, obj_color, OBJECT_DENSITY,
-                                                 info, (free_func_t)free, filename,
+                                                 info, NULL, filename,
                                                  (vector_t){.x = obj_radius * 2, .y = obj_radius * 2});
     vector_t center = object_position(scene_dim, road_width, obj_radius, list, position_generator);
     body_set_centroid(item, center);
     list_add(list, item);
+    // Gas and effects are picked up by the first car to touch them
+    if (obj_type == FAF_GAS_OBJ || obj_type == FAF_EFFECT_OBJ) {
+        body_make_trigger(item, faf_category_bit(FAF_CAR_CATEGORY));
+    }
+    else {
+        body_make_static(item);
+    }
     scene_add_body_in_layer(scene, item, FAF_OBJECT_LAYER);
 }
 
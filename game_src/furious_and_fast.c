@@ -24,8 +24,8 @@ int main(int argc, char *argv[]) {
     window_t *window = faf_game_start();
 
     while (!sdl_is_done(window)) {
-        double dt = time_since_last_tick();
-        window_tick(window, dt);
+        double frame_time = time_since_last_tick();
+        window_advance(window, frame_time);
         sdl_render_window(window);
         faf_audio_play_music();
     }
@@ -0,0 +1,113 @@
+#ifndef __AABB_TREE_H__
+#define __AABB_TREE_H__
+
+#include "vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * A bounding volume hierarchy over a changing set of axis-aligned boxes,
+ * used to find which boxes overlap a query box without testing all of them.
+ * Unlike a uniform grid, it copes with boxes of very different sizes.
+ *
+ * Each box is a leaf of a binary tree whose inner nodes bound their children.
+ * The tree stores each leaf's box grown by a margin (a "fat" box), and a
+ * box that moves only needs its leaf reinserted once it leaves its fat box,
+ * so slow or still boxes cost nothing from one update to the next.
+ * When a leaf is reinserted, only the boxes of the nodes above it are refit,
+ * and the tree is rebalanced on the way up by rotating its nodes
+ * (as in an AVL tree), so it stays shallow however the boxes move.
+ *
+ * Queries test against the fat boxes, so they can find boxes that are
+ * near the query box without quite overlapping it.
+ */
+typedef struct aabb_tree aabb_tree_t;
+
+/**
+ * Allocates memory for an empty tree.
+ * Asserts that the required memory was allocated.
+ *
+ * @param margin how far each box's fat box extends beyond it on every side;
+ *   must not be negative
+ * @return a pointer to the newly allocated tree
+ */
+aabb_tree_t *aabb_tree_init(double margin);
+
+/**
+ * Releases the memory allocated for a tree.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ */
+void aabb_tree_free(aabb_tree_t *tree);
+
+/**
+ * Removes every box from a tree, keeping its memory for reuse.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ */
+void aabb_tree_clear(aabb_tree_t *tree);
+
+/**
+ * Adds a box to a tree.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param box the box to add
+ * @return the box's proxy, which identifies it in queries and
+ *   aabb_tree_move() and aabb_tree_remove(). The proxies of removed boxes
+ *   are reused, so proxies stay small.
+ */
+size_t aabb_tree_insert(aabb_tree_t *tree, aabb_t box);
+
+/**
+ * Removes a box from a tree.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param proxy the box's proxy, returned from aabb_tree_insert()
+ */
+void aabb_tree_remove(aabb_tree_t *tree, size_t proxy);
+
+/**
+ * Moves a box in a tree. Nothing changes if the box is still within its fat box;
+ * otherwise the box gets a new fat box, stretched along the direction
+ * it is expected to keep moving in, and its leaf is reinserted.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param proxy the box's proxy, returned from aabb_tree_insert()
+ * @param box the box's new position
+ * @param displacement how far the box is expected to move before its next move,
+ *   or VEC_ZERO if not known
+ * @return whether the leaf was reinserted
+ */
+bool aabb_tree_move(aabb_tree_t *tree, size_t proxy, aabb_t box, vector_t displacement);
+
+/**
+ * Gets the fat box a tree stores for one of its boxes.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param proxy the box's proxy, returned from aabb_tree_insert()
+ * @return the fat box, which contains the box
+ */
+aabb_t aabb_tree_get_fat_box(aabb_tree_t *tree, size_t proxy);
+
+/**
+ * Gets the height of a tree, i.e. the number of nodes on its longest path
+ * from the root to a leaf; 0 if it is empty.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @return the height
+ */
+size_t aabb_tree_height(aabb_tree_t *tree);
+
+/**
+ * Finds the boxes in a tree whose fat boxes overlap a given box.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param box the box to search with
+ * @param results set to an array of the proxies of the overlapping boxes,
+ *   in no particular order. The array belongs to the tree and is only valid
+ *   until the tree is next queried or changed.
+ * @return the number of overlapping boxes
+ */
+size_t aabb_tree_query(aabb_tree_t *tree, aabb_t box, const size_t **results);
+
+#endif // #ifndef __AABB_TREE_H__
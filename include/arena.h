@@ -0,0 +1,77 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+
+/**
+ * A region allocator.
+ * Memory is handed out from large blocks by bumping a pointer,
+ * and is only ever released all at once by arena_free().
+ * This makes building thousands of small objects cheap,
+ * and tearing them down a handful of free() calls.
+ */
+typedef struct arena arena_t;
+
+/**
+ * Allocates memory for an empty arena.
+ * Asserts that the required memory was allocated.
+ *
+ * @param block_size the number of bytes to reserve each time the arena runs out;
+ *   larger allocations are given a block of their own
+ * @return a pointer to the newly allocated arena
+ */
+arena_t *arena_init(size_t block_size);
+
+/**
+ * Releases an arena and every allocation made from it.
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ */
+void arena_free(arena_t *arena);
+
+/**
+ * Allocates memory from an arena.
+ * The memory is suitably aligned for any type and lives until arena_free().
+ * Asserts that the required memory was allocated.
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ * @param size the number of bytes to allocate
+ * @return a pointer to the allocated memory
+ */
+void *arena_alloc(arena_t *arena, size_t size);
+
+/**
+ * Returns the total number of bytes handed out by an arena.
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ * @return the number of bytes allocated from the arena
+ */
+size_t arena_bytes_used(arena_t *arena);
+
+/**
+ * Sets the arena that engine objects (polygons, including body shapes)
+ * are allocated from when they are created. NULL means the regular heap.
+ * Objects allocated from an arena must not outlive it.
+ *
+ * @param arena the arena to allocate from, or NULL
+ */
+void arena_set_current(arena_t *arena);
+
+/**
+ * Returns the arena set with arena_set_current().
+ *
+ * @return the current arena, or NULL if allocations go to the heap
+ */
+arena_t *arena_get_current(void);
+
+/**
+ * Allocates memory from an arena, or from the heap if the arena is NULL.
+ * Asserts that the required memory was allocated.
+ *
+ * @param arena an arena returned from arena_init(), or NULL
+ * @param size the number of bytes to allocate
+ * @return a pointer to the allocated memory
+ */
+void *arena_alloc_or_malloc(arena_t *arena, size_t size);
+
+#endif // #ifndef __ARENA_H__
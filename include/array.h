@@ -0,0 +1,129 @@
+#ifndef __ARRAY_H__
+#define __ARRAY_H__
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Generates a growable array that stores values of a single type inline.
+ * Unlike list_t, elements are kept by value (no per-element allocation),
+ * the element type is checked by the compiler, and removals can be done
+ * in O(1) (swap_remove) or in one bulk compaction pass (remove_if).
+ *
+ * ARRAY_DECLARE(widget_array, widget_t) declares the type widget_array_t
+ * and the functions widget_array_init(), widget_array_free(),
+ * widget_array_reserve(), widget_array_size(), widget_array_get(),
+ * widget_array_add(), widget_array_swap_remove(), widget_array_remove_if()
+ * and widget_array_clear().
+ *
+ * Pointers returned by name_get() and name_add() are only valid
+ * until the array next grows.
+ *
+ * @param name the prefix of the generated type and functions
+ * @param type the element type
+ */
+#define ARRAY_DECLARE(name, type)                                               \
+    typedef struct name {                                                       \
+        type *data;                                                             \
+        size_t size;                                                            \
+        size_t capacity;                                                        \
+    } name##_t;                                                                 \
+                                                                                \
+    /* A predicate for name##_remove_if(); may release the element it removes */\
+    typedef bool (*name##_pred_t)(type *elem, void *aux);                       \
+                                                                                \
+    static inline void name##_reserve(name##_t *arr, size_t capacity) {         \
+        assert(arr);                                                            \
+        if (capacity <= arr->capacity) {                                        \
+            return;                                                             \
+        }                                                                       \
+        arr->data = realloc(arr->data, sizeof(type) * capacity);                \
+        assert(arr->data);                                                      \
+        arr->capacity = capacity;                                               \
+    }                                                                           \
+                                                                                \
+    static inline void name##_init(name##_t *arr, size_t initial_size) {        \
+        assert(arr);                                                            \
+        arr->data = NULL;                                                       \
+        arr->size = 0;                                                          \
+        arr->capacity = 0;                                                      \
+        name##_reserve(arr, initial_size);                                      \
+    }                                                                           \
+                                                                                \
+    static inline void name##_free(name##_t *arr) {                             \
+        assert(arr);                                                            \
+        free(arr->data);                                                        \
+        arr->data = NULL;                                                       \
+        arr->size = 0;                                                          \
+        arr->capacity = 0;                                                      \
+    }                                                                           \
+                                                                                \
+    static inline size_t name##_size(name##_t *arr) {                           \
+        assert(arr);                                                            \
+        return arr->size;                                                       \
+    }                                                                           \
+                                                                                \
+    static inline type *name##_get(name##_t *arr, size_t index) {               \
+        assert(arr);                                                            \
+        assert(index < arr->size);                                              \
+        return &arr->data[index];                                               \
+    }                                                                           \
+                                                                                \
+    static inline type *name##_add(name##_t *arr, type value) {                 \
+        assert(arr);                                                            \
+        if (arr->size == arr->capacity) {                                       \
+            name##_reserve(arr, arr->capacity ? 2 * arr->capacity : 1);         \
+        }                                                                       \
+        arr->data[arr->size] = value;                                           \
+        return &arr->data[arr->size++];                                         \
+    }                                                                           \
+                                                                                \
+    /* Removes an element in O(1) by moving the last element into its slot */  \
+    static inline type name##_swap_remove(name##_t *arr, size_t index) {        \
+        assert(arr);                                                            \
+        assert(index < arr->size);                                              \
+        type elem = arr->data[index];                                           \
+        arr->data[index] = arr->data[--arr->size];                              \
+        return elem;                                                            \
+    }                                                                           \
+                                                                                \
+    /* Removes every element matching pred in one stable pass */               \
+    static inline size_t name##_remove_if(name##_t *arr, name##_pred_t pred,    \
+                                          void *aux) {                          \
+        assert(arr);                                                            \
+        assert(pred);                                                           \
+        size_t kept = 0;                                                        \
+        for (size_t i = 0; i < arr->size; i++) {                                \
+            if (!pred(&arr->data[i], aux)) {                                    \
+                if (kept != i) {                                                \
+                    arr->data[kept] = arr->data[i];                             \
+                }                                                               \
+                kept++;                                                         \
+            }                                                                   \
+        }                                                                       \
+        size_t removed = arr->size - kept;                                      \
+        arr->size = kept;                                                       \
+        return removed;                                                         \
+    }                                                                           \
+                                                                                \
+    static inline void name##_clear(name##_t *arr) {                            \
+        assert(arr);                                                            \
+        arr->size = 0;                                                          \
+    }
+
+/**
+ * Iterates over the elements of an array declared with ARRAY_DECLARE().
+ * it is a pointer to the current element.
+ * The array must not grow while it is being iterated over.
+ *
+ * @param type the element type
+ * @param it the name of the iteration variable
+ * @param arr a pointer to the array
+ */
+#define ARRAY_FOR_EACH(type, it, arr) \
+    for (type *it = (arr)->data; it < (arr)->data + (arr)->size; it++)
+
+#endif // #ifndef __ARRAY_H__
@@ -1,19 +1,79 @@
 #ifndef __BODY_H__
 #define __BODY_H__
 
+#include "array.h"
 #include "color.h"
 #include "list.h"
+#include "physics_store.h"
+#include "polygon.h"
 #include "vector.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <SDL2/SDL_image.h>
 
 /**
  * A rigid body constrained to the plane.
  * Implemented as a polygon with uniform density.
+ * The polygon is stored in local space (relative to the centroid, unrotated)
+ * along with a position and angle; world-space vertices are only computed
+ * when they are asked for, and are cached until the body next moves.
  * Bodies can accumulate forces and impulses during each tick.
  */
 typedef struct body body_t;
 
+/**
+ * A reference to a body that can detect when the body has been freed.
+ * Bodies live in a pool and their memory is reused once they are freed;
+ * each reuse bumps the slot's generation, so an old handle stops resolving
+ * instead of silently pointing at a different body.
+ * Store a handle rather than a body_t * when the referenced body may be
+ * removed before the reference is.
+ */
+typedef struct body_handle {
+    uint32_t index;
+    uint32_t generation;
+} body_handle_t;
+
+/**
+ * A handle that never refers to a body.
+ */
+extern const body_handle_t BODY_HANDLE_NULL;
+
+/**
+ * The number of collision categories; categories are 0 to BODY_NUM_CATEGORIES - 1.
+ * A body collides as one category, and its mask has bit c set
+ * for each category c it collides with (see body_set_collision_filter()).
+ */
+extern const size_t BODY_NUM_CATEGORIES;
+
+/**
+ * The category bodies start in.
+ */
+extern const size_t BODY_DEFAULT_CATEGORY;
+
+/**
+ * A mask that collides with every category, which bodies start with.
+ */
+extern const uint32_t BODY_ALL_CATEGORIES;
+
+/**
+ * A growable array of body pointers, e.g. the bodies in one layer of a scene.
+ * See array.h for the generated functions.
+ */
+ARRAY_DECLARE(body_array, body_t *)
+
+/**
+ * The kind of shape a body has, which picks the routine find_body_collision() uses.
+ * Circles and boxes keep their polygon (for drawing, and for colliding with
+ * other polygons), but collide with each other using their radius or half size.
+ */
+typedef enum {
+    BODY_SHAPE_POLYGON,
+    BODY_SHAPE_CIRCLE,
+    // A rectangle, which may be rotated
+    BODY_SHAPE_BOX
+} body_shape_kind_t;
+
 /**
  * A generic function that can be called on a body.
  * 
@@ -26,19 +86,19 @@ typedef void (*body_func_t)(body_t *body, void *arg);
  * Initializes a body without any info.
  * Acts like body_init_with_info() where info and info_freer are NULL.
  * 
- * @param shape a list of vectors describing the initial shape of the body
+ * @param shape a polygon describing the initial shape of the body
  * @param mass the mass of the body (if INFINITY, stops the body from moving)
  * @param color the color of the body, used to draw it on the screen
  * @return a pointer to the newly allocated body
  */
-body_t *body_init(list_t *shape, double mass, rgb_color_t color);
+body_t *body_init(polygon_t *shape, double mass, rgb_color_t color);
 
 /**
  * Allocates memory for a body with the given parameters.
  * The body is initially at rest.
  * Asserts that the mass is positive and that the required memory is allocated.
  *
- * @param shape a list of vectors describing the initial shape of the body
+ * @param shape a polygon describing the initial shape of the body
  * @param mass the mass of the body (if INFINITY, stops the body from moving)
  * @param color the color of the body, used to draw it on the screen
  * @param info additional information to associate with the body,
@@ -46,7 +106,7 @@ body_t *body_init(list_t *shape, double mass, rgb_color_t color);
  * @param info_freer if non-NULL, a function call on the info to free it
  * @return a pointer to the newly allocated body
  */
-body_t *body_init_with_info(list_t *shape, double mass, rgb_color_t color,
+body_t *body_init_with_info(polygon_t *shape, double mass, rgb_color_t color,
                             void *info, free_func_t info_freer);
 
 /**
@@ -54,7 +114,7 @@ body_t *body_init_with_info(list_t *shape, double mass, rgb_color_t color,
  * The body is initially at rest.
  * Asserts that the mass is positive and that the required memory is allocated.
  *
- * @param shape a list of vectors describing the initial shape of the body
+ * @param shape a polygon describing the initial shape of the body
  * @param mass the mass of the body (if INFINITY, stops the body from moving)
  * @param color the color of the body, used to draw it on the screen
  * @param info additional information to associate with the body,
@@ -64,33 +124,116 @@ body_t *body_init_with_info(list_t *shape, double mass, rgb_color_t color,
  * @param dimensions dimensions of the sprite image
  * @return a pointer to the newly allocated body
  */
-body_t *body_init_with_info_and_sprite(list_t *shape, double mass, rgb_color_t color, void *info,
+body_t *body_init_with_info_and_sprite(polygon_t *shape, double mass, rgb_color_t color, void *info,
                                        free_func_t info_freer, const char *filename, vector_t dimensions);
 
 /**
  * Releases the memory allocated for a body.
+ * The body's slot goes back to the body pool to be reused by a later
+ * body_init(), and every handle to it becomes stale.
  *
  * @param body a pointer to a body returned from body_init()
  */
 void body_free(body_t *body);
 
+/**
+ * Gets a handle to a body.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return a handle that resolves to the body until it is freed
+ */
+body_handle_t body_get_handle(body_t *body);
+
+/**
+ * Resolves a handle to a body.
+ *
+ * @param handle a handle returned from body_get_handle()
+ * @return the body, or NULL if it has been freed since the handle was made
+ */
+body_t *body_from_handle(body_handle_t handle);
+
+/**
+ * Moves a body's position, velocity and pending forces into slot idx of a
+ * physics store. Called by physics_store_add(); use that instead.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param store the store the body is being added to
+ * @param idx the body's slot in the store
+ */
+void body_attach_physics_store(body_t *body, physics_store_t *store, size_t idx);
+
+/**
+ * Moves a body's integration state out of its physics store back into the body.
+ * Called by physics_store_remove(); use that instead.
+ *
+ * @param body a pointer to a body in a physics store
+ */
+void body_detach_physics_store(body_t *body);
+
+/**
+ * Gets a body's slot in its physics store.
+ *
+ * @param body a pointer to a body in a physics store
+ * @return the index of the body's state in the store's arrays
+ */
+size_t body_get_physics_index(body_t *body);
+
+/**
+ * Updates a body's slot after its physics store moved its state.
+ *
+ * @param body a pointer to a body in a physics store
+ * @param idx the new index of the body's state in the store's arrays
+ */
+void body_set_physics_index(body_t *body, size_t idx);
+
 /**
  * Gets the current shape of a body.
- * Returns a newly allocated vector list, which must be list_free()d.
+ * Returns a newly allocated polygon, which must be polygon_free()d.
  *
  * @param body a pointer to a body returned from body_init()
  * @return the polygon describing the body's current position
  */
-list_t *body_get_shape(body_t *body);
+polygon_t *body_get_shape(body_t *body);
 
 /**
  * Gets the current shape of a body.
- * Returns a reference to the body's polygon.
+ * Returns a reference to the body's cached world-space polygon,
+ * recomputing it first if the body has moved or rotated since the last call.
+ * The reference must not be modified and is only up to date
+ * until the body next moves or rotates.
  *
  * @param body a pointer to a body returned from body_init()
  * @return the polygon describing the body's current position
  */
-list_t *body_get_shape_nocpy(body_t *body);
+polygon_t *body_get_shape_nocpy(body_t *body);
+
+/**
+ * Gets a unit vector perpendicular to each edge of a body's current shape
+ * (see polygon_edge_normals()).
+ * The normals are cached and only recomputed after the body rotates.
+ * DOES NOT create a copy; the polygon must not be modified or freed.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the edge normals of the body's current shape
+ */
+polygon_t *body_get_normals_nocpy(body_t *body);
+
+/**
+ * Gets the axis-aligned bounding box of a body's current shape.
+ * Cached along with the body's world-space shape.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the smallest box containing the body
+ */
+aabb_t body_get_aabb(body_t *body);
+
+/**
+ * Gets the area of a body's shape, computed once when the body is created.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the area of the body
+ */
+double body_get_area(body_t *body);
 
 /**
  * Gets the current center of mass of a body.
@@ -151,6 +294,42 @@ double body_get_rotation(body_t *body);
  */
 double body_get_bounding_radius(body_t *body);
 
+/**
+ * Gets the kind of shape a body has. Bodies are polygons
+ * unless made circles or boxes with body_make_circle() or body_make_box().
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the kind of the body's shape
+ */
+body_shape_kind_t body_get_shape_kind(body_t *body);
+
+/**
+ * Gets the radius of a circle body.
+ * Asserts that the body is a circle.
+ *
+ * @param body a pointer to a body made a circle with body_make_circle()
+ * @return the circle's radius
+ */
+double body_get_circle_radius(body_t *body);
+
+/**
+ * Gets half the width and height of a box body, before rotation.
+ * Asserts that the body is a box.
+ *
+ * @param body a pointer to a body made a box with body_make_box()
+ * @return half the box's width and height
+ */
+vector_t body_get_box_half_size(body_t *body);
+
+/**
+ * Gets the direction of a body's unrotated x axis, i.e. the unit vector
+ * at the body's rotation. Cached until the body rotates.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the unit vector (cos(rotation), sin(rotation))
+ */
+vector_t body_get_orientation(body_t *body);
+
 /**
  * Returns the SDL_Surface of the sprite visual attached to the body.
  *
@@ -272,6 +451,43 @@ vector_t body_calculate_impulse(body_t *body1, body_t *body2, vector_t axis, dou
  */
 void body_tick(body_t *body, double dt);
 
+/**
+ * Calls every tick function registered on a body, in registration order.
+ * body_tick() does this after updating the velocity and before moving the body;
+ * scenes that integrate their bodies in bulk call it between those passes.
+ *
+ * @param body the body to run the tick functions of
+ * @param dt the number of seconds elapsed since the last tick
+ */
+void body_run_tick_funcs(body_t *body, double dt);
+
+/**
+ * Records a body's current position and rotation as its previous state.
+ * scene_tick() calls this on every body before simulating,
+ * so renderers can draw bodies between their last two states.
+ *
+ * @param body a pointer to a body returned from body_init()
+ */
+void body_save_previous_state(body_t *body);
+
+/**
+ * Blends a body's centroid between its previous and current state.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param alpha how far to blend, from 0 (previous state) to 1 (current state)
+ * @return the blended centroid
+ */
+vector_t body_get_interpolated_centroid(body_t *body, double alpha);
+
+/**
+ * Blends a body's rotation between its previous and current state.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param alpha how far to blend, from 0 (previous state) to 1 (current state)
+ * @return the blended rotation
+ */
+double body_get_interpolated_rotation(body_t *body, double alpha);
+
 /**
  * Returns if a body appears on the screen bounded by the input vectors.
  *
@@ -310,6 +526,7 @@ bool body_are_overlapping(body_t *body1, body_t *body2);
 /**
  * Marks a body for removal--future calls to body_is_removed() will return true.
  * Does not free the body.
+ * If the body has a removal queue, appends the body to it.
  * If the body is already marked for removal, does nothing.
  *
  * @param body the body to mark for removal
@@ -326,4 +543,144 @@ void body_remove(body_t *body);
  */
 bool body_is_removed(body_t *body);
 
+/**
+ * Sets the array body_remove() appends the body to,
+ * so the body's owner can find removed bodies without checking all of them.
+ * Called by scene_add_body_in_layer().
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param queue the array to append the body to when it is removed, or NULL
+ */
+void body_set_removal_queue(body_t *body, body_array_t *queue);
+
+/**
+ * Sets the array a static body is appended to when it is moved
+ * with body_set_centroid() or body_set_rotation(),
+ * so the body's owner can re-index static bodies only when they move.
+ * Called by scene_add_body_in_layer() and scene_add_to_collision_group().
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param queue the array to append the body to when it is moved, or NULL
+ */
+void body_set_move_queue(body_t *body, body_array_t *queue);
+
+/**
+ * Lets the next move of a static body append it to its move queue again.
+ * Until then, moving the body does not append it a second time.
+ * Called by the queue's owner once it has handled the queued moves.
+ *
+ * @param body a pointer to a body returned from body_init()
+ */
+void body_clear_move_queued(body_t *body);
+
+/**
+ * Makes a body static: immovable, with infinite mass.
+ * Scenes never integrate static bodies or run their tick functions,
+ * and collision rules never pair two static bodies.
+ * Static bodies can still be moved with body_set_centroid() and body_set_rotation().
+ * Must be called before the body is added to a scene.
+ *
+ * @param body a pointer to a body returned from body_init()
+ */
+void body_make_static(body_t *body);
+
+/**
+ * Sets which category a body collides as and which categories it collides with.
+ * Collision rules skip a pair unless each body's mask has the other's category bit,
+ * so pairs that can never interact are not tested at all.
+ * Takes effect from the next tick.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param category the body's category, less than BODY_NUM_CATEGORIES
+ * @param mask the categories the body collides with, bit c for category c
+ */
+void body_set_collision_filter(body_t *body, size_t category, uint32_t mask);
+
+/**
+ * Gets the category a body collides as.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's category, BODY_DEFAULT_CATEGORY unless it was set
+ */
+size_t body_get_collision_category(body_t *body);
+
+/**
+ * Gets the categories a body collides with.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's mask, bit c for category c
+ */
+uint32_t body_get_collision_mask(body_t *body);
+
+/**
+ * Returns whether two bodies' collision filters let them collide,
+ * i.e. whether each one's mask has the other's category bit.
+ *
+ * @param body1 a pointer to a body returned from body_init()
+ * @param body2 a pointer to another body returned from body_init()
+ * @return whether the bodies can collide
+ */
+bool body_can_collide(body_t *body1, body_t *body2);
+
+/**
+ * Returns whether a body has been made static with body_make_static().
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return whether the body is static
+ */
+bool body_is_static(body_t *body);
+
+/**
+ * Makes a circle a trigger: a pickup or sensor zone that other bodies pass through.
+ * A trigger is static (see body_make_static()), so it has no mass to respond with
+ * and is never integrated. Collision rules only report a trigger's contacts when
+ * they start, never while they stay or when they end.
+ * The first body of a category in retire_mask to touch the trigger is the only one
+ * whose contact with it is reported, and the scene removes the trigger once that
+ * contact has been handled. Bodies of other categories are reported as usual
+ * and don't use the trigger up.
+ * Must be called before the body is added to a scene.
+ *
+ * @param body a pointer to a body made a circle with body_make_circle()
+ * @param retire_mask the categories that use the trigger up, bit c for category c
+ */
+void body_make_trigger(body_t *body, uint32_t retire_mask);
+
+/**
+ * Returns whether a body has been made a trigger with body_make_trigger().
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return whether the body is a trigger
+ */
+bool body_is_trigger(body_t *body);
+
+/**
+ * Returns whether a body uses up a trigger when it touches it,
+ * i.e. whether the body's category is in the trigger's retire mask.
+ *
+ * @param trigger a pointer to a body made a trigger with body_make_trigger()
+ * @param body a pointer to another body returned from body_init()
+ * @return whether body retires trigger
+ */
+bool body_retires_trigger(body_t *trigger, body_t *body);
+
+/**
+ * Marks a body as a circle centered on its centroid, so it collides as a true circle
+ * rather than as its polygon. Its bounding box becomes the circle's.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param radius the radius of the circle
+ */
+void body_make_circle(body_t *body, double radius);
+
+/**
+ * Marks a body as a box centered on its centroid and aligned with its rotation,
+ * so it collides as a box rather than as a general polygon.
+ * The body's polygon should be that rectangle.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param half_size half the box's width and height, before rotation
+ */
+void body_make_box(body_t *body, vector_t half_size);
+
 #endif // #ifndef __BODY_H__
\ No newline at end of file
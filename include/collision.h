@@ -1,9 +1,11 @@
 #ifndef __COLLISION_H__
 #define __COLLISION_H__
 
-#include "list.h"
+#include "body.h"
+#include "polygon.h"
 #include "vector.h"
 #include <stdbool.h>
+#include <stddef.h>
 
 /**
  * Represents the status of a collision between two shapes.
@@ -21,16 +23,124 @@ typedef struct collision_info {
 } collision_info_t;
 
 /**
- * Computes the status of the collision between two convex polygons.
- * The shapes are given as lists of vertices in counterclockwise order.
+ * Remembers which axis last separated a pair of bodies,
+ * so the next test of the pair can try that axis first.
+ * Bodies that are apart usually stay apart along the same axis for many ticks,
+ * so a remembered axis often rejects the pair with a single projection.
+ */
+typedef struct separating_axis {
+    // Which of the pair's axes, in the order the pair's test visits them;
+    // SIZE_MAX if none is remembered
+    size_t index;
+} separating_axis_t;
+
+/**
+ * A hint that remembers no axis, for a pair that has not been tested yet.
+ */
+extern const separating_axis_t SEPARATING_AXIS_NONE;
+
+/**
+ * Counts of how find_body_collision_cached() tests went,
+ * since the program started or collision_reset_stats() was called.
+ * Each thread keeps its own counts.
+ */
+typedef struct collision_stats {
+    // Pairs tested
+    size_t tests;
+    // Pairs rejected because their bounding boxes don't overlap
+    size_t box_rejections;
+    // Pairs tested with a remembered separating axis
+    size_t warm_starts;
+    // Pairs rejected by the remembered axis alone
+    size_t warm_hits;
+} collision_stats_t;
+
+/**
+ * Computes the status of the collision between two convex polygons, without allocating.
+ * The shapes are given as packed vertex arrays in counterclockwise order.
  * There is an edge between each pair of consecutive vertices,
  * and one between the first vertex and the last vertex.
+ * Shapes whose bounding boxes do not overlap are rejected before any axis is tested.
  *
  * @param shape1 the first shape
  * @param shape2 the second shape
- * @return whether the shapes are colliding, and if so, the collision axis.
- * The axis should be a unit vector pointing from shape1 towards shape2.
+ * @param out set to the collision axis and overlap if the shapes are colliding;
+ *   otherwise its contents are undefined.
+ *   The axis is a unit vector pointing from shape1 towards shape2.
+ * @return whether the shapes are colliding
+ */
+bool find_collision_into(polygon_t *shape1, polygon_t *shape2, collision_info_t *out);
+
+/**
+ * Same as find_collision_into(), but returns the result in newly allocated memory.
+ *
+ * @param shape1 the first shape
+ * @param shape2 the second shape
+ * @return NULL if the shapes are not colliding; otherwise the collision info,
+ *   which the caller must free
+ */
+collision_info_t *find_collision(polygon_t *shape1, polygon_t *shape2);
+
+/**
+ * Computes the status of the collision between two bodies.
+ * Circles and boxes (see body_shape_kind_t) are tested against each other
+ * directly, from their radii, half sizes and orientations.
+ * Any other pair is tested like find_collision_into() on the bodies' polygons,
+ * using the edge normals and centroids each body caches.
+ * Never allocates, and rejects bodies whose cached bounding boxes do not overlap
+ * before anything else.
+ *
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param out set to the collision axis and overlap if the bodies are colliding;
+ *   otherwise its contents are undefined.
+ *   The axis is a unit vector pointing from body1 towards body2.
+ * @return whether the bodies are colliding
+ */
+bool find_body_collision_into(body_t *body1, body_t *body2, collision_info_t *out);
+
+/**
+ * Same as find_body_collision_into(), but tries the axis that last separated
+ * the bodies first, and remembers the separating axis (if any) for next time.
+ * The same pair must always be passed in the same order with the same hint.
+ *
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param hint the pair's remembered axis; start it at SEPARATING_AXIS_NONE
+ * @param out set to the collision axis and overlap if the bodies are colliding
+ * @return whether the bodies are colliding
+ */
+bool find_body_collision_cached(body_t *body1, body_t *body2, separating_axis_t *hint,
+                                collision_info_t *out);
+
+/**
+ * Same as find_body_collision_into(), but returns the result in newly allocated memory.
+ *
+ * @param body1 the first body
+ * @param body2 the second body
+ * @return NULL if the bodies are not colliding; otherwise the collision info,
+ *   which the caller must free
+ */
+collision_info_t *find_body_collision(body_t *body1, body_t *body2);
+
+/**
+ * Gets the counts of how find_body_collision_cached() tests went on the calling thread.
+ *
+ * @return the counts since the program started or the last reset
+ */
+collision_stats_t collision_get_stats(void);
+
+/**
+ * Sets the calling thread's counts returned by collision_get_stats() back to 0.
+ */
+void collision_reset_stats(void);
+
+/**
+ * Adds counts to the calling thread's, e.g. to collect the counts
+ * of tests run on other threads on their behalf.
+ *
+ * @param stats the counts to add
  */
-collision_info_t *find_collision(list_t *shape1, list_t *shape2);
+void collision_add_stats(collision_stats_t stats);
 
 #endif // #ifndef __COLLISION_H__
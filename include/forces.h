@@ -1,6 +1,7 @@
 #ifndef __FORCES_H__
 #define __FORCES_H__
 
+#include "gravity_field.h"
 #include "scene.h"
 
 /**
@@ -15,9 +16,8 @@ typedef void (*collision_handler_t)
     (body_t *body1, body_t *body2, vector_t axis, void *aux);
 
 /**
- * Adds a force creator to a scene that applies gravity between two bodies.
- * The force creator will be called each tick
- * to compute the Newtonian gravitational force between the bodies.
+ * Adds Newtonian gravity between two bodies to a scene (see scene_add_gravity()).
+ * The force is computed each tick from the distance between the bodies.
  * See https://en.wikipedia.org/wiki/Newton%27s_law_of_universal_gravitation#Vector_form.
  * The force should not be applied when the bodies are very close,
  * because its magnitude blows up as the distance between the bodies goes to 0.
@@ -30,9 +30,8 @@ typedef void (*collision_handler_t)
 void create_newtonian_gravity(scene_t *scene, double G, body_t *body1, body_t *body2);
 
 /**
- * Adds a force creator to a scene that acts like a spring between two bodies.
- * The force creator will be called each tick
- * to compute the Hooke's-Law spring force between the bodies.
+ * Adds a spring between two bodies to a scene (see scene_add_spring()).
+ * The Hooke's-Law spring force is computed each tick.
  * See https://en.wikipedia.org/wiki/Hooke%27s_law.
  *
  * @param scene the scene containing the bodies
@@ -43,9 +42,25 @@ void create_newtonian_gravity(scene_t *scene, double G, body_t *body1, body_t *b
 void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2);
 
 /**
- * Adds a force creator to a scene that applies a drag force on a body.
- * The force creator will be called each tick
- * to compute the drag force on the body proportional to its velocity.
+ * Adds a gravity field to a scene: Newtonian gravity between every pair
+ * of the bodies added to it with gravity_field_add_body(), approximated with
+ * a quadtree so large numbers of bodies stay cheap (see gravity_field.h).
+ * Prefer this to create_newtonian_gravity() on every pair once there are
+ * more than a few dozen bodies. As with create_newtonian_gravity(), no force
+ * is applied between bodies that are very close.
+ * The field is applied each tick and freed with the scene.
+ *
+ * @param scene the scene containing the bodies
+ * @param G the gravitational proportionality constant
+ * @param theta the accuracy parameter, around 0.5 for most uses,
+ *   or 0 to sum every pair exactly
+ * @return the field, to add bodies to
+ */
+gravity_field_t *create_gravity_field(scene_t *scene, double G, double theta);
+
+/**
+ * Adds a drag force on a body to a scene (see scene_add_drag()).
+ * The force is computed each tick, proportional to the body's velocity.
  * The force points opposite the body's velocity.
  *
  * @param scene the scene containing the bodies
@@ -55,6 +70,16 @@ void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2);
  */
 void create_drag(scene_t *scene, double gamma, body_t *body);
 
+/**
+ * Adds a constant acceleration on a body to a scene, e.g. a uniform gravity field
+ * (see scene_add_acceleration()). The force is the body's mass times the acceleration.
+ *
+ * @param scene the scene containing the body
+ * @param acceleration the acceleration
+ * @param body the body to accelerate
+ */
+void create_constant_acceleration(scene_t *scene, vector_t acceleration, body_t *body);
+
 /**
  * Adds a force creator to a scene that calls a given collision handler
  * function each time two bodies collide.
@@ -69,10 +94,62 @@ void create_drag(scene_t *scene, double gamma, body_t *body);
  * @param handler a function to call whenever the bodies collide
  * @param aux an auxiliary value to pass to the handler
  * @param freer if non-NULL, a function to call in order to free aux
+ *   when the collision is removed. Pass NULL for aux values that are shared
+ *   between collisions or allocated with scene_alloc().
  */
 void create_collision(scene_t *scene, body_t *body1, body_t *body2,
                       collision_handler_t handler, void *aux, free_func_t freer);
 
+/**
+ * Registers a collision handler between every body of one collision group
+ * and every body of another (see scene_add_to_collision_group()).
+ * Behaves like calling create_collision() on each pair, but only pairs that
+ * are near each other are tested, so the groups can be large.
+ * Bodies added to the groups later are included automatically.
+ * The handler is called after every collision group pair has been tested
+ * (see scene_add_collision_rule()), not in the middle of the tests.
+ *
+ * @param scene the scene containing the bodies
+ * @param group1 the group of the bodies passed first to the handler
+ * @param group2 the group of the bodies passed second to the handler
+ * @param handler a function to call whenever two of the bodies collide
+ * @param aux an auxiliary value to pass to the handler
+ * @param freer if non-NULL, a function to call in order to free aux
+ *   when the scene is freed
+ */
+void create_group_collision(scene_t *scene, size_t group1, size_t group2,
+                            collision_handler_t handler, void *aux, free_func_t freer);
+
+/**
+ * Tests every body of one collision group against every body of another,
+ * like create_group_collision(), but hands each collision to the handler
+ * registered for the bodies' categories with create_category_handler()
+ * (see body_set_collision_filter()). Pairs whose filters rule each other out
+ * are never tested, and collisions between categories with no handler are ignored.
+ *
+ * @param scene the scene containing the bodies
+ * @param group1 the group of the first body in each pair
+ * @param group2 the group of the second body in each pair
+ */
+void create_category_collision(scene_t *scene, size_t group1, size_t group2);
+
+/**
+ * Registers a collision handler for bodies of two categories,
+ * called whenever create_category_collision() finds two such bodies colliding.
+ * The body of category1 is always passed first, with the axis pointing to match.
+ * Each pair of categories can only be given one handler.
+ *
+ * @param scene the scene containing the bodies
+ * @param category1 the category of the bodies passed first to the handler
+ * @param category2 the category of the bodies passed second to the handler
+ * @param handler a function to call whenever two such bodies collide
+ * @param aux an auxiliary value to pass to the handler
+ * @param freer if non-NULL, a function to call in order to free aux
+ *   when the scene is freed
+ */
+void create_category_handler(scene_t *scene, size_t category1, size_t category2,
+                             collision_handler_t handler, void *aux, free_func_t freer);
+
 /**
  * Adds a force creator to a scene that destroys two bodies when they collide.
  * The bodies should be destroyed by calling body_remove().
@@ -0,0 +1,75 @@
+#ifndef __GRAVITY_FIELD_H__
+#define __GRAVITY_FIELD_H__
+
+#include "body.h"
+#include <stddef.h>
+
+/**
+ * Newtonian gravity between every pair of a set of bodies, without a force
+ * record per pair. Each time the field is applied, the bodies are sorted into
+ * a quadtree holding the total mass and center of mass of each cell, and each
+ * body is pulled by distant cells as if they were single bodies (Barnes-Hut).
+ * A cell counts as distant when its width is less than theta times its distance,
+ * so smaller values of theta are more accurate and slower; around 0.5 is typical.
+ * That takes O(N log N) time rather than O(N^2).
+ *
+ * A theta of 0 sums every pair exactly instead, for checking the approximation.
+ *
+ * The field holds handles to its bodies (see body_handle_t), so bodies that
+ * have been freed are dropped without having to be taken out of the field.
+ */
+typedef struct gravity_field gravity_field_t;
+
+/**
+ * Allocates memory for a field with no bodies.
+ * Asserts that the required memory was allocated.
+ *
+ * @param G the gravitational constant
+ * @param min_distance the distance within which no force is applied,
+ *   since the force blows up as bodies get close
+ * @param theta the accuracy parameter, or 0 to sum every pair exactly
+ * @return a pointer to the newly allocated field
+ */
+gravity_field_t *gravity_field_init(double G, double min_distance, double theta);
+
+/**
+ * Releases the memory allocated for a field. The bodies are not freed.
+ *
+ * @param field a pointer to a field returned from gravity_field_init()
+ */
+void gravity_field_free(gravity_field_t *field);
+
+/**
+ * Adds a body to a field, so it pulls and is pulled by the field's other bodies.
+ *
+ * @param field a pointer to a field returned from gravity_field_init()
+ * @param body the body to add; must not be static (its mass must be finite)
+ */
+void gravity_field_add_body(gravity_field_t *field, body_t *body);
+
+/**
+ * Gets the number of bodies in a field, including any that have been freed
+ * since the field was last applied.
+ *
+ * @param field a pointer to a field returned from gravity_field_init()
+ * @return the number of bodies
+ */
+size_t gravity_field_num_bodies(gravity_field_t *field);
+
+/**
+ * Changes a field's accuracy parameter.
+ *
+ * @param field a pointer to a field returned from gravity_field_init()
+ * @param theta the accuracy parameter, or 0 to sum every pair exactly
+ */
+void gravity_field_set_theta(gravity_field_t *field, double theta);
+
+/**
+ * Adds the gravitational force on each of a field's bodies to the body
+ * (see body_add_force()).
+ *
+ * @param field a pointer to a field returned from gravity_field_init()
+ */
+void gravity_field_apply(gravity_field_t *field);
+
+#endif // #ifndef __GRAVITY_FIELD_H__
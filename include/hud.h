@@ -113,6 +113,7 @@ void hud_free(hud_t *hud);
 
 /**
  * Adds a widget to a HUD.
+ * The HUD takes ownership of the widget and frees it in hud_free().
  *
  * @param hud a pointer returned from hud_init()
  * @param widget the widget to add.
@@ -127,12 +128,21 @@ void hud_add_widget(hud_t *hud, widget_t *widget);
 void hud_tick(hud_t *hud);
 
 /**
- * Returns a reference to the HUD's widgets.
+ * Returns the number of widgets in a HUD.
  *
  * @param hud a pointer returned from hud_init()
- * @return a reference to the list of widgets for the hud
+ * @return the number of widgets added with hud_add_widget()
  */
-list_t *hud_get_widgets(hud_t *hud);
+size_t hud_num_widgets(hud_t *hud);
+
+/**
+ * Returns a reference to a widget in a HUD.
+ *
+ * @param hud a pointer returned from hud_init()
+ * @param idx the widget to get in [0, hud_num_widgets())
+ * @return a reference to the widget
+ */
+widget_t *hud_get_widget(hud_t *hud, size_t idx);
 
 /**
  * Returns the auxiliary value of the HUD.
@@ -0,0 +1,94 @@
+#ifndef __PHYSICS_STORE_H__
+#define __PHYSICS_STORE_H__
+
+#include "vector.h"
+#include <stddef.h>
+
+struct body;
+
+/**
+ * The integration state of a scene's bodies, stored as parallel arrays
+ * (structure of arrays) instead of inside each body_t.
+ * Integrating a tick is then a linear pass over contiguous doubles
+ * that the compiler can vectorize, and never touches the bodies' cold data
+ * (sprites, info, tick functions).
+ *
+ * A body attached to a store reads and writes its position, velocity and
+ * pending forces through the store, so body_t * keeps working as before.
+ * physics_store_t is defined here so body.c can index the arrays directly.
+ */
+typedef struct physics_store {
+    size_t size;
+    size_t capacity;
+    double *pos_x;
+    double *pos_y;
+    double *vel_x;
+    double *vel_y;
+    // 0 for bodies with infinite mass
+    double *inv_mass;
+    double *force_x;
+    double *force_y;
+    double *impulse_x;
+    double *impulse_y;
+    // The displacement computed by the velocity pass, applied by the position pass
+    double *step_x;
+    double *step_y;
+    // The body owning each slot
+    struct body **bodies;
+} physics_store_t;
+
+/**
+ * Allocates memory for an empty physics store.
+ * Asserts that the required memory was allocated.
+ *
+ * @param initial_size the number of bodies to allocate space for
+ * @return a pointer to the newly allocated store
+ */
+physics_store_t *physics_store_init(size_t initial_size);
+
+/**
+ * Releases the memory allocated for a physics store.
+ * Does not free the bodies in it.
+ *
+ * @param store a pointer to a store returned from physics_store_init()
+ */
+void physics_store_free(physics_store_t *store);
+
+/**
+ * Moves a body's integration state into a store.
+ * From then on the body's accessors read and write the store.
+ *
+ * @param store a pointer to a store returned from physics_store_init()
+ * @param body the body to add; must not already be in a store
+ */
+void physics_store_add(physics_store_t *store, struct body *body);
+
+/**
+ * Moves a body's integration state back into the body
+ * and removes it from its store in O(1) (the last slot takes its place).
+ *
+ * @param store the store the body was added to
+ * @param body the body to remove
+ */
+void physics_store_remove(physics_store_t *store, struct body *body);
+
+/**
+ * The first integration pass of a tick: applies the pending forces and
+ * impulses to the velocities, clears them, and computes each body's
+ * displacement from its average velocity over the tick.
+ * Matches the velocity half of body_tick().
+ *
+ * @param store a pointer to a store returned from physics_store_init()
+ * @param dt the time elapsed since the last tick, in seconds
+ */
+void physics_store_integrate_velocities(physics_store_t *store, double dt);
+
+/**
+ * The last integration pass of a tick: moves every body
+ * by the displacement computed in physics_store_integrate_velocities().
+ *
+ * @param store a pointer to a store returned from physics_store_init()
+ */
+void physics_store_integrate_positions(physics_store_t *store);
+
+#endif // #ifndef __PHYSICS_STORE_H__
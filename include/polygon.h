@@ -1,50 +1,147 @@
 #ifndef __POLYGON_H__
 #define __POLYGON_H__
 
-#include "list.h"
+#include "arena.h"
 #include "vector.h"
 #include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * A polygon stored as a packed array of vertices.
+ * The x and y coordinates live in two contiguous arrays (structure of arrays),
+ * so loops over the vertices walk memory linearly instead of chasing
+ * a pointer per vertex.
+ * polygon_t is defined here instead of polygon.c so hot loops in other
+ * modules (collision, rendering) can index the coordinate arrays directly.
+ * The vertices are listed in counterclockwise order.
+ */
+typedef struct polygon {
+    size_t num_vertices;
+    size_t capacity;
+    double *x;
+    double *y;
+    // The arena the polygon was allocated from, or NULL for the heap
+    arena_t *arena;
+} polygon_t;
+
+/**
+ * Allocates memory for a polygon with space for the given number of vertices.
+ * The polygon is initially empty.
+ * The memory comes from the arena set with arena_set_current(), if any.
+ * Asserts that the required memory was allocated.
+ *
+ * @param initial_size the number of vertices to allocate space for
+ * @return a pointer to the newly allocated polygon
+ */
+polygon_t *polygon_init(size_t initial_size);
+
+/**
+ * Releases the memory allocated for a polygon.
+ * Does nothing for polygons allocated from an arena;
+ * their memory is released along with the arena.
+ *
+ * @param polygon a pointer to a polygon returned from polygon_init()
+ */
+void polygon_free(polygon_t *polygon);
+
+/**
+ * Allocates a new polygon with the same vertices as the given polygon.
+ *
+ * @param polygon the polygon to copy
+ * @return a pointer to the newly allocated copy
+ */
+polygon_t *polygon_copy(polygon_t *polygon);
+
+/**
+ * Gets the number of vertices in a polygon.
+ *
+ * @param polygon a pointer to a polygon returned from polygon_init()
+ * @return the number of vertices in the polygon
+ */
+size_t polygon_num_vertices(polygon_t *polygon);
+
+/**
+ * Gets the vertex at a given index in a polygon.
+ * Asserts that the index is valid.
+ *
+ * @param polygon a pointer to a polygon returned from polygon_init()
+ * @param index an index in the polygon (the first vertex is at 0)
+ * @return the vertex at the given index
+ */
+vector_t polygon_get_vertex(polygon_t *polygon, size_t index);
+
+/**
+ * Sets the vertex at a given index in a polygon.
+ * Asserts that the index is valid.
+ *
+ * @param polygon a pointer to a polygon returned from polygon_init()
+ * @param index an index in the polygon (the first vertex is at 0)
+ * @param vertex the new position of the vertex
+ */
+void polygon_set_vertex(polygon_t *polygon, size_t index, vector_t vertex);
+
+/**
+ * Appends a vertex to the end of a polygon.
+ * If the polygon is filled to capacity, resizes it to fit more vertices
+ * and asserts that the resize succeeded.
+ *
+ * @param polygon a pointer to a polygon returned from polygon_init()
+ * @param vertex the vertex to add
+ */
+void polygon_add_vertex(polygon_t *polygon, vector_t vertex);
 
 /**
  * Computes the area of a polygon.
  * See https://en.wikipedia.org/wiki/Shoelace_formula#Statement.
  *
- * @param polygon the list of vertices that make up the polygon,
+ * @param polygon the vertices that make up the polygon,
  * listed in a counterclockwise direction. There is an edge between
  * each pair of consecutive vertices, plus one between the first and last.
  * @return the area of the polygon
  */
-double polygon_area(list_t *polygon);
+double polygon_area(polygon_t *polygon);
 
 /**
  * Computes the center of mass of a polygon.
  * See https://en.wikipedia.org/wiki/Centroid#Of_a_polygon.
  *
- * @param polygon the list of vertices that make up the polygon,
+ * @param polygon the vertices that make up the polygon,
  * listed in a counterclockwise direction. There is an edge between
  * each pair of consecutive vertices, plus one between the first and last.
  * @return the centroid of the polygon
  */
-vector_t polygon_centroid(list_t *polygon);
+vector_t polygon_centroid(polygon_t *polygon);
+
+/**
+ * Computes a unit vector perpendicular to each edge of a polygon.
+ * Entry i is perpendicular to the edge from vertex i to vertex i + 1
+ * (wrapping around to vertex 0).
+ * These are the separating axes tested by find_collision().
+ *
+ * @param polygon the vertices that make up the polygon
+ * @param normals a polygon to overwrite with the normals
+ *   (its "vertices" are directions, not points)
+ */
+void polygon_edge_normals(polygon_t *polygon, polygon_t *normals);
 
 /**
  * Translates all vertices in a polygon by a given vector.
  * Note: mutates the original polygon.
  *
- * @param polygon the list of vertices that make up the polygon
+ * @param polygon the vertices that make up the polygon
  * @param translation the vector to add to each vertex's position
  */
-void polygon_translate(list_t *polygon, vector_t translation);
+void polygon_translate(polygon_t *polygon, vector_t translation);
 
 /**
  * Rotates vertices in a polygon by a given angle about a given point.
  * Note: mutates the original polygon.
  *
- * @param polygon the list of vertices that make up the polygon
+ * @param polygon the vertices that make up the polygon
  * @param angle the angle to rotate the polygon, in radians.
  * A positive angle means counterclockwise.
  * @param point the point to rotate around
  */
-void polygon_rotate(list_t *polygon, double angle, vector_t point);
+void polygon_rotate(polygon_t *polygon, double angle, vector_t point);
 
 #endif // #ifndef __POLYGON_H__
@@ -2,7 +2,9 @@
 #define __SCENE_H__
 
 #include "body.h"
+#include "collision.h"
 #include "list.h"
+#include "terrain.h"
 #include "vector.h"
 
 /**
@@ -12,6 +14,47 @@
  */
 typedef struct scene scene_t;
 
+/**
+ * The ways a scene can find the pairs of bodies its collision rules are called on
+ * (see scene_add_collision_rule()). All of them find the same pairs,
+ * in the same order; they differ only in speed.
+ */
+typedef enum {
+    // A uniform grid over the scene, rebuilt every tick
+    SCENE_BROADPHASE_GRID,
+    // A list of box ends sorted along y, kept sorted from tick to tick (see sweep_prune.h)
+    SCENE_BROADPHASE_SWEEP_PRUNE,
+    // A bounding volume tree per group, whose boxes only move when a body leaves
+    // the fattened box it was last put in (see aabb_tree.h); copes with bodies
+    // of very different sizes, like a whole track next to small pickups
+    SCENE_BROADPHASE_AABB_TREE,
+    // Every pair's bounding boxes are compared; for reference and benchmarks
+    SCENE_BROADPHASE_BRUTE_FORCE
+} scene_broadphase_t;
+
+/**
+ * Options for how a scene stores and simulates its bodies.
+ */
+typedef struct scene_options {
+    // Keep the bodies' positions, velocities and pending forces in
+    // structure-of-arrays storage owned by the scene (see physics_store.h),
+    // so integrating a tick is a linear pass instead of a walk over bodies.
+    // Tick functions then run after every body's velocity is updated
+    // and before any body moves. Without it, each body's tick functions run
+    // right before that body moves, after the bodies ticked before it have
+    // moved. So a tick function that follows another body's position sees
+    // where that body was before the tick here, and can lag it by a tick.
+    bool soa_physics;
+    // How collision rules find pairs of bodies that may be colliding
+    scene_broadphase_t broadphase;
+    // The cell size of the grids used by SCENE_BROADPHASE_GRID, or 0 for the default
+    double grid_cell_size;
+    // How many threads collision rules test pairs on, counting the calling thread;
+    // 0 or 1 tests them all on the calling thread. Contact handlers always run on
+    // the calling thread and get the same contacts in the same order either way.
+    size_t num_threads;
+} scene_options_t;
+
 /**
  * A function which adds some forces or impulses to bodies,
  * e.g. from collisions, gravity, or spring forces.
@@ -21,6 +64,60 @@ typedef struct scene scene_t;
  */
 typedef void (*force_creator_t)(void *aux);
 
+/**
+ * A function called by the scene for each pair of bodies that may be colliding
+ * (see scene_add_collision_rule()).
+ * It only decides whether the bodies actually touch; it must not change the scene
+ * or the bodies. Responding to the contact is left to the rule's contact_handler_t.
+ * With scene_options_t.num_threads above 1, it is called on several threads at once.
+ *
+ * @param body1 a body from the rule's first group
+ * @param body2 a body from the rule's second group
+ * @param hint the axis that last separated these bodies, kept by the scene
+ *   for as long as the pair keeps coming up; pass it to find_body_collision_cached()
+ * @param out set to the collision axis and overlap if the bodies are touching
+ * @param aux the auxiliary value passed to scene_add_collision_rule()
+ * @return whether the bodies are touching
+ */
+typedef bool (*collision_rule_t)(body_t *body1, body_t *body2, separating_axis_t *hint,
+                                 collision_info_t *out, void *aux);
+
+/**
+ * How a pair of bodies' contact changed on a tick.
+ */
+typedef enum contact_state {
+    // The bodies started touching
+    CONTACT_ENTER,
+    // The bodies were touching and still are
+    CONTACT_STAY,
+    // The bodies stopped touching
+    CONTACT_EXIT
+} contact_state_t;
+
+/**
+ * A contact found by a collision rule, as stored in the scene's contact buffer.
+ */
+typedef struct contact {
+    body_handle_t body1;
+    body_handle_t body2;
+    // The collision axis and overlap, as found by the rule; zero on exit
+    vector_t axis;
+    double overlap;
+    contact_state_t state;
+} contact_t;
+
+/**
+ * A function called by the scene for each contact a collision rule found,
+ * once every rule has run (see scene_add_collision_rule()).
+ *
+ * @param body1 the contact's body from the rule's first group
+ * @param body2 the contact's body from the rule's second group
+ * @param contact the contact
+ * @param aux the auxiliary value passed to scene_add_collision_rule()
+ */
+typedef void (*contact_handler_t)(body_t *body1, body_t *body2, const contact_t *contact,
+                                  void *aux);
+
 /**
  * Allocates memory for an empty scene.
  * Makes a reasonable guess of the number of bodies to allocate space for.
@@ -31,14 +128,53 @@ typedef void (*force_creator_t)(void *aux);
  */
 scene_t *scene_init(vector_t dimensions);
 
+/**
+ * Allocates memory for an empty scene with the given options.
+ * Asserts that the required memory is successfully allocated.
+ *
+ * @param dimensions the maximum dimensions of the scene
+ * @param options how the scene stores and simulates its bodies
+ * @return the new scene
+ */
+scene_t *scene_init_with_options(vector_t dimensions, scene_options_t options);
+
 /**
  * Releases memory allocated for a given scene
  * and all the bodies and force creators it contains.
+ * Everything allocated from the scene's arena is released at once.
  *
  * @param scene a pointer to a scene returned from scene_init()
  */
 void scene_free(scene_t *scene);
 
+/**
+ * Allocates memory from the scene's arena.
+ * The memory lives exactly as long as the scene, so it must not be
+ * freed by the caller (e.g. pass a NULL freer for aux values allocated here).
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param size the number of bytes to allocate
+ * @return a pointer to the allocated memory
+ */
+void *scene_alloc(scene_t *scene, size_t size);
+
+/**
+ * Starts building a scene: until scene_end_build() is called,
+ * new polygons (including the shapes of new bodies) are allocated from
+ * the scene's arena instead of one by one from the heap.
+ * Those bodies must only ever be added to this scene.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ */
+void scene_begin_build(scene_t *scene);
+
+/**
+ * Stops allocating new polygons from the scene's arena.
+ *
+ * @param scene a pointer to a scene passed to scene_begin_build()
+ */
+void scene_end_build(scene_t *scene);
+
 /**
  * Returns the number of layers in a scene.
  *
@@ -49,12 +185,13 @@ size_t scene_num_layers(scene_t *scene);
 
 /**
  * Returns a reference to a given layer in a scene.
- * DOES NOT create a deep copy of the body list.
+ * DOES NOT create a deep copy of the body array.
+ * The reference is invalidated when a body is added to a new layer.
  *
  * @param scene a pointer to a scene returned from scene_init()
  * @param idx the layer to get in [0, scene_num_layers())
  */
-list_t *scene_get_layer(scene_t *scene, size_t idx);
+body_array_t *scene_get_layer(scene_t *scene, size_t idx);
 
 /**
  * Gets the number of bodies in a given scene.
@@ -97,6 +234,33 @@ vector_t scene_get_dimensions(scene_t *scene);
  */
 void scene_set_dimensions(scene_t *scene, vector_t dimensions);
 
+/**
+ * Gives a scene a terrain, replacing (and freeing) any terrain it had.
+ * The terrain is drawn beneath the bodies of the given layer,
+ * and is freed along with the scene.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param terrain a pointer to a terrain returned from terrain_init(), or NULL
+ * @param layer_no the layer to draw the terrain beneath
+ */
+void scene_set_terrain(scene_t *scene, terrain_t *terrain, size_t layer_no);
+
+/**
+ * Gets the terrain of a scene.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the scene's terrain, or NULL if it has none
+ */
+terrain_t *scene_get_terrain(scene_t *scene);
+
+/**
+ * Gets the layer a scene's terrain is drawn beneath.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the layer number
+ */
+size_t scene_get_terrain_layer(scene_t *scene);
+
 /**
  * Adds a force creator to a scene,
  * to be invoked every time scene_tick() is called.
@@ -110,17 +274,193 @@ void scene_set_dimensions(scene_t *scene, vector_t dimensions);
  * @param bodies the list of bodies affected by the force creator.
  *   The force creator will be removed if any of these bodies are removed.
  *   This list does not own the bodies, so its freer should be NULL.
+ *   The scene takes ownership of the list and frees it immediately.
  * @param freer if non-NULL, a function to call in order to free aux
  */
 void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
                                     void *aux, list_t *bodies, free_func_t freer);
 
+/**
+ * Same as scene_add_bodies_force_creator(), but takes the bodies as an array
+ * allocated with scene_alloc(), avoiding a list allocation per force creator.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param forcer a force creator function
+ * @param aux an auxiliary value to pass to forcer when it is called
+ * @param bodies an array allocated with scene_alloc() of the bodies
+ *   affected by the force creator
+ * @param num_bodies the number of bodies in the array
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void scene_add_n_bodies_force_creator(scene_t *scene, force_creator_t forcer, void *aux,
+                                      body_t **bodies, size_t num_bodies, free_func_t freer);
+
+/**
+ * Adds a drag force on a body, -gamma times its velocity.
+ * Built-in forces like this one are stored by kind rather than as force creators,
+ * and each kind is applied in one pass over its array, before any force creator runs.
+ * Like a force creator, the force is removed when its body is removed.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param gamma the proportionality constant between force and velocity
+ * @param body the body to slow down
+ */
+void scene_add_drag(scene_t *scene, double gamma, body_t *body);
+
+/**
+ * Adds a constant acceleration on a body, i.e. a force of its mass times the acceleration.
+ * See scene_add_drag() for how built-in forces are applied.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param acceleration the acceleration
+ * @param body the body to accelerate
+ */
+void scene_add_acceleration(scene_t *scene, vector_t acceleration, body_t *body);
+
+/**
+ * Adds a spring force between two bodies, k times the distance between them,
+ * pulling each towards the other. See scene_add_drag() for how built-in forces are applied.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param k the spring constant
+ * @param body1 the first body
+ * @param body2 the second body
+ */
+void scene_add_spring(scene_t *scene, double k, body_t *body1, body_t *body2);
+
+/**
+ * Adds Newtonian gravity between two bodies, G * m1 * m2 / r^2,
+ * pulling each towards the other. See scene_add_drag() for how built-in forces are applied.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param G the gravitational constant
+ * @param min_distance the distance within which no force is applied,
+ *   since the force blows up as the bodies get close
+ * @param body1 the first body
+ * @param body2 the second body
+ */
+void scene_add_gravity(scene_t *scene, double G, double min_distance,
+                       body_t *body1, body_t *body2);
+
+/**
+ * Adds a body to one of the scene's collision groups (numbered 0 to 31).
+ * A body can be in several groups, and leaves them all when it is removed.
+ * Bodies are kept in the order they were added, which is the order
+ * collision rules visit them in.
+ *
+ * A body need not be in any of the scene's layers. Such a body is neither drawn
+ * nor ticked, so it only moves when it is moved, e.g. by another body's tick
+ * function; the scene still frees it once it is removed, or with the scene.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param body the body to add
+ * @param group the group to add the body to
+ */
+void scene_add_to_collision_group(scene_t *scene, body_t *body, size_t group);
+
+/**
+ * Registers a rule that is called every tick, after the force creators,
+ * for each pair of bodies from two collision groups whose bounding boxes overlap.
+ * Unlike a force creator per pair of bodies, bodies that are far apart
+ * cost next to nothing. With the default grid broadphase, the second group's
+ * bounding boxes are put in a uniform grid each tick, and only the grid cells
+ * near each body of the first group are searched, so the second group
+ * should be the larger one. See scene_broadphase_t for the alternatives.
+ *
+ * Static bodies (see body_make_static()) are never paired with each other,
+ * and neither are bodies whose collision filters rule each other out
+ * (see body_set_collision_filter()).
+ *
+ * Contacts with triggers are only reported when they start, and a trigger is removed
+ * once a body that uses it up has been reported touching it (see body_make_trigger()).
+ *
+ * If handler is NULL, each contact goes to the handler registered for its
+ * bodies' categories with scene_set_category_handler() instead, if there is one.
+ * The grid broadphase keeps them in a separate grid per group, which is only
+ * rebuilt when the group's members change or one of them is moved.
+ *
+ * A body is never paired with itself. Each pair of bodies is run at most once
+ * per tick: if both bodies are in both groups, the rule gets them in one order only,
+ * with the body that was added to the scene first as body1.
+ *
+ * A tick runs in two phases. First every rule tests its pairs, and the
+ * contacts that entered, stayed or exited are written to a contact buffer;
+ * nothing else changes. Then the buffer is dispatched rule by rule, in the
+ * order the rules were added, calling each rule's handler on its contacts
+ * in the order they were found. Exits of pairs whose bodies were removed
+ * are not reported.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param group1 the group of the first body in each pair
+ * @param group2 the group of the second body in each pair
+ * @param rule the function to call for each pair
+ * @param handler the function to call for each contact the rule finds,
+ *   or NULL to look the handler up by category
+ * @param aux an auxiliary value to pass to rule and handler
+ * @param freer if non-NULL, a function to call in order to free aux
+ *   when the scene is freed
+ */
+void scene_add_collision_rule(scene_t *scene, size_t group1, size_t group2,
+                              collision_rule_t rule, contact_handler_t handler,
+                              void *aux, free_func_t freer);
+
+/**
+ * Finds the bodies in one of the scene's collision groups whose bounding boxes
+ * overlap a box. Searches a bounding volume tree of the group's members
+ * (see aabb_tree.h), so it takes time in proportion to the number of bodies
+ * near the box rather than the size of the group, whatever the broadphase.
+ * Bodies are found where they were at the end of the last tick,
+ * or where they were added if that was since; bodies moved outside
+ * of a tick since then may be missed.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param group the group to search
+ * @param box the box to search with
+ * @param results set to an array of the bodies found, in the order they were
+ *   added to the group. The array belongs to the scene and is only valid
+ *   until the next call to scene_query_box() or scene_tick().
+ * @return the number of bodies found
+ */
+size_t scene_query_box(scene_t *scene, size_t group, aabb_t box, body_t ***results);
+
+/**
+ * Registers the handler for contacts between bodies of two categories,
+ * found by collision rules that were added without a handler
+ * (see scene_add_collision_rule()). The handler is called with the body of
+ * category1 as body1, whichever group each body came from; if the rule found
+ * the pair the other way round, the contact is flipped to match, negating its axis.
+ * Contacts whose categories have no handler are dropped.
+ * Each pair of categories can only be given one handler.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param category1 the category of the first body in each contact
+ * @param category2 the category of the second body in each contact
+ * @param handler the function to call for each contact
+ * @param aux an auxiliary value to pass to handler
+ * @param freer if non-NULL, a function to call in order to free aux
+ *   when the scene is freed
+ */
+void scene_set_category_handler(scene_t *scene, size_t category1, size_t category2,
+                                 contact_handler_t handler, void *aux, free_func_t freer);
+
+/**
+ * Gets the number of contacts collision rules found on the last tick,
+ * i.e. the size of the contact buffer before it was dispatched.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the number of contacts
+ */
+size_t scene_num_contacts(scene_t *scene);
+
 /**
  * Executes a tick of a given scene over a small time interval.
- * This requires executing all the force creators
+ * This requires executing all the force creators and collision rules
  * and then ticking each body (see body_tick()).
+ * Static bodies are not ticked.
  * If any bodies are marked for removal, they should be removed from the scene
  * and freed, along with any force creators acting on them.
+ * Each body's state from before the tick is kept for rendering
+ * (see body_save_previous_state()).
  *
  * @param scene a pointer to a scene returned from scene_init()
  * @param dt the time elapsed since the last tick, in seconds
@@ -4,6 +4,7 @@
 #include "color.h"
 #include "key_handler.h"
 #include "list.h"
+#include "polygon.h"
 #include "scene.h"
 #include "vector.h"
 #include "window.h"
@@ -48,12 +49,21 @@ bool sdl_is_done(void *object);
 void sdl_clear(void);
 
 /**
- * Draws a polygon from the given list of vertices and a color.
+ * Draws a polygon from the given vertices and a color.
  *
- * @param points the list of vertices of the polygon
+ * @param points the vertices of the polygon
  * @param color the color used to fill in the polygon
  */
-void sdl_draw_polygon(list_t *points, rgb_color_t color);
+void sdl_draw_polygon(polygon_t *points, rgb_color_t color);
+
+/**
+ * Draws a polygon translated by an offset, without modifying the polygon.
+ *
+ * @param points the vertices of the polygon
+ * @param offset the vector to add to each vertex before drawing it
+ * @param color the color used to fill in the polygon
+ */
+void sdl_draw_polygon_offset(polygon_t *points, vector_t offset, rgb_color_t color);
 
 /**
  * Displays the rendered frame on the SDL window.
@@ -62,7 +72,7 @@ void sdl_draw_polygon(list_t *points, rgb_color_t color);
 void sdl_show(void);
 
 /**
- * Draws all bodies in a scene visible in the given window.
+ * Draws all bodies in a scene visible in the given window, along with the scene's terrain.
  * This internally calls sdl_clear(), sdl_draw_polygon(), and sdl_show(),
  * so those functions should not be called directly.
  *
@@ -99,8 +109,9 @@ void sdl_render_window(window_t *window);
 void sdl_on_key(key_handler_t handler);
 
 /**
- * Gets the amount of time that has passed since the last time
+ * Gets the amount of real (wall-clock) time that has passed since the last time
  * this function was called, in seconds.
+ * Returns 0 the first time it is called.
  *
  * @return the number of seconds that have elapsed
  */
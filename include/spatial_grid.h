@@ -0,0 +1,59 @@
+#ifndef __SPATIAL_GRID_H__
+#define __SPATIAL_GRID_H__
+
+#include "vector.h"
+#include <stddef.h>
+
+/**
+ * A uniform grid over a rectangle of the plane, used to find which
+ * of a set of axis-aligned boxes overlap a query box without testing all of them.
+ * Each box is listed in every cell it touches; a query only looks at the
+ * cells its own box touches. Boxes outside the rectangle are clamped
+ * into the border cells, so they are still found (just less efficiently).
+ *
+ * The grid is rebuilt from scratch by spatial_grid_build();
+ * the cells are stored contiguously, so a rebuild does no allocation
+ * once the grid has grown to fit.
+ */
+typedef struct spatial_grid spatial_grid_t;
+
+/**
+ * Allocates memory for an empty grid.
+ * Asserts that the required memory was allocated.
+ *
+ * @param cell_size the width and height of each cell; must be positive
+ * @return a pointer to the newly allocated grid
+ */
+spatial_grid_t *spatial_grid_init(double cell_size);
+
+/**
+ * Releases the memory allocated for a grid.
+ *
+ * @param grid a pointer to a grid returned from spatial_grid_init()
+ */
+void spatial_grid_free(spatial_grid_t *grid);
+
+/**
+ * Replaces the contents of a grid with a set of boxes.
+ * Box i is reported by queries as index i.
+ *
+ * @param grid a pointer to a grid returned from spatial_grid_init()
+ * @param bounds the rectangle to divide into cells
+ * @param boxes the boxes to insert; copied into the grid
+ * @param num_boxes the number of boxes
+ */
+void spatial_grid_build(spatial_grid_t *grid, aabb_t bounds, const aabb_t *boxes, size_t num_boxes);
+
+/**
+ * Finds the boxes in a grid that overlap a given box.
+ *
+ * @param grid a pointer to a grid returned from spatial_grid_init()
+ * @param box the box to search with
+ * @param results set to an array of the indices of the overlapping boxes,
+ *   in increasing order. The array belongs to the grid and is only valid
+ *   until the next call to spatial_grid_query() or spatial_grid_build().
+ * @return the number of overlapping boxes
+ */
+size_t spatial_grid_query(spatial_grid_t *grid, aabb_t box, const size_t **results);
+
+#endif // #ifndef __SPATIAL_GRID_H__
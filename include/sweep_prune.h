@@ -0,0 +1,72 @@
+#ifndef __SWEEP_PRUNE_H__
+#define __SWEEP_PRUNE_H__
+
+#include "vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Finds the overlapping pairs between two sets of axis-aligned boxes
+ * by sweeping along the y axis (sweep and prune).
+ * The start and end y coordinates of every box are kept in one list
+ * sorted by y; sweeping the list visits the boxes whose y ranges overlap,
+ * and only those are tested in x.
+ *
+ * The list is kept between updates and re-sorted with insertion sort.
+ * Boxes move little from one tick to the next, so the list is nearly sorted
+ * and re-sorting it is close to linear.
+ * This suits long, thin worlds (like a race track along y) where
+ * few boxes share any given range of y.
+ */
+typedef struct sweep_prune sweep_prune_t;
+
+/**
+ * An overlapping pair of boxes: index1 into the first set, index2 into the second.
+ */
+typedef struct sweep_prune_pair {
+    size_t index1;
+    size_t index2;
+} sweep_prune_pair_t;
+
+/**
+ * Allocates memory for an empty sweep and prune structure.
+ * Asserts that the required memory was allocated.
+ *
+ * @return a pointer to the newly allocated structure
+ */
+sweep_prune_t *sweep_prune_init(void);
+
+/**
+ * Releases the memory allocated for a sweep and prune structure.
+ *
+ * @param sap a pointer to a sweep and prune structure returned from sweep_prune_init()
+ */
+void sweep_prune_free(sweep_prune_t *sap);
+
+/**
+ * Moves the boxes to their new positions and finds the overlapping pairs.
+ * Box i of each set must be the same box as on the previous update
+ * (just moved), unless rebuild is set.
+ *
+ * @param sap a pointer to a sweep and prune structure returned from sweep_prune_init()
+ * @param boxes1 the first set of boxes
+ * @param num_boxes1 the number of boxes in the first set
+ * @param boxes2 the second set of boxes
+ * @param num_boxes2 the number of boxes in the second set
+ * @param rebuild whether boxes were added to or removed from either set
+ *   since the last update, so the sorted box ends must be rebuilt from scratch
+ */
+void sweep_prune_update(sweep_prune_t *sap, const aabb_t *boxes1, size_t num_boxes1,
+                        const aabb_t *boxes2, size_t num_boxes2, bool rebuild);
+
+/**
+ * Gets the overlapping pairs found by the last sweep_prune_update().
+ *
+ * @param sap a pointer to a sweep and prune structure returned from sweep_prune_init()
+ * @param pairs set to an array of the pairs, sorted by index1 and then index2.
+ *   The array belongs to sap and is valid until the next update.
+ * @return the number of pairs
+ */
+size_t sweep_prune_get_pairs(sweep_prune_t *sap, const sweep_prune_pair_t **pairs);
+
+#endif // #ifndef __SWEEP_PRUNE_H__
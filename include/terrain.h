@@ -0,0 +1,119 @@
+#ifndef __TERRAIN_H__
+#define __TERRAIN_H__
+
+#include "color.h"
+#include "vector.h"
+#include <stddef.h>
+
+/**
+ * A kind of ground, e.g. road or sand.
+ */
+typedef struct terrain_surface {
+    // The friction coefficient of the ground
+    double coefficient;
+    rgb_color_t color;
+} terrain_surface_t;
+
+/**
+ * A tile map of surfaces over a rectangle of the plane, from (0, 0) to its dimensions.
+ * The rectangle is divided into equal cells, each holding one surface,
+ * so the surface at any position is found in constant time.
+ * This replaces covering the ground with bodies that only exist to be collided with.
+ */
+typedef struct terrain terrain_t;
+
+/**
+ * Allocates memory for a terrain with every cell set to one surface.
+ * That surface has id 0.
+ * Asserts that the required memory was allocated.
+ *
+ * @param dimensions the size of the rectangle the terrain covers
+ * @param cell_size the width and height of each cell; must be positive
+ * @param surface the surface to start every cell with
+ * @return a pointer to the newly allocated terrain
+ */
+terrain_t *terrain_init(vector_t dimensions, vector_t cell_size, terrain_surface_t surface);
+
+/**
+ * Releases the memory allocated for a terrain.
+ *
+ * @param terrain a pointer to a terrain returned from terrain_init()
+ */
+void terrain_free(terrain_t *terrain);
+
+/**
+ * Adds a surface that cells can be set to.
+ *
+ * @param terrain a pointer to a terrain returned from terrain_init()
+ * @param surface the surface to add
+ * @return the id of the new surface
+ */
+size_t terrain_add_surface(terrain_t *terrain, terrain_surface_t surface);
+
+/**
+ * Sets every cell whose center lies in a rectangle to a surface.
+ * Asserts that the surface id is valid.
+ *
+ * @param terrain a pointer to a terrain returned from terrain_init()
+ * @param area the rectangle to fill
+ * @param surface the id of the surface to fill it with
+ */
+void terrain_fill(terrain_t *terrain, aabb_t area, size_t surface);
+
+/**
+ * Gets the surface at a position.
+ * Positions outside the terrain get the surface of the nearest border cell.
+ *
+ * @param terrain a pointer to a terrain returned from terrain_init()
+ * @param position the position to look up
+ * @return the surface of the cell containing the position
+ */
+terrain_surface_t terrain_surface_at(terrain_t *terrain, vector_t position);
+
+/**
+ * Gets a surface by its id.
+ * Asserts that the id is valid.
+ *
+ * @param terrain a pointer to a terrain returned from terrain_init()
+ * @param surface the id of the surface
+ * @return the surface
+ */
+terrain_surface_t terrain_get_surface(terrain_t *terrain, size_t surface);
+
+/**
+ * Gets the number of columns of cells in a terrain.
+ *
+ * @param terrain a pointer to a terrain returned from terrain_init()
+ * @return the number of columns
+ */
+size_t terrain_num_cols(terrain_t *terrain);
+
+/**
+ * Gets the number of rows of cells in a terrain.
+ *
+ * @param terrain a pointer to a terrain returned from terrain_init()
+ * @return the number of rows
+ */
+size_t terrain_num_rows(terrain_t *terrain);
+
+/**
+ * Gets the size of the cells in a terrain.
+ *
+ * @param terrain a pointer to a terrain returned from terrain_init()
+ * @return the width and height of each cell
+ */
+vector_t terrain_get_cell_size(terrain_t *terrain);
+
+/**
+ * Gets the id of the surface in a cell.
+ * Column 0, row 0 is the cell at the origin.
+ * Asserts that the cell is in the terrain.
+ *
+ * @param terrain a pointer to a terrain returned from terrain_init()
+ * @param col the column of the cell
+ * @param row the row of the cell
+ * @return the id of the cell's surface
+ */
+size_t terrain_get_cell(terrain_t *terrain, size_t col, size_t row);
+
+#endif // #ifndef __TERRAIN_H__
@@ -0,0 +1,73 @@
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <stddef.h>
+
+/**
+ * A fixed set of worker threads that split loops over a range of indices.
+ * Each call to thread_pool_run() cuts the range into contiguous chunks,
+ * one per thread, in order: chunk 0 is run by the calling thread, chunk 1
+ * by the first worker, and so on. Which indices a chunk holds depends only
+ * on the range size and the number of chunks, so results written per chunk
+ * and then concatenated in chunk order come out the same as a serial loop.
+ *
+ * The workers sleep between runs. Waking them costs a few microseconds,
+ * so small ranges are better run on the calling thread alone
+ * (see the grain parameter of thread_pool_run()).
+ */
+typedef struct thread_pool thread_pool_t;
+
+/**
+ * A function run on one chunk of a range.
+ *
+ * @param begin the first index of the chunk
+ * @param end one past the last index of the chunk
+ * @param chunk which chunk this is, from 0 to thread_pool_num_threads() - 1
+ * @param aux the auxiliary value passed to thread_pool_run()
+ */
+typedef void (*thread_pool_task_t)(size_t begin, size_t end, size_t chunk, void *aux);
+
+/**
+ * Allocates a thread pool and starts its workers.
+ * Asserts that the required memory was allocated and the threads started.
+ *
+ * @param num_threads the number of threads to split work between,
+ *   counting the calling thread; 1 starts no workers
+ * @return a pointer to the newly allocated pool
+ */
+thread_pool_t *thread_pool_init(size_t num_threads);
+
+/**
+ * Stops a thread pool's workers and releases its memory.
+ * Must not be called while a run is in progress.
+ *
+ * @param pool a pointer to a pool returned from thread_pool_init()
+ */
+void thread_pool_free(thread_pool_t *pool);
+
+/**
+ * Gets the number of threads a pool splits work between, counting the calling thread.
+ *
+ * @param pool a pointer to a pool returned from thread_pool_init()
+ * @return the number of threads
+ */
+size_t thread_pool_num_threads(thread_pool_t *pool);
+
+/**
+ * Runs a task over the indices 0 to count - 1, split into chunks,
+ * and waits for every chunk to finish.
+ * The range is split into at most count / grain chunks (and at least 1),
+ * so each thread that does any work gets at least grain indices;
+ * the task is not called for the threads left idle.
+ * The task must be safe to run on several threads at once.
+ *
+ * @param pool a pointer to a pool returned from thread_pool_init()
+ * @param count the number of indices
+ * @param grain the fewest indices worth handing to another thread
+ * @param task the function to run on each chunk
+ * @param aux an auxiliary value to pass to task
+ */
+void thread_pool_run(thread_pool_t *pool, size_t count, size_t grain,
+                     thread_pool_task_t task, void *aux);
+
+#endif // #ifndef __THREAD_POOL_H__
@@ -0,0 +1,132 @@
+#ifndef __VEC_BATCH_H__
+#define __VEC_BATCH_H__
+
+#include "vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Math kernels over many points at once.
+ * Points are given as separate x and y arrays (the layout of polygon_t),
+ * so each kernel is a straight loop that SIMD instructions can process
+ * several points at a time.
+ *
+ * Each kernel has a scalar version and, on x86, SSE2 and AVX2 versions.
+ * The fastest version the CPU supports is picked the first time
+ * any kernel is called. All versions perform the same floating point
+ * operations in the same order, so they give bit-identical results.
+ */
+
+/**
+ * The instruction sets the kernels can be run with.
+ */
+typedef enum {
+    VEC_BATCH_SCALAR,
+    VEC_BATCH_SSE2,
+    VEC_BATCH_AVX2
+} vec_batch_isa_t;
+
+/**
+ * Returns the instruction set the kernels currently run with.
+ *
+ * @return the selected instruction set
+ */
+vec_batch_isa_t vec_batch_get_isa(void);
+
+/**
+ * Forces the kernels to run with a given instruction set,
+ * e.g. to compare a SIMD version against the scalar one.
+ * Asserts that the CPU supports the instruction set.
+ *
+ * @param isa the instruction set to use
+ */
+void vec_batch_set_isa(vec_batch_isa_t isa);
+
+/**
+ * Returns whether the CPU (and build) supports an instruction set.
+ *
+ * @param isa the instruction set to check
+ * @return whether vec_batch_set_isa() accepts isa
+ */
+bool vec_batch_isa_supported(vec_batch_isa_t isa);
+
+/**
+ * Adds a translation to every point, in place.
+ *
+ * @param x the x coordinates of the points
+ * @param y the y coordinates of the points
+ * @param n the number of points
+ * @param translation the vector to add to each point
+ */
+void vec_batch_translate(double *x, double *y, size_t n, vector_t translation);
+
+/**
+ * Rotates every point about a pivot, in place.
+ * The sine and cosine are passed in so they are computed once per batch
+ * rather than once per point.
+ *
+ * @param x the x coordinates of the points
+ * @param y the y coordinates of the points
+ * @param n the number of points
+ * @param cos_a the cosine of the rotation angle
+ * @param sin_a the sine of the rotation angle (positive is counterclockwise)
+ * @param pivot the point to rotate about
+ */
+void vec_batch_rotate(double *x, double *y, size_t n, double cos_a, double sin_a, vector_t pivot);
+
+/**
+ * Rotates points about the origin, then translates them,
+ * writing the results to separate arrays.
+ * This is how a body's local vertices are placed in the world.
+ *
+ * @param src_x the x coordinates of the points
+ * @param src_y the y coordinates of the points
+ * @param dst_x where to write the transformed x coordinates
+ * @param dst_y where to write the transformed y coordinates
+ * @param n the number of points
+ * @param cos_a the cosine of the rotation angle
+ * @param sin_a the sine of the rotation angle
+ * @param translation the vector to add after rotating
+ */
+void vec_batch_transform(const double *src_x, const double *src_y, double *dst_x, double *dst_y,
+                         size_t n, double cos_a, double sin_a, vector_t translation);
+
+/**
+ * Scales and offsets each coordinate independently:
+ * dst_x = src_x * scale.x + offset.x and dst_y = src_y * scale.y + offset.y.
+ * This is how scene coordinates are mapped to window pixels.
+ *
+ * @param src_x the x coordinates of the points
+ * @param src_y the y coordinates of the points
+ * @param dst_x where to write the mapped x coordinates
+ * @param dst_y where to write the mapped y coordinates
+ * @param n the number of points
+ * @param scale the factor to multiply each coordinate by
+ * @param offset the vector to add after scaling
+ */
+void vec_batch_scale_offset(const double *src_x, const double *src_y, double *dst_x, double *dst_y,
+                            size_t n, vector_t scale, vector_t offset);
+
+/**
+ * Projects every point onto an axis and finds the extent of the projections.
+ *
+ * @param x the x coordinates of the points
+ * @param y the y coordinates of the points
+ * @param n the number of points
+ * @param axis the axis to project onto
+ * @return the smallest projection in x and the largest in y
+ *   (INFINITY and -INFINITY if n is 0)
+ */
+vector_t vec_batch_project(const double *x, const double *y, size_t n, vector_t axis);
+
+/**
+ * Computes the axis-aligned bounding box of a set of points.
+ *
+ * @param x the x coordinates of the points
+ * @param y the y coordinates of the points
+ * @param n the number of points; must be positive
+ * @return the smallest box containing every point
+ */
+aabb_t vec_batch_aabb(const double *x, const double *y, size_t n);
+
+#endif // #ifndef __VEC_BATCH_H__
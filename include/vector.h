@@ -20,6 +20,15 @@ typedef struct {
  */
 extern const vector_t VEC_ZERO;
 
+/**
+ * An axis-aligned bounding box, given by its lower-left and upper-right corners.
+ * Defined here because, like vector_t, it is passed by value.
+ */
+typedef struct {
+    vector_t min;
+    vector_t max;
+} aabb_t;
+
 /**
  * Adds two vectors.
  * Performs the usual componentwise vector sum.
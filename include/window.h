@@ -106,6 +106,58 @@ void window_follow_body(window_t *window, body_t *body, vector_t focus_offset);
  */
 void window_tick(window_t *window, double dt);
 
+/**
+ * Sets how many times per second window_advance() ticks the scene.
+ * Defaults to 120.
+ *
+ * @param window a pointer to a window returned from window_init()
+ * @param hz the number of ticks per simulated second; must be positive
+ */
+void window_set_tick_rate(window_t *window, double hz);
+
+/**
+ * Sets the most ticks window_advance() runs for a single frame.
+ * If simulating falls further behind than this, the extra time is dropped
+ * (the game slows down) rather than taking ever longer frames to catch up.
+ * Defaults to 8.
+ *
+ * @param window a pointer to a window returned from window_init()
+ * @param max_steps the maximum number of ticks per frame; must be positive
+ */
+void window_set_max_catch_up_steps(window_t *window, size_t max_steps);
+
+/**
+ * Advances a window by the real time since the last frame,
+ * calling window_tick() with a fixed dt as many times as that time covers.
+ * Time left over is carried to the next frame, and sets how far
+ * rendering should interpolate between the last two ticks
+ * (see window_get_interpolation()).
+ *
+ * @param window a pointer to a window returned from window_init()
+ * @param frame_time the wall-clock time since the last frame, in seconds
+ * @return the number of ticks that were run
+ */
+size_t window_advance(window_t *window, double frame_time);
+
+/**
+ * Returns how far between the previous tick and the latest one
+ * the current frame should be drawn, from 0 to 1.
+ * This is 1 for windows that are only ticked directly with window_tick().
+ *
+ * @param window a pointer to a window returned from window_init()
+ * @return the interpolation factor from the last window_advance()
+ */
+double window_get_interpolation(window_t *window);
+
+/**
+ * Returns the center of the window blended between the previous tick
+ * and the latest one, for drawing.
+ *
+ * @param window a pointer to a window returned from window_init()
+ * @return the interpolated center of the window (in scene space)
+ */
+vector_t window_get_render_center(window_t *window);
+
 /**
  * Handles a key press for a window.
  *
@@ -0,0 +1,378 @@
+#include "aabb_tree.h"
+#include "array.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Stands for no node: the root's parent, a leaf's children, the end of the free list
+const size_t AABB_TREE_NULL = SIZE_MAX;
+// A fat box is shrunk back once it is this many margins bigger than it needs to be,
+// e.g. after a fast box slows down
+const double AABB_TREE_SHRINK_MARGINS = 4;
+
+typedef struct tree_node {
+    // For a leaf, its fat box; otherwise the union of its children's boxes
+    aabb_t box;
+    // For a free node, the next free node instead
+    size_t parent;
+    // AABB_TREE_NULL for a leaf
+    size_t child1;
+    size_t child2;
+    // 0 for a leaf, one more than its taller child otherwise, and -1 for a free node
+    int height;
+} tree_node_t;
+
+ARRAY_DECLARE(tree_node_array, tree_node_t)
+ARRAY_DECLARE(tree_index_array, size_t)
+
+typedef struct aabb_tree {
+    double margin;
+    // Leaves, inner nodes and free nodes; a leaf's index is its box's proxy
+    tree_node_array_t nodes;
+    size_t root;
+    size_t free_list;
+    tree_index_array_t stack;
+    tree_index_array_t results;
+} aabb_tree_t;
+
+aabb_tree_t *aabb_tree_init(double margin) {
+    assert(margin >= 0);
+
+    aabb_tree_t *tree = malloc(sizeof(aabb_tree_t));
+    assert(tree);
+
+    tree->margin = margin;
+    tree_node_array_init(&tree->nodes, 0);
+    tree->root = AABB_TREE_NULL;
+    tree->free_list = AABB_TREE_NULL;
+    tree_index_array_init(&tree->stack, 0);
+    tree_index_array_init(&tree->results, 0);
+
+    return tree;
+}
+
+void aabb_tree_free(aabb_tree_t *tree) {
+    assert(tree);
+
+    tree_node_array_free(&tree->nodes);
+    tree_index_array_free(&tree->stack);
+    tree_index_array_free(&tree->results);
+    free(tree);
+}
+
+void aabb_tree_clear(aabb_tree_t *tree) {
+    assert(tree);
+
+    tree_node_array_clear(&tree->nodes);
+    tree->root = AABB_TREE_NULL;
+    tree->free_list = AABB_TREE_NULL;
+}
+
+aabb_t aabb_tree_union(aabb_t a, aabb_t b) {
+    return (aabb_t){.min = {.x = a.min.x < b.min.x ? a.min.x : b.min.x,
+                            .y = a.min.y < b.min.y ? a.min.y : b.min.y},
+                    .max = {.x = a.max.x > b.max.x ? a.max.x : b.max.x,
+                            .y = a.max.y > b.max.y ? a.max.y : b.max.y}};
+}
+
+// The cost of a box in the tree: the chance a random query hits it grows with its perimeter
+double aabb_tree_perimeter(aabb_t box) {
+    return 2 * ((box.max.x - box.min.x) + (box.max.y - box.min.y));
+}
+
+bool aabb_tree_contains(aabb_t outer, aabb_t inner) {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y
+        && inner.max.x <= outer.max.x && inner.max.y <= outer.max.y;
+}
+
+bool aabb_tree_overlaps(aabb_t a, aabb_t b) {
+    return a.min.x <= b.max.x && b.min.x <= a.max.x
+        && a.min.y <= b.max.y && b.min.y <= a.max.y;
+}
+
+bool aabb_tree_is_leaf(const tree_node_t *node) {
+    return node->child1 == AABB_TREE_NULL;
+}
+
+// Takes a node off the free list, or adds one
+size_t aabb_tree_alloc_node(aabb_tree_t *tree) {
+    size_t index = tree->free_list;
+    if (index != AABB_TREE_NULL) {
+        tree->free_list = tree->nodes.data[index].parent;
+    }
+    else {
+        index = tree_node_array_size(&tree->nodes);
+        tree_node_array_add(&tree->nodes, (tree_node_t){.height = -1});
+    }
+    tree_node_t *node = &tree->nodes.data[index];
+    node->parent = AABB_TREE_NULL;
+    node->child1 = AABB_TREE_NULL;
+    node->child2 = AABB_TREE_NULL;
+    node->height = 0;
+    return index;
+}
+
+void aabb_tree_free_node(aabb_tree_t *tree, size_t index) {
+    tree_node_t *node = &tree->nodes.data[index];
+    node->parent = tree->free_list;
+    node->height = -1;
+    tree->free_list = index;
+}
+
+// Recomputes a node's box and height from its children
+void aabb_tree_fit(aabb_tree_t *tree, size_t index) {
+    tree_node_t *nodes = tree->nodes.data;
+    tree_node_t *node = &nodes[index];
+    tree_node_t *child1 = &nodes[node->child1];
+    tree_node_t *child2 = &nodes[node->child2];
+    node->box = aabb_tree_union(child1->box, child2->box);
+    node->height = 1 + (child1->height > child2->height ? child1->height : child2->height);
+}
+
+// Points whatever pointed at old_child (its parent, or the root) at new_child
+void aabb_tree_replace_child(aabb_tree_t *tree, size_t parent, size_t old_child,
+                             size_t new_child) {
+    if (parent == AABB_TREE_NULL) {
+        tree->root = new_child;
+    }
+    else if (tree->nodes.data[parent].child1 == old_child) {
+        tree->nodes.data[parent].child1 = new_child;
+    }
+    else {
+        tree->nodes.data[parent].child2 = new_child;
+    }
+}
+
+// Lifts a's taller child c into a's place, with a as c's first child and c's taller
+// child as its second. c's shorter child goes to a in c's place, next to a's other child b.
+// Returns c, the node now in a's place.
+size_t aabb_tree_rotate_up(aabb_tree_t *tree, size_t a, size_t c, size_t b) {
+    tree_node_t *nodes = tree->nodes.data;
+    size_t f = nodes[c].child1;
+    size_t g = nodes[c].child2;
+    if (nodes[f].height < nodes[g].height) {
+        size_t shorter = f;
+        f = g;
+        g = shorter;
+    }
+
+    nodes[c].parent = nodes[a].parent;
+    aabb_tree_replace_child(tree, nodes[c].parent, a, c);
+    nodes[a].parent = c;
+    nodes[c].child1 = a;
+    nodes[c].child2 = f;
+
+    nodes[a].child1 = b;
+    nodes[a].child2 = g;
+    nodes[g].parent = a;
+
+    aabb_tree_fit(tree, a);
+    aabb_tree_fit(tree, c);
+    return c;
+}
+
+size_t aabb_tree_balance(aabb_tree_t *tree, size_t a) {
+    tree_node_t *nodes = tree->nodes.data;
+    if (aabb_tree_is_leaf(&nodes[a]) || nodes[a].height < 2) {
+        return a;
+    }
+
+    size_t child1 = nodes[a].child1;
+    size_t child2 = nodes[a].child2;
+    int balance = nodes[child2].height - nodes[child1].height;
+    if (balance > 1) {
+        return aabb_tree_rotate_up(tree, a, child2, child1);
+    }
+    if (balance < -1) {
+        return aabb_tree_rotate_up(tree, a, child1, child2);
+    }
+    return a;
+}
+
+// Refits the boxes from a node up to the root, rebalancing along the way
+void aabb_tree_refit_up(aabb_tree_t *tree, size_t index) {
+    while (index != AABB_TREE_NULL) {
+        index = aabb_tree_balance(tree, index);
+        aabb_tree_fit(tree, index);
+        index = tree->nodes.data[index].parent;
+    }
+}
+
+// Finds the node whose box would grow the tree's total perimeter least
+// if the leaf were paired with it, going down from the root
+size_t aabb_tree_find_sibling(aabb_tree_t *tree, aabb_t box) {
+    const tree_node_t *nodes = tree->nodes.data;
+    size_t index = tree->root;
+    while (!aabb_tree_is_leaf(&nodes[index])) {
+        const tree_node_t *node = &nodes[index];
+        double perimeter = aabb_tree_perimeter(node->box);
+        double combined = aabb_tree_perimeter(aabb_tree_union(node->box, box));
+        // Pairing with this node adds a parent around both
+        double cost = 2 * combined;
+        // Going further down grows this node's box all the same
+        double inherited = 2 * (combined - perimeter);
+
+        double child_costs[2];
+        size_t children[2] = {node->child1, node->child2};
+        for (size_t i = 0; i < 2; i++) {
+            const tree_node_t *child = &nodes[children[i]];
+            double grown = aabb_tree_perimeter(aabb_tree_union(child->box, box));
+            if (!aabb_tree_is_leaf(child)) {
+                grown -= aabb_tree_perimeter(child->box);
+            }
+            child_costs[i] = grown + inherited;
+        }
+
+        if (cost < child_costs[0] && cost < child_costs[1]) {
+            break;
+        }
+        index = child_costs[0] < child_costs[1] ? children[0] : children[1];
+    }
+    return index;
+}
+
+void aabb_tree_insert_leaf(aabb_tree_t *tree, size_t leaf) {
+    if (tree->root == AABB_TREE_NULL) {
+        tree->root = leaf;
+        tree->nodes.data[leaf].parent = AABB_TREE_NULL;
+        return;
+    }
+
+    size_t sibling = aabb_tree_find_sibling(tree, tree->nodes.data[leaf].box);
+    size_t new_parent = aabb_tree_alloc_node(tree);
+    tree_node_t *nodes = tree->nodes.data;
+    size_t old_parent = nodes[sibling].parent;
+    nodes[new_parent].parent = old_parent;
+    nodes[new_parent].child1 = sibling;
+    nodes[new_parent].child2 = leaf;
+    aabb_tree_replace_child(tree, old_parent, sibling, new_parent);
+    nodes[sibling].parent = new_parent;
+    nodes[leaf].parent = new_parent;
+
+    aabb_tree_refit_up(tree, new_parent);
+}
+
+void aabb_tree_remove_leaf(aabb_tree_t *tree, size_t leaf) {
+    tree_node_t *nodes = tree->nodes.data;
+    if (leaf == tree->root) {
+        tree->root = AABB_TREE_NULL;
+        return;
+    }
+
+    // The leaf's sibling takes its parent's place
+    size_t parent = nodes[leaf].parent;
+    size_t grandparent = nodes[parent].parent;
+    size_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+    aabb_tree_replace_child(tree, grandparent, parent, sibling);
+    nodes[sibling].parent = grandparent;
+    aabb_tree_free_node(tree, parent);
+
+    aabb_tree_refit_up(tree, grandparent);
+}
+
+// The fat box for a box expected to move by displacement
+aabb_t aabb_tree_fatten(aabb_tree_t *tree, aabb_t box, vector_t displacement) {
+    double r = tree->margin;
+    aabb_t fat = {.min = {.x = box.min.x - r, .y = box.min.y - r},
+                  .max = {.x = box.max.x + r, .y = box.max.y + r}};
+    if (displacement.x < 0) {
+        fat.min.x += displacement.x;
+    }
+    else {
+        fat.max.x += displacement.x;
+    }
+    if (displacement.y < 0) {
+        fat.min.y += displacement.y;
+    }
+    else {
+        fat.max.y += displacement.y;
+    }
+    return fat;
+}
+
+size_t aabb_tree_insert(aabb_tree_t *tree, aabb_t box) {
+    assert(tree);
+
+    size_t leaf = aabb_tree_alloc_node(tree);
+    tree->nodes.data[leaf].box = aabb_tree_fatten(tree, box, VEC_ZERO);
+    aabb_tree_insert_leaf(tree, leaf);
+    return leaf;
+}
+
+void aabb_tree_remove(aabb_tree_t *tree, size_t proxy) {
+    assert(tree);
+    assert(proxy < tree_node_array_size(&tree->nodes));
+    assert(tree->nodes.data[proxy].height == 0);
+
+    aabb_tree_remove_leaf(tree, proxy);
+    aabb_tree_free_node(tree, proxy);
+}
+
+bool aabb_tree_move(aabb_tree_t *tree, size_t proxy, aabb_t box, vector_t displacement) {
+    assert(tree);
+    assert(proxy < tree_node_array_size(&tree->nodes));
+    assert(tree->nodes.data[proxy].height == 0);
+
+    aabb_t old_fat = tree->nodes.data[proxy].box;
+    aabb_t fat = aabb_tree_fatten(tree, box, displacement);
+    if (aabb_tree_contains(old_fat, box)) {
+        double r = AABB_TREE_SHRINK_MARGINS * tree->margin;
+        aabb_t huge = {.min = {.x = fat.min.x - r, .y = fat.min.y - r},
+                       .max = {.x = fat.max.x + r, .y = fat.max.y + r}};
+        if (aabb_tree_contains(huge, old_fat)) {
+            return false;
+        }
+    }
+
+    aabb_tree_remove_leaf(tree, proxy);
+    tree->nodes.data[proxy].box = fat;
+    aabb_tree_insert_leaf(tree, proxy);
+    return true;
+}
+
+aabb_t aabb_tree_get_fat_box(aabb_tree_t *tree, size_t proxy) {
+    assert(tree);
+    assert(proxy < tree_node_array_size(&tree->nodes));
+    assert(tree->nodes.data[proxy].height == 0);
+
+    return tree->nodes.data[proxy].box;
+}
+
+size_t aabb_tree_height(aabb_tree_t *tree) {
+    assert(tree);
+
+    if (tree->root == AABB_TREE_NULL) {
+        return 0;
+    }
+    return (size_t)tree->nodes.data[tree->root].height + 1;
+}
+
+size_t aabb_tree_query(aabb_tree_t *tree, aabb_t box, const size_t **results) {
+    assert(tree);
+    assert(results);
+
+    tree_index_array_clear(&tree->results);
+    tree_index_array_clear(&tree->stack);
+    if (tree->root != AABB_TREE_NULL) {
+        tree_index_array_add(&tree->stack, tree->root);
+    }
+    const tree_node_t *nodes = tree->nodes.data;
+    while (tree_index_array_size(&tree->stack) > 0) {
+        size_t index = tree_index_array_swap_remove(&tree->stack,
+                                                    tree_index_array_size(&tree->stack) - 1);
+        const tree_node_t *node = &nodes[index];
+        if (!aabb_tree_overlaps(node->box, box)) {
+            continue;
+        }
+        if (aabb_tree_is_leaf(node)) {
+            tree_index_array_add(&tree->results, index);
+        }
+        else {
+            tree_index_array_add(&tree->stack, node->child1);
+            tree_index_array_add(&tree->stack, node->child2);
+        }
+    }
+
+    *results = tree->results.data;
+    return tree_index_array_size(&tree->results);
+}
\ No newline at end of file
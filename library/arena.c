@@ -0,0 +1,129 @@
+#include "arena.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+const size_t ARENA_ALIGNMENT = 16;
+// Allocations larger than this fraction of a block get a block of their own
+const size_t ARENA_LARGE_ALLOC_DIVISOR = 4;
+
+typedef struct arena_block {
+    struct arena_block *next;
+    size_t size;
+    size_t used;
+} arena_block_t;
+
+typedef struct arena {
+    arena_block_t *blocks;
+    size_t block_size;
+    size_t bytes_used;
+} arena_t;
+
+arena_t *ARENA_CURRENT = NULL;
+
+size_t arena_align(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+}
+
+// The first usable byte of a block, just past its (aligned) header
+uint8_t *arena_block_data(arena_block_t *block) {
+    return (uint8_t *)block + arena_align(sizeof(arena_block_t));
+}
+
+arena_block_t *arena_new_block(size_t size) {
+    arena_block_t *block = malloc(arena_align(sizeof(arena_block_t)) + size);
+    assert(block);
+
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+
+    return block;
+}
+
+arena_t *arena_init(size_t block_size) {
+    assert(block_size > 0);
+
+    arena_t *arena = malloc(sizeof(arena_t));
+    assert(arena);
+
+    arena->blocks = NULL;
+    arena->block_size = arena_align(block_size);
+    arena->bytes_used = 0;
+
+    return arena;
+}
+
+void arena_free(arena_t *arena) {
+    assert(arena);
+
+    if (ARENA_CURRENT == arena) {
+        ARENA_CURRENT = NULL;
+    }
+
+    arena_block_t *block = arena->blocks;
+    while (block) {
+        arena_block_t *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    free(arena);
+}
+
+void *arena_alloc(arena_t *arena, size_t size) {
+    assert(arena);
+
+    size = arena_align(size);
+    arena->bytes_used += size;
+
+    // Large allocations get a dedicated block behind the current one,
+    // so the partially used current block keeps serving small requests
+    if (size > arena->block_size / ARENA_LARGE_ALLOC_DIVISOR) {
+        arena_block_t *block = arena_new_block(size);
+        block->used = size;
+        if (arena->blocks) {
+            block->next = arena->blocks->next;
+            arena->blocks->next = block;
+        }
+        else {
+            arena->blocks = block;
+        }
+        return arena_block_data(block);
+    }
+
+    arena_block_t *head = arena->blocks;
+    if (!head || head->size - head->used < size) {
+        head = arena_new_block(arena->block_size);
+        head->next = arena->blocks;
+        arena->blocks = head;
+    }
+
+    void *ptr = arena_block_data(head) + head->used;
+    head->used += size;
+    return ptr;
+}
+
+size_t arena_bytes_used(arena_t *arena) {
+    assert(arena);
+
+    return arena->bytes_used;
+}
+
+void arena_set_current(arena_t *arena) {
+    ARENA_CURRENT = arena;
+}
+
+arena_t *arena_get_current(void) {
+    return ARENA_CURRENT;
+}
+
+void *arena_alloc_or_malloc(arena_t *arena, size_t size) {
+    if (arena) {
+        return arena_alloc(arena, size);
+    }
+
+    void *ptr = malloc(size);
+    assert(ptr);
+    return ptr;
+}
\ No newline at end of file
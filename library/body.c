@@ -2,87 +2,217 @@
 #include "collision.h"
 #include "forces.h"
 #include "polygon.h"
+#include "vec_batch.h"
 #include <assert.h>
+#include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
-const size_t BODY_INIT_TICK_FUNC_COUNT = 10;
-const size_t BODY_INIT_FORCES_COUNT = 10;
-const size_t BODY_INIT_SURFACE_COUNT = 10;
+// Most bodies never register a tick function or swap surfaces,
+// so these arrays only allocate on first use
+const size_t BODY_INIT_TICK_FUNC_COUNT = 0;
+const size_t BODY_INIT_SURFACE_COUNT = 0;
+
+// Bodies are allocated in slabs of this many and recycled through a free list
+const size_t BODY_POOL_SLAB_SIZE = 256;
+
+const body_handle_t BODY_HANDLE_NULL = {.index = UINT32_MAX, .generation = 0};
+
+// Masks are 32-bit, one bit per category
+const size_t BODY_NUM_CATEGORIES = 32;
+const size_t BODY_DEFAULT_CATEGORY = 0;
+const uint32_t BODY_ALL_CATEGORIES = UINT32_MAX;
+
+ARRAY_DECLARE(tick_func_array, body_func_t)
+ARRAY_DECLARE(surface_array, SDL_Surface *)
 
 typedef struct body {
-    list_t *shape;
+    // Vertices relative to the centroid at rotation 0; never changes after init
+    polygon_t *shape;
+    // Unit normals of the local edges; never changes after init
+    polygon_t *normals;
+    double area;
+    // Cached world-space vertices, their bounding box,
+    // and the transform they were computed for
+    polygon_t *world_shape;
+    aabb_t world_aabb;
+    vector_t world_centroid;
+    double world_rotation;
+    bool world_valid;
+    // Cached world-space edge normals, and the rotation (and its cosine and sine)
+    // they were computed for; only rotating the body invalidates them
+    polygon_t *world_normals;
+    double normals_rotation;
+    double normals_cos;
+    double normals_sin;
+    bool normals_valid;
     vector_t velocity;
     double mass;
     rgb_color_t color;
     vector_t centroid;
     double curr_rotation;
-    list_t *tick_funcs;
+    // The pose at the start of the last tick, for render interpolation
+    vector_t prev_centroid;
+    double prev_rotation;
+    tick_func_array_t tick_funcs;
     vector_t pending_force;
     vector_t pending_impulse;
     void *info;
     free_func_t info_freer;
     bool removed;
+    bool is_static;
+    // If is_trigger, the categories that use the trigger up
+    bool is_trigger;
+    uint32_t trigger_retire_mask;
+    // The category bit the body collides as, and the categories it collides with
+    size_t collision_category;
+    uint32_t collision_mask;
     double bounding_radius;
+    // The radius of a circle, or the half size of a box
+    body_shape_kind_t shape_kind;
+    double circle_radius;
+    vector_t box_half_size;
     SDL_Surface *surface;
-    list_t *surface_list;
+    surface_array_t surface_list;
     vector_t dimensions;
     bool debug_mode;
+    // If non-NULL, centroid, velocity and the pending force and impulse
+    // live in this store at store_idx instead of in the fields above
+    physics_store_t *store;
+    size_t store_idx;
+    // Pool bookkeeping: the slot's index, its generation (odd while live),
+    // and the next free slot while it is on the free list
+    uint32_t pool_index;
+    uint32_t generation;
+    struct body *next_free;
+    // Where body_remove() reports the body, if anywhere
+    body_array_t *removal_queue;
+    // Where moving a static body reports it, if anywhere,
+    // and whether it is already there
+    body_array_t *move_queue;
+    bool move_queued;
 } body_t;
 
-void body_do_nothing(void *arg) {
-    return;
+ARRAY_DECLARE(body_slab_array, body_t *)
+
+typedef struct body_pool {
+    body_slab_array_t slabs;
+    body_t *free_list;
+} body_pool_t;
+
+body_pool_t BODY_POOL = {.slabs = {.data = NULL, .size = 0, .capacity = 0}, .free_list = NULL};
+
+void body_pool_add_slab(void) {
+    size_t slab_idx = body_slab_array_size(&BODY_POOL.slabs);
+    assert((slab_idx + 1) * BODY_POOL_SLAB_SIZE <= UINT32_MAX);
+
+    body_t *slab = malloc(sizeof(body_t) * BODY_POOL_SLAB_SIZE);
+    assert(slab);
+    body_slab_array_add(&BODY_POOL.slabs, slab);
+
+    // Push in reverse so slots are handed out in address order
+    for (size_t i = BODY_POOL_SLAB_SIZE; i-- > 0;) {
+        slab[i].pool_index = (uint32_t)(slab_idx * BODY_POOL_SLAB_SIZE + i);
+        slab[i].generation = 0;
+        slab[i].next_free = BODY_POOL.free_list;
+        BODY_POOL.free_list = &slab[i];
+    }
 }
 
-body_t *body_init(list_t *shape, double mass, rgb_color_t color) {
+body_t *body_pool_acquire(void) {
+    if (!BODY_POOL.free_list) {
+        body_pool_add_slab();
+    }
+
+    body_t *body = BODY_POOL.free_list;
+    BODY_POOL.free_list = body->next_free;
+    body->next_free = NULL;
+    body->generation++;
+    return body;
+}
+
+void body_pool_release(body_t *body) {
+    body->generation++;
+    body->next_free = BODY_POOL.free_list;
+    BODY_POOL.free_list = body;
+}
+
+body_t *body_init(polygon_t *shape, double mass, rgb_color_t color) {
     return body_init_with_info(shape, mass, color, NULL, NULL);
 }
 
-body_t *body_init_with_info(list_t *shape, double mass, rgb_color_t color,
+body_t *body_init_with_info(polygon_t *shape, double mass, rgb_color_t color,
                             void *info, free_func_t info_freer) {
     return body_init_with_info_and_sprite(shape, mass, color, info, info_freer, NULL, VEC_ZERO);
 }
 
-body_t *body_init_with_info_and_sprite(list_t *shape, double mass, rgb_color_t color, void *info,
+body_t *body_init_with_info_and_sprite(polygon_t *shape, double mass, rgb_color_t color, void *info,
                                        free_func_t info_freer, const char *filename, vector_t dimensions) {
-    body_t *new_body = malloc(sizeof(body_t));
-    assert(new_body);
     assert(mass > 0);
 
+    body_t *new_body = body_pool_acquire();
+
+    // Keep the shape in local space so moving the body never touches its vertices
+    vector_t centroid = polygon_centroid(shape);
+    polygon_translate(shape, vec_negate(centroid));
+
     new_body->shape = shape;
+    new_body->normals = polygon_init(shape->num_vertices);
+    polygon_edge_normals(shape, new_body->normals);
+    new_body->area = polygon_area(shape);
+    new_body->world_shape = polygon_copy(shape);
+    new_body->world_valid = false;
+    new_body->world_normals = polygon_copy(new_body->normals);
+    new_body->normals_valid = false;
     new_body->velocity = VEC_ZERO;
     new_body->mass = mass;
     new_body->color = color;
-    new_body->centroid = polygon_centroid(shape);
+    new_body->centroid = centroid;
     new_body->curr_rotation = 0;
-    new_body->tick_funcs = list_init(BODY_INIT_TICK_FUNC_COUNT, 
-                                     (free_func_t)body_do_nothing);
+    new_body->prev_rotation = 0;
+    tick_func_array_init(&new_body->tick_funcs, BODY_INIT_TICK_FUNC_COUNT);
 
     new_body->pending_force = VEC_ZERO;
     new_body->pending_impulse = VEC_ZERO;
+    new_body->store = NULL;
+    new_body->store_idx = 0;
+    new_body->prev_centroid = new_body->centroid;
 
     double bounding_radius = 0;
-    for (size_t i = 0; i < list_size(shape); i++) {
-        double d = vec_distance(new_body->centroid, *((vector_t *)list_get(shape, i)));
+    for (size_t i = 0; i < shape->num_vertices; i++) {
+        double d = vec_magnitude(polygon_get_vertex(shape, i));
         if (d > bounding_radius) {
             bounding_radius = d;
         }
     }
     new_body->bounding_radius = bounding_radius;
+    new_body->shape_kind = BODY_SHAPE_POLYGON;
+    new_body->circle_radius = 0;
+    new_body->box_half_size = VEC_ZERO;
 
     new_body->info = info;
     new_body->info_freer = info_freer;
     new_body->removed = false;
+    new_body->is_static = false;
+    new_body->is_trigger = false;
+    new_body->trigger_retire_mask = 0;
+    new_body->collision_category = BODY_DEFAULT_CATEGORY;
+    new_body->collision_mask = BODY_ALL_CATEGORIES;
+    new_body->removal_queue = NULL;
+    new_body->move_queue = NULL;
+    new_body->move_queued = false;
     new_body->debug_mode = false;
 
+    // Pool slots are reused, so every field must be reset here
+    new_body->dimensions = dimensions;
     if (filename) {
         new_body->surface = IMG_Load(filename);
-        new_body->dimensions = dimensions;
     }
     else {
         new_body->surface = NULL;
     }
 
-    new_body->surface_list = list_init(BODY_INIT_SURFACE_COUNT, (free_func_t)SDL_FreeSurface);
+    surface_array_init(&new_body->surface_list, BODY_INIT_SURFACE_COUNT);
 
     return new_body;
 }
@@ -90,46 +220,197 @@ body_t *body_init_with_info_and_sprite(list_t *shape, double mass, rgb_color_t c
 void body_free(body_t *body) {
     assert(body);
 
-    list_free(body->shape);
-    list_free(body->tick_funcs);
+    polygon_free(body->shape);
+    polygon_free(body->world_shape);
+    polygon_free(body->normals);
+    polygon_free(body->world_normals);
+    tick_func_array_free(&body->tick_funcs);
 
     if (body->info_freer && body->info) {
         body->info_freer(body->info);
     }
 
-    list_free(body->surface_list);
+    ARRAY_FOR_EACH(SDL_Surface *, surface, &body->surface_list) {
+        SDL_FreeSurface(*surface);
+    }
+    surface_array_free(&body->surface_list);
 
-    free(body);
+    body_pool_release(body);
 }
 
-list_t *body_get_shape(body_t *body) {
+void body_attach_physics_store(body_t *body, physics_store_t *store, size_t idx) {
+    assert(body);
+    assert(store);
+    assert(!body->store);
+
+    store->pos_x[idx] = body->centroid.x;
+    store->pos_y[idx] = body->centroid.y;
+    store->vel_x[idx] = body->velocity.x;
+    store->vel_y[idx] = body->velocity.y;
+    store->inv_mass[idx] = 1. / body->mass;
+    store->force_x[idx] = body->pending_force.x;
+    store->force_y[idx] = body->pending_force.y;
+    store->impulse_x[idx] = body->pending_impulse.x;
+    store->impulse_y[idx] = body->pending_impulse.y;
+    store->step_x[idx] = 0;
+    store->step_y[idx] = 0;
+    store->bodies[idx] = body;
+
+    body->store = store;
+    body->store_idx = idx;
+}
+
+void body_detach_physics_store(body_t *body) {
     assert(body);
+    assert(body->store);
+
+    physics_store_t *store = body->store;
+    size_t idx = body->store_idx;
+    body->centroid = (vector_t){.x = store->pos_x[idx], .y = store->pos_y[idx]};
+    body->velocity = (vector_t){.x = store->vel_x[idx], .y = store->vel_y[idx]};
+    body->pending_force = (vector_t){.x = store->force_x[idx], .y = store->force_y[idx]};
+    body->pending_impulse = (vector_t){.x = store->impulse_x[idx], .y = store->impulse_y[idx]};
+
+    body->store = NULL;
+}
 
-    list_t *shape_cpy = list_init(list_size(body->shape), (free_func_t)free);
-    for (size_t i = 0; i < list_size(body->shape); i++) {
-        vector_t *v = malloc(sizeof(vector_t));
-        *v = *(vector_t *)(list_get(body->shape, i));
-        list_add(shape_cpy, v);
+size_t body_get_physics_index(body_t *body) {
+    assert(body);
+    assert(body->store);
+
+    return body->store_idx;
+}
+
+void body_set_physics_index(body_t *body, size_t idx) {
+    assert(body);
+    assert(body->store);
+
+    body->store_idx = idx;
+}
+
+bool body_is_live(body_t *body) {
+    return body->generation % 2 == 1;
+}
+
+body_handle_t body_get_handle(body_t *body) {
+    assert(body);
+    assert(body_is_live(body));
+
+    return (body_handle_t){.index = body->pool_index, .generation = body->generation};
+}
+
+body_t *body_from_handle(body_handle_t handle) {
+    size_t slab_idx = handle.index / BODY_POOL_SLAB_SIZE;
+    if (slab_idx >= body_slab_array_size(&BODY_POOL.slabs)) {
+        return NULL;
     }
 
-    return shape_cpy;
+    body_t *slab = *body_slab_array_get(&BODY_POOL.slabs, slab_idx);
+    body_t *body = &slab[handle.index % BODY_POOL_SLAB_SIZE];
+    if (body->generation != handle.generation || !body_is_live(body)) {
+        return NULL;
+    }
+    return body;
 }
 
-list_t *body_get_shape_nocpy(body_t *body) {
+// Recomputes the world-space normals (and the rotation's cosine and sine)
+// if the body rotated since the last call
+void body_update_world_normals(body_t *body) {
+    if (body->normals_valid && body->normals_rotation == body->curr_rotation) {
+        return;
+    }
+
+    body->normals_cos = cos(body->curr_rotation);
+    body->normals_sin = sin(body->curr_rotation);
+    polygon_t *local = body->normals;
+    polygon_t *world = body->world_normals;
+    vec_batch_transform(local->x, local->y, world->x, world->y, local->num_vertices,
+                        body->normals_cos, body->normals_sin, VEC_ZERO);
+
+    body->normals_rotation = body->curr_rotation;
+    body->normals_valid = true;
+}
+
+// Recomputes the world-space vertices if the body moved or rotated since the last call
+void body_update_world_shape(body_t *body) {
+    vector_t centroid = body_get_centroid(body);
+    if (body->world_valid
+        && body->world_centroid.x == centroid.x
+        && body->world_centroid.y == centroid.y
+        && body->world_rotation == body->curr_rotation) {
+        return;
+    }
+
+    body_update_world_normals(body);
+    polygon_t *local = body->shape;
+    polygon_t *world = body->world_shape;
+    vec_batch_transform(local->x, local->y, world->x, world->y, local->num_vertices,
+                        body->normals_cos, body->normals_sin, centroid);
+    if (body->shape_kind == BODY_SHAPE_CIRCLE) {
+        // The polygon is inscribed in the circle, so its box is slightly too small
+        vector_t r = {.x = body->circle_radius, .y = body->circle_radius};
+        body->world_aabb = (aabb_t){.min = vec_subtract(centroid, r), .max = vec_add(centroid, r)};
+    }
+    else {
+        body->world_aabb = vec_batch_aabb(world->x, world->y, world->num_vertices);
+    }
+
+    body->world_centroid = centroid;
+    body->world_rotation = body->curr_rotation;
+    body->world_valid = true;
+}
+
+polygon_t *body_get_shape(body_t *body) {
+    assert(body);
+
+    body_update_world_shape(body);
+    return polygon_copy(body->world_shape);
+}
+
+polygon_t *body_get_normals_nocpy(body_t *body) {
+    assert(body);
+
+    body_update_world_normals(body);
+    return body->world_normals;
+}
+
+aabb_t body_get_aabb(body_t *body) {
     assert(body);
 
-    return body->shape;
+    body_update_world_shape(body);
+    return body->world_aabb;
+}
+
+double body_get_area(body_t *body) {
+    assert(body);
+
+    return body->area;
+}
+
+polygon_t *body_get_shape_nocpy(body_t *body) {
+    assert(body);
+
+    body_update_world_shape(body);
+    return body->world_shape;
 }
 
 vector_t body_get_centroid(body_t *body) {
     assert(body);
 
+    if (body->store) {
+        return (vector_t){.x = body->store->pos_x[body->store_idx],
+                          .y = body->store->pos_y[body->store_idx]};
+    }
     return body->centroid;
 }
 
 vector_t body_get_velocity(body_t *body) {
     assert(body);
 
+    if (body->store) {
+        return (vector_t){.x = body->store->vel_x[body->store_idx],
+                          .y = body->store->vel_y[body->store_idx]};
+    }
     return body->velocity;
 }
 
@@ -163,6 +444,33 @@ double body_get_bounding_radius(body_t *body) {
     return body->bounding_radius;
 }
 
+body_shape_kind_t body_get_shape_kind(body_t *body) {
+    assert(body);
+
+    return body->shape_kind;
+}
+
+double body_get_circle_radius(body_t *body) {
+    assert(body);
+    assert(body->shape_kind == BODY_SHAPE_CIRCLE);
+
+    return body->circle_radius;
+}
+
+vector_t body_get_box_half_size(body_t *body) {
+    assert(body);
+    assert(body->shape_kind == BODY_SHAPE_BOX);
+
+    return body->box_half_size;
+}
+
+vector_t body_get_orientation(body_t *body) {
+    assert(body);
+
+    body_update_world_normals(body);
+    return (vector_t){.x = body->normals_cos, .y = body->normals_sin};
+}
+
 SDL_Surface *body_get_surface(body_t *body) {
     assert(body);
 
@@ -181,27 +489,51 @@ bool body_get_debug_mode(body_t *body) {
     return body->debug_mode;
 }
 
+// Tells the body's owner that a static body moved, since it only looks for
+// moves of the static bodies it was told about. A body is reported at most
+// once until the owner drains its queue, however often it moves.
+void body_report_static_move(body_t *body) {
+    if (body->move_queue && !body->move_queued) {
+        body_array_add(body->move_queue, body);
+        body->move_queued = true;
+    }
+}
+
 void body_set_centroid(body_t *body, vector_t x) {
     assert(body);
 
-    vector_t translation = vec_subtract(x, body->centroid);
-    polygon_translate(body->shape, translation);
+    if (body->store) {
+        body->store->pos_x[body->store_idx] = x.x;
+        body->store->pos_y[body->store_idx] = x.y;
+        return;
+    }
     body->centroid = x;
+    // Static bodies are not ticked, so a move is not interpolated
+    if (body->is_static) {
+        body->prev_centroid = x;
+        body_report_static_move(body);
+    }
 }
 
 void body_set_velocity(body_t *body, vector_t v) {
     assert(body);
 
+    if (body->store) {
+        body->store->vel_x[body->store_idx] = v.x;
+        body->store->vel_y[body->store_idx] = v.y;
+        return;
+    }
     body->velocity = v;
 }
 
 void body_set_rotation(body_t *body, double angle) {
     assert(body);
 
-    vector_t c = body->centroid;
-    double delta_angle = angle - body->curr_rotation;
-    polygon_rotate(body->shape, delta_angle, c);
     body->curr_rotation = angle;
+    if (body->is_static) {
+        body->prev_rotation = angle;
+        body_report_static_move(body);
+    }
 }
 
 void body_set_color(body_t *body, rgb_color_t color) {
@@ -216,13 +548,13 @@ void body_set_surface(body_t *body, SDL_Surface *surface) {
     if (surface != body->surface) {
         body->surface = surface;
     }
-    for (size_t i = 0; i < list_size(body->surface_list); i++) {
-        if (list_get(body->surface_list, i) == surface) {
+    ARRAY_FOR_EACH(SDL_Surface *, known, &body->surface_list) {
+        if (*known == surface) {
             return;
         }
     }
     if (surface) {
-        list_add(body->surface_list, surface);
+        surface_array_add(&body->surface_list, surface);
     }
 }
 
@@ -235,12 +567,22 @@ void body_set_debug_mode(body_t *body, bool mode) {
 void body_add_force(body_t *body, vector_t force) {
     assert(body);
 
+    if (body->store) {
+        body->store->force_x[body->store_idx] += force.x;
+        body->store->force_y[body->store_idx] += force.y;
+        return;
+    }
     body->pending_force = vec_add(body->pending_force, force);
 }
 
 void body_add_impulse(body_t *body, vector_t impulse) {
     assert(body);
 
+    if (body->store) {
+        body->store->impulse_x[body->store_idx] += impulse.x;
+        body->store->impulse_y[body->store_idx] += impulse.y;
+        return;
+    }
     body->pending_impulse = vec_add(body->pending_impulse, impulse);
 }
 
@@ -268,46 +610,88 @@ vector_t body_calculate_impulse(body_t *body1, body_t *body2, vector_t axis, dou
     return vec_multiply(impulse, axis);
 }
 
+// Returns the pending force and impulse and clears them
+void body_take_pending(body_t *body, vector_t *force, vector_t *impulse) {
+    if (body->store) {
+        physics_store_t *store = body->store;
+        size_t idx = body->store_idx;
+        *force = (vector_t){.x = store->force_x[idx], .y = store->force_y[idx]};
+        *impulse = (vector_t){.x = store->impulse_x[idx], .y = store->impulse_y[idx]};
+        store->force_x[idx] = 0;
+        store->force_y[idx] = 0;
+        store->impulse_x[idx] = 0;
+        store->impulse_y[idx] = 0;
+        return;
+    }
+    *force = body->pending_force;
+    *impulse = body->pending_impulse;
+    body->pending_force = VEC_ZERO;
+    body->pending_impulse = VEC_ZERO;
+}
+
+void body_run_tick_funcs(body_t *body, double dt) {
+    assert(body);
+
+    for (size_t i = 0; i < tick_func_array_size(&body->tick_funcs); i++) {
+        body_func_t f = *tick_func_array_get(&body->tick_funcs, i);
+        f(body, &dt);
+    }
+}
+
 void body_tick(body_t *body, double dt) {
     assert(body);
 
-    vector_t old_v = body->velocity;
+    vector_t old_v = body_get_velocity(body);
+    vector_t pending_force, pending_impulse;
+    body_take_pending(body, &pending_force, &pending_impulse);
 
     // Add acceleration from forces
-    vector_t accel = vec_multiply(1. / body->mass, body->pending_force);
+    vector_t accel = vec_multiply(1. / body->mass, pending_force);
     vector_t new_v = vec_add(old_v, vec_multiply(dt, accel));
     // Add acceleration from impules
-    vector_t dv = vec_multiply(1. / body->mass, body->pending_impulse);
+    vector_t dv = vec_multiply(1. / body->mass, pending_impulse);
     new_v = vec_add(new_v, dv);
-    body->pending_force = VEC_ZERO;
-    body->pending_impulse = VEC_ZERO;
 
     body_set_velocity(body, new_v);
 
-    double *d = malloc(sizeof(double));
-    assert(d);
-    *d = dt;
-    for (size_t i = 0; i < list_size(body->tick_funcs); i++) {
-        body_func_t f = list_get(body->tick_funcs, i);
-        f(body, d);
-    }
-    free(d);
+    body_run_tick_funcs(body, dt);
 
     // Take average velocity for movement
     vector_t avg_v = vec_multiply(1. / 2., vec_add(old_v, new_v));
     vector_t movement = vec_multiply(dt, avg_v);
-    polygon_translate(body->shape, movement);
-    body->centroid = vec_add(body->centroid, movement);
+    body_set_centroid(body, vec_add(body_get_centroid(body), movement));
+}
+
+void body_save_previous_state(body_t *body) {
+    assert(body);
+
+    body->prev_centroid = body_get_centroid(body);
+    body->prev_rotation = body->curr_rotation;
+}
+
+vector_t body_get_interpolated_centroid(body_t *body, double alpha) {
+    assert(body);
+
+    vector_t curr = body_get_centroid(body);
+    return vec_add(body->prev_centroid, vec_multiply(alpha, vec_subtract(curr, body->prev_centroid)));
+}
+
+double body_get_interpolated_rotation(body_t *body, double alpha) {
+    assert(body);
+
+    return body->prev_rotation + alpha * (body->curr_rotation - body->prev_rotation);
 }
 
 bool body_is_on_screen(body_t *body, vector_t lower_bounds, vector_t upper_bounds) {
     assert(body);
 
-    for (size_t i = 0; i < list_size(body->shape); i++) {
-        vector_t *v = list_get(body->shape, i);
+    polygon_t *shape = body_get_shape_nocpy(body);
+    for (size_t i = 0; i < shape->num_vertices; i++) {
+        double x = shape->x[i];
+        double y = shape->y[i];
 
-        if ((v->x >= lower_bounds.x && v->x <= upper_bounds.x)
-            && (v->y >= lower_bounds.y && v->y <= upper_bounds.y)) {
+        if ((x >= lower_bounds.x && x <= upper_bounds.x)
+            && (y >= lower_bounds.y && y <= upper_bounds.y)) {
             return true;
         }
     }
@@ -319,15 +703,18 @@ void body_register_tick_func(body_t *body, body_func_t f) {
     assert(body);
     assert(f);
 
-    list_add(body->tick_funcs, f);
+    tick_func_array_add(&body->tick_funcs, f);
 }
 
 void body_unregister_tick_func(body_t *body, body_func_t f) {
     assert(body);
 
-    for (size_t i = 0; i < list_size(body->tick_funcs); i++) {
-        if (f == list_get(body->tick_funcs, i)) {
-            list_remove(body->tick_funcs, i);
+    for (size_t i = 0; i < tick_func_array_size(&body->tick_funcs); i++) {
+        if (f == *tick_func_array_get(&body->tick_funcs, i)) {
+            // Keep registration order, since tick functions may depend on it
+            memmove(&body->tick_funcs.data[i], &body->tick_funcs.data[i + 1],
+                    sizeof(body_func_t) * (body->tick_funcs.size - i - 1));
+            body->tick_funcs.size--;
             return;
         }
     }
@@ -337,22 +724,125 @@ bool body_are_overlapping(body_t *body1, body_t *body2) {
     assert(body1);
     assert(body2);
 
-    collision_info_t *c_info = find_collision(body_get_shape_nocpy(body1),
-                                              body_get_shape_nocpy(body2));
-    if (c_info) {
-        free(c_info);
-        return true;
-    }
-    return false;
+    collision_info_t c_info;
+    return find_body_collision_into(body1, body2, &c_info);
 }
 
 void body_remove(body_t *body) {
     assert(body);
+    if (body->removed) {
+        return;
+    }
     body->removed = true;
+    if (body->removal_queue) {
+        body_array_add(body->removal_queue, body);
+    }
+}
+
+void body_make_static(body_t *body) {
+    assert(body);
+    assert(!body->store);
+
+    body->is_static = true;
+    body->mass = INFINITY;
+    body->velocity = VEC_ZERO;
+    body_save_previous_state(body);
+}
+
+bool body_is_static(body_t *body) {
+    assert(body);
+
+    return body->is_static;
+}
+
+void body_make_trigger(body_t *body, uint32_t retire_mask) {
+    assert(body);
+    assert(body->shape_kind == BODY_SHAPE_CIRCLE);
+
+    body_make_static(body);
+    body->is_trigger = true;
+    body->trigger_retire_mask = retire_mask;
+}
+
+bool body_is_trigger(body_t *body) {
+    assert(body);
+
+    return body->is_trigger;
+}
+
+bool body_retires_trigger(body_t *trigger, body_t *body) {
+    assert(trigger);
+    assert(body);
+    assert(trigger->is_trigger);
+
+    return trigger->trigger_retire_mask >> body->collision_category & 1;
+}
+
+void body_set_collision_filter(body_t *body, size_t category, uint32_t mask) {
+    assert(body);
+    assert(category < BODY_NUM_CATEGORIES);
+
+    body->collision_category = category;
+    body->collision_mask = mask;
+}
+
+size_t body_get_collision_category(body_t *body) {
+    assert(body);
+
+    return body->collision_category;
+}
+
+uint32_t body_get_collision_mask(body_t *body) {
+    assert(body);
+
+    return body->collision_mask;
+}
+
+bool body_can_collide(body_t *body1, body_t *body2) {
+    assert(body1);
+    assert(body2);
+
+    return (body1->collision_mask >> body2->collision_category & 1)
+        && (body2->collision_mask >> body1->collision_category & 1);
+}
+
+void body_set_removal_queue(body_t *body, body_array_t *queue) {
+    assert(body);
+
+    body->removal_queue = queue;
+}
+
+void body_set_move_queue(body_t *body, body_array_t *queue) {
+    assert(body);
+
+    body->move_queue = queue;
+}
+
+void body_clear_move_queued(body_t *body) {
+    assert(body);
+
+    body->move_queued = false;
 }
 
 bool body_is_removed(body_t *body) {
     assert(body);
 
     return body->removed;
+}
+
+void body_make_circle(body_t *body, double radius) {
+    assert(body);
+    assert(radius > 0);
+
+    body->shape_kind = BODY_SHAPE_CIRCLE;
+    body->circle_radius = radius;
+    body->world_valid = false;
+}
+
+void body_make_box(body_t *body, vector_t half_size) {
+    assert(body);
+    assert(half_size.x > 0 && half_size.y > 0);
+
+    body->shape_kind = BODY_SHAPE_BOX;
+    body->box_half_size = half_size;
 }
\ No newline at end of file
@@ -2,79 +2,327 @@
 #include "collision.h"
 #include "mathlib.h"
 #include "polygon.h"
+#include "vec_batch.h"
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
 
+const separating_axis_t SEPARATING_AXIS_NONE = {.index = SIZE_MAX};
+
+// Counts for collision_get_stats(), kept per thread so tests can run on several at once
+#ifdef _MSC_VER
+#define COLLISION_THREAD_LOCAL __declspec(thread)
+#else
+#define COLLISION_THREAD_LOCAL _Thread_local
+#endif
+COLLISION_THREAD_LOCAL collision_stats_t COLLISION_STATS = {.tests = 0, .box_rejections = 0,
+                                     .warm_starts = 0, .warm_hits = 0};
+
 // Computes the min and max projection of a shape onto a line
-vector_t min_and_max_projection(list_t *shape, vector_t line) {
-    double max = -INFINITY;
-    double min = INFINITY;
-
-    for (size_t i = 0; i < list_size(shape); i++) { 
-        double dot = vec_dot(*(vector_t *)list_get(shape, i), line);
-        if (dot < min) {
-            min = dot;
+vector_t min_and_max_projection(polygon_t *shape, vector_t line) {
+    return vec_batch_project(shape->x, shape->y, shape->num_vertices, line);
+}
+
+// Finds if the projections of shape1 and shape2 onto an axis overlap, and if so
+// keeps the axis when it has the smallest overlap so far.
+// d is the vector between the centroids, used to point the axis from shape1 towards shape2.
+bool find_axis_overlap(polygon_t *shape1, polygon_t *shape2, vector_t perp, vector_t d,
+                       collision_info_t *info) {
+    // x = min projection and y = max projection
+    vector_t shape1_proj = min_and_max_projection(shape1, perp);
+    vector_t shape2_proj = min_and_max_projection(shape2, perp);
+    if (shape2_proj.x > shape1_proj.y || shape1_proj.x > shape2_proj.y) {
+        return false;
+    }
+
+    double overlap1 = shape2_proj.y - shape1_proj.x;
+    double overlap2 = shape1_proj.y - shape2_proj.x;
+    double min = mathlib_min(overlap1, overlap2);
+    if (min < info->min_overlap) {
+        info->min_overlap = min;
+        info->axis = vec_dot(d, perp) < 0 ? vec_negate(perp) : perp;
+    }
+    return true;
+}
+
+// Finds the first of some edge normals on which the projections of two shapes don't overlap.
+// Returns its index, or SIZE_MAX if they overlap on all of them.
+size_t find_separating_normal(polygon_t *shape1, polygon_t *shape2, polygon_t *normals,
+                              vector_t d, collision_info_t *info) {
+    for (size_t i = 0; i < normals->num_vertices; i++) {
+        vector_t perp = {.x = normals->x[i], .y = normals->y[i]};
+        if (!find_axis_overlap(shape1, shape2, perp, d, info)) {
+            return i;
         }
-        if (dot > max) {
-            max = dot;
+    }
+    return SIZE_MAX;
+}
+
+// Same as find_projection_overlap() on the edge normals of edges_of,
+// computing each normal as it goes instead of storing them
+bool find_edge_overlap(polygon_t *shape1, polygon_t *shape2, polygon_t *edges_of,
+                       vector_t d, collision_info_t *info) {
+    size_t n = edges_of->num_vertices;
+    for (size_t i = 0; i < n; i++) {
+        size_t j = (i + 1) % n;
+        // The edge rotated a quarter turn counterclockwise, as in polygon_edge_normals()
+        vector_t edge = vec_unit((vector_t){.x = edges_of->x[i] - edges_of->x[j],
+                                            .y = edges_of->y[i] - edges_of->y[j]});
+        vector_t perp = {.x = -edge.y, .y = edge.x};
+        if (!find_axis_overlap(shape1, shape2, perp, d, info)) {
+            return false;
         }
     }
+    return true;
+}
 
-    return (vector_t){.x = min, .y = max};
+bool find_aabb_overlap(aabb_t a, aabb_t b) {
+    return a.min.x <= b.max.x && b.min.x <= a.max.x
+        && a.min.y <= b.max.y && b.min.y <= a.max.y;
 }
 
-// Finds if the projections of shape1 and shape2 onto any perpendicular of shape1's edge overlap 
-bool find_projection_overlap(list_t *shape1, list_t *shape2, collision_info_t *info) {
+bool find_collision_into(polygon_t *shape1, polygon_t *shape2, collision_info_t *out) {
     assert(shape1);
     assert(shape2);
+    assert(out);
+
+    aabb_t box1 = vec_batch_aabb(shape1->x, shape1->y, shape1->num_vertices);
+    aabb_t box2 = vec_batch_aabb(shape2->x, shape2->y, shape2->num_vertices);
+    if (!find_aabb_overlap(box1, box2)) {
+        return false;
+    }
+
+    vector_t d = vec_subtract(polygon_centroid(shape2), polygon_centroid(shape1));
+    out->min_overlap = INFINITY;
+    return find_edge_overlap(shape1, shape2, shape1, d, out)
+           && find_edge_overlap(shape1, shape2, shape2, d, out);
+}
+
+collision_info_t *find_collision(polygon_t *shape1, polygon_t *shape2) {
+    collision_info_t result;
+    if (!find_collision_into(shape1, shape2, &result)) {
+        return NULL;
+    }
+
+    collision_info_t *info = malloc(sizeof(collision_info_t));
     assert(info);
+    *info = result;
+    return info;
+}
+
+// Tests two circles: they touch if their centers are closer than the sum of the radii
+bool find_circle_circle_collision(body_t *circle1, body_t *circle2, collision_info_t *info) {
+    double r = body_get_circle_radius(circle1) + body_get_circle_radius(circle2);
+    vector_t d = vec_subtract(body_get_centroid(circle2), body_get_centroid(circle1));
+    double dist_squared = vec_dot(d, d);
+    if (dist_squared > r * r) {
+        return false;
+    }
 
-    for (size_t i = 0; i < list_size(shape1); i++) {
-        vector_t vertex1 = *(vector_t *)list_get(shape1, i);
-        vector_t vertex2 = *(vector_t *)list_get(shape1, (i+1) % list_size(shape1));
-        vector_t edge = vec_unit(vec_subtract(vertex1, vertex2));
-        // Create a line that is perpendicular to that edge
-        vector_t perp = vec_rotate(edge, M_PI / 2);
+    double dist = sqrt(dist_squared);
+    // Concentric circles can be pushed apart along any axis
+    info->axis = dist > 0 ? vec_multiply(1 / dist, d) : (vector_t){.x = 1, .y = 0};
+    info->min_overlap = r - dist;
+    return true;
+}
+
+// Tests a box against a circle by finding the point of the box closest to the circle's center,
+// in the box's own frame. The axis points from the box towards the circle.
+bool find_box_circle_collision(body_t *box, body_t *circle, collision_info_t *info) {
+    vector_t half = body_get_box_half_size(box);
+    vector_t u = body_get_orientation(box);
+    vector_t v = {.x = -u.y, .y = u.x};
+    double r = body_get_circle_radius(circle);
+    vector_t d = vec_subtract(body_get_centroid(circle), body_get_centroid(box));
+    vector_t local = {.x = vec_dot(d, u), .y = vec_dot(d, v)};
+    vector_t closest = {.x = mathlib_min(mathlib_max(local.x, -half.x), half.x),
+                        .y = mathlib_min(mathlib_max(local.y, -half.y), half.y)};
+    vector_t delta = vec_subtract(local, closest);
+    double dist_squared = vec_dot(delta, delta);
+    if (dist_squared > r * r) {
+        return false;
+    }
 
-        // go through every point and dot it with the edge
-        vector_t shape1_proj = min_and_max_projection(shape1, perp);
-        vector_t shape2_proj = min_and_max_projection(shape2, perp);
+    vector_t local_axis;
+    if (dist_squared > 0) {
+        double dist = sqrt(dist_squared);
+        local_axis = vec_multiply(1 / dist, delta);
+        info->min_overlap = r - dist;
+    }
+    else {
+        // The center is inside the box: push out through the nearest side
+        double gap_x = half.x - fabs(local.x);
+        double gap_y = half.y - fabs(local.y);
+        if (gap_x < gap_y) {
+            local_axis = (vector_t){.x = local.x < 0 ? -1 : 1, .y = 0};
+            info->min_overlap = gap_x + r;
+        }
+        else {
+            local_axis = (vector_t){.x = 0, .y = local.y < 0 ? -1 : 1};
+            info->min_overlap = gap_y + r;
+        }
+    }
+    info->axis = vec_add(vec_multiply(local_axis.x, u), vec_multiply(local_axis.y, v));
+    return true;
+}
 
-        // Finds if the two projections overlap
-        // x = min projection and y = max projection
-        if (shape2_proj.x > shape1_proj.y || shape1_proj.x > shape2_proj.y) {
+// Finds if the projections of two boxes onto an axis overlap, and if so
+// keeps the axis when it has the smallest overlap so far.
+// axes holds both boxes' edge directions, as in find_box_box_collision().
+bool find_box_axis_overlap(const vector_t axes[4], vector_t half1, vector_t half2,
+                           vector_t d, vector_t n, collision_info_t *info) {
+    // How far each box reaches along n from its center
+    double reach1 = fabs(vec_dot(axes[0], n)) * half1.x + fabs(vec_dot(axes[1], n)) * half1.y;
+    double reach2 = fabs(vec_dot(axes[2], n)) * half2.x + fabs(vec_dot(axes[3], n)) * half2.y;
+    double dist = vec_dot(d, n);
+    double overlap = reach1 + reach2 - fabs(dist);
+    if (overlap < 0) {
+        return false;
+    }
+    if (overlap < info->min_overlap) {
+        info->min_overlap = overlap;
+        info->axis = dist < 0 ? vec_negate(n) : n;
+    }
+    return true;
+}
+
+// Tests two boxes on their four edge directions (the separating axis theorem for rectangles).
+// Axis i of the hint is axes[i].
+bool find_box_box_collision(body_t *box1, body_t *box2, separating_axis_t *hint,
+                            collision_info_t *info) {
+    vector_t half1 = body_get_box_half_size(box1);
+    vector_t half2 = body_get_box_half_size(box2);
+    vector_t u1 = body_get_orientation(box1);
+    vector_t u2 = body_get_orientation(box2);
+    vector_t axes[4] = {u1, {.x = -u1.y, .y = u1.x}, u2, {.x = -u2.y, .y = u2.x}};
+    vector_t d = vec_subtract(body_get_centroid(box2), body_get_centroid(box1));
+
+    if (hint->index < 4) {
+        collision_info_t scratch = {.min_overlap = INFINITY};
+        if (!find_box_axis_overlap(axes, half1, half2, d, axes[hint->index], &scratch)) {
+            COLLISION_STATS.warm_hits++;
             return false;
         }
+    }
 
-        double overlap1 = shape2_proj.y - shape1_proj.x;
-        double overlap2 = shape1_proj.y - shape2_proj.x;
-
-        double min = mathlib_min(overlap1, overlap2);
-        if (min < info->min_overlap) {
-            info->min_overlap = min;
-
-            vector_t centroid1 = polygon_centroid(shape1);
-            vector_t centroid2 = polygon_centroid(shape2);
-            double og_dist = vec_distance(centroid1, centroid2);
-            double new_dist = vec_distance(vec_add(centroid1, perp), centroid2);
-            if (og_dist > new_dist) {
-                info->axis = perp;
-            }
-            else {
-                info->axis = vec_negate(perp);
-            }
+    info->min_overlap = INFINITY;
+    for (size_t i = 0; i < 4; i++) {
+        if (!find_box_axis_overlap(axes, half1, half2, d, axes[i], info)) {
+            hint->index = i;
+            return false;
         }
     }
+    hint->index = SIZE_MAX;
     return true;
 }
 
-collision_info_t *find_collision(list_t *shape1, list_t *shape2) {
-    collision_info_t *info = malloc(sizeof(collision_info_t));
+// Tests two bodies' polygons using their cached world-space edge normals.
+// Axis i of the hint is body1's normal i, or body2's normal i - (body1's normal count).
+bool find_polygon_collision(body_t *body1, body_t *body2, separating_axis_t *hint,
+                            collision_info_t *info) {
+    polygon_t *shape1 = body_get_shape_nocpy(body1);
+    polygon_t *shape2 = body_get_shape_nocpy(body2);
+    polygon_t *normals1 = body_get_normals_nocpy(body1);
+    polygon_t *normals2 = body_get_normals_nocpy(body2);
+    size_t n1 = normals1->num_vertices;
+    vector_t d = vec_subtract(body_get_centroid(body2), body_get_centroid(body1));
+
+    if (hint->index < n1 + normals2->num_vertices) {
+        polygon_t *normals = hint->index < n1 ? normals1 : normals2;
+        size_t k = hint->index < n1 ? hint->index : hint->index - n1;
+        vector_t perp = {.x = normals->x[k], .y = normals->y[k]};
+        collision_info_t scratch = {.min_overlap = INFINITY};
+        if (!find_axis_overlap(shape1, shape2, perp, d, &scratch)) {
+            COLLISION_STATS.warm_hits++;
+            return false;
+        }
+    }
+
     info->min_overlap = INFINITY;
-    if (find_projection_overlap(shape1, shape2, info) && find_projection_overlap(shape2, shape1, info)) {
-        return info;
+    size_t separating = find_separating_normal(shape1, shape2, normals1, d, info);
+    if (separating != SIZE_MAX) {
+        hint->index = separating;
+        return false;
+    }
+    separating = find_separating_normal(shape1, shape2, normals2, d, info);
+    if (separating != SIZE_MAX) {
+        hint->index = n1 + separating;
+        return false;
+    }
+    hint->index = SIZE_MAX;
+    return true;
+}
+
+bool find_body_collision_cached(body_t *body1, body_t *body2, separating_axis_t *hint,
+                                collision_info_t *out) {
+    assert(body1);
+    assert(body2);
+    assert(hint);
+    assert(out);
+
+    COLLISION_STATS.tests++;
+    // The boxes are cached with the bodies' world-space shapes
+    if (!find_aabb_overlap(body_get_aabb(body1), body_get_aabb(body2))) {
+        COLLISION_STATS.box_rejections++;
+        return false;
+    }
+    if (hint->index != SIZE_MAX) {
+        COLLISION_STATS.warm_starts++;
+    }
+
+    body_shape_kind_t kind1 = body_get_shape_kind(body1);
+    body_shape_kind_t kind2 = body_get_shape_kind(body2);
+    if (kind1 == BODY_SHAPE_BOX && kind2 == BODY_SHAPE_BOX) {
+        return find_box_box_collision(body1, body2, hint, out);
     }
-    free(info);
-    return NULL;
+    if (kind1 == BODY_SHAPE_POLYGON || kind2 == BODY_SHAPE_POLYGON) {
+        return find_polygon_collision(body1, body2, hint, out);
+    }
+
+    // Circle tests have no axes to remember
+    *hint = SEPARATING_AXIS_NONE;
+    if (kind1 == BODY_SHAPE_CIRCLE && kind2 == BODY_SHAPE_CIRCLE) {
+        return find_circle_circle_collision(body1, body2, out);
+    }
+    if (kind1 == BODY_SHAPE_BOX) {
+        return find_box_circle_collision(body1, body2, out);
+    }
+    if (!find_box_circle_collision(body2, body1, out)) {
+        return false;
+    }
+    out->axis = vec_negate(out->axis);
+    return true;
+}
+
+bool find_body_collision_into(body_t *body1, body_t *body2, collision_info_t *out) {
+    separating_axis_t hint = SEPARATING_AXIS_NONE;
+    return find_body_collision_cached(body1, body2, &hint, out);
+}
+
+collision_info_t *find_body_collision(body_t *body1, body_t *body2) {
+    collision_info_t result;
+    if (!find_body_collision_into(body1, body2, &result)) {
+        return NULL;
+    }
+
+    collision_info_t *info = malloc(sizeof(collision_info_t));
+    assert(info);
+    *info = result;
+    return info;
+}
+
+collision_stats_t collision_get_stats(void) {
+    return COLLISION_STATS;
+}
+
+void collision_reset_stats(void) {
+    COLLISION_STATS = (collision_stats_t){.tests = 0, .box_rejections = 0,
+                                          .warm_starts = 0, .warm_hits = 0};
+}
+
+void collision_add_stats(collision_stats_t stats) {
+    COLLISION_STATS.tests += stats.tests;
+    COLLISION_STATS.box_rejections += stats.box_rejections;
+    COLLISION_STATS.warm_starts += stats.warm_starts;
+    COLLISION_STATS.warm_hits += stats.warm_hits;
 }
\ No newline at end of file
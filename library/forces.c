@@ -1,55 +1,32 @@
 #include "collision.h"
 #include "forces.h"
+#include "gravity_field.h"
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
 
 const double FORCES_MIN_GRAVITY_DISTANCE = 50;
 
-typedef struct gravity_aux {
-    double G;
-    body_t *body1;
-    body_t *body2;
-} gravity_aux_t;
-
-typedef struct spring_aux {
-    double k;
-    body_t *body1;
-    body_t *body2;
-} spring_aux_t;
-
-typedef struct drag_aux {
-    double gamma;
-    body_t *body;
-} drag_aux_t;
-
 typedef struct collision_aux {
     body_t *body1;
     body_t *body2;
     collision_handler_t handler;
     bool handled_collision;
+    // The axis that last separated body1 and body2
+    separating_axis_t hint;
     void *aux;
     free_func_t aux_freer;
 } collision_aux_t;
 
-void force_creator_gravity(gravity_aux_t *aux) {
-    assert(aux);
-
-    body_t *body1 = aux->body1;
-    body_t *body2 = aux->body2;
-
-    assert(body1);
-    assert(body2);
-
-    vector_t r12 = vec_subtract(body_get_centroid(body2), body_get_centroid(body1));
-    vector_t r21 = vec_negate(r12);
-    double r = vec_magnitude(r12);
-
-    if (r > FORCES_MIN_GRAVITY_DISTANCE) {
-        double force_mag = aux->G * body_get_mass(body1) * body_get_mass(body2) / (r * r);
-        body_add_force(body1, vec_multiply(force_mag, vec_unit(r12)));
-        body_add_force(body2, vec_multiply(force_mag, vec_unit(r21)));
+// Force creator data lives in the scene arena, so only the bodies array is built here
+body_t **forces_body_array(scene_t *scene, body_t *body1, body_t *body2) {
+    size_t num_bodies = body2 ? 2 : 1;
+    body_t **bodies = scene_alloc(scene, sizeof(body_t *) * num_bodies);
+    bodies[0] = body1;
+    if (body2) {
+        bodies[1] = body2;
     }
+    return bodies;
 }
 
 void create_newtonian_gravity(scene_t *scene, double G, body_t *body1, body_t *body2) {
@@ -57,36 +34,7 @@ void create_newtonian_gravity(scene_t *scene, double G, body_t *body1, body_t *b
     assert(body1);
     assert(body2);
 
-    gravity_aux_t *aux = malloc(sizeof(gravity_aux_t));
-    assert(aux);
-
-    aux->G = G;
-    aux->body1 = body1;
-    aux->body2 = body2;
-
-    list_t *bodies = list_init(2, NULL);
-    list_add(bodies, body1);
-    list_add(bodies, body2);
-
-    scene_add_bodies_force_creator(scene, (force_creator_t)force_creator_gravity, aux, bodies, free);
-}
-
-void force_creator_spring(spring_aux_t *aux) {
-    assert(aux);
-
-    body_t *body1 = aux->body1;
-    body_t *body2 = aux->body2;
-
-    assert(body1);
-    assert(body2);
-
-    vector_t r12 = vec_subtract(body_get_centroid(body2), body_get_centroid(body1));
-    vector_t r21 = vec_negate(r12);
-    double r = vec_magnitude(r12);
-
-    double force_mag = aux-> k * r;
-    body_add_force(body1, vec_multiply(force_mag, vec_unit(r12)));
-    body_add_force(body2, vec_multiply(force_mag, vec_unit(r21)));
+    scene_add_gravity(scene, G, FORCES_MIN_GRAVITY_DISTANCE, body1, body2);
 }
 
 void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2) {
@@ -94,46 +42,46 @@ void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2) {
     assert(body1);
     assert(body2);
 
-    spring_aux_t *aux = malloc(sizeof(spring_aux_t));
-    assert(aux);
-    aux->k = k;
-    aux->body1 = body1;
-    aux->body2 = body2;
-
-    list_t *bodies = list_init(2, NULL);
-    list_add(bodies, body1);
-    list_add(bodies, body2);
-
-    scene_add_bodies_force_creator(scene, (force_creator_t)force_creator_spring, aux, bodies, free);
+    scene_add_spring(scene, k, body1, body2);
 }
 
-void force_creator_drag(drag_aux_t *aux) {
-    assert(aux);
+void create_drag(scene_t *scene, double gamma, body_t *body) {
+    assert(scene);
+    assert(body);
+    assert(gamma > 0);
 
-    body_t *body = aux->body;
+    scene_add_drag(scene, gamma, body);
+}
 
+void create_constant_acceleration(scene_t *scene, vector_t acceleration, body_t *body) {
+    assert(scene);
     assert(body);
 
-    vector_t drag_vec = vec_negate(body_get_velocity(body));
-    drag_vec = vec_multiply(aux->gamma, drag_vec);
+    scene_add_acceleration(scene, acceleration, body);
+}
 
-    body_add_force(body, drag_vec);
+void force_creator_gravity_field(gravity_field_t *field) {
+    gravity_field_apply(field);
 }
 
-void create_drag(scene_t *scene, double gamma, body_t *body) {
+gravity_field_t *create_gravity_field(scene_t *scene, double G, double theta) {
     assert(scene);
-    assert(body);
-    assert(gamma > 0);
-
-    drag_aux_t *aux = malloc(sizeof(drag_aux_t));
-    assert(aux);
-    aux->gamma = gamma;
-    aux->body = body;
 
-    list_t *bodies = list_init(2, NULL);
-    list_add(bodies, body);
+    gravity_field_t *field = gravity_field_init(G, FORCES_MIN_GRAVITY_DISTANCE, theta);
+    // The field drops its bodies as they are freed, so the force creator
+    // isn't tied to any of them and lasts as long as the scene
+    body_t **no_bodies = scene_alloc(scene, sizeof(body_t *));
+    scene_add_n_bodies_force_creator(scene, (force_creator_t)force_creator_gravity_field, field,
+                                     no_bodies, 0, (free_func_t)gravity_field_free);
+    return field;
+}
 
-    scene_add_bodies_force_creator(scene, (force_creator_t)force_creator_drag, aux, bodies, free);
+// A cheap test before the narrowphase: whether the bodies' bounding circles overlap.
+// Compares squared distances, so no square root is taken.
+bool forces_bounding_circles_overlap(body_t *body1, body_t *body2) {
+    vector_t d = vec_subtract(body_get_centroid(body2), body_get_centroid(body1));
+    double reach = body_get_bounding_radius(body1) + body_get_bounding_radius(body2);
+    return vec_dot(d, d) <= reach * reach;
 }
 
 void force_creator_collision(collision_aux_t *aux) {
@@ -145,23 +93,27 @@ void force_creator_collision(collision_aux_t *aux) {
     assert(body1);
     assert(body2);
 
-    double distance = vec_distance(body_get_centroid(body1), body_get_centroid(body2));
-    if (distance > body_get_bounding_radius(body1) + body_get_bounding_radius(body2)) {
+    if (!forces_bounding_circles_overlap(body1, body2)) {
         aux->handled_collision = false;
         return;
     }
 
-    collision_info_t* c_info = find_collision(body_get_shape_nocpy(body1), body_get_shape_nocpy(body2));
-    if (c_info && !aux->handled_collision) { 
-        vector_t axis = c_info->axis;
+    collision_info_t c_info;
+    if (!find_body_collision_cached(body1, body2, &aux->hint, &c_info)) {
+        aux->handled_collision = false;
+        return;
+    }
+    if (!aux->handled_collision) {
         if (aux->handler) {
-            aux->handler(body1, body2, axis, aux->aux);
+            aux->handler(body1, body2, c_info.axis, aux->aux);
         }
         aux->handled_collision = true;
     }
-    else if (!c_info) {
-        aux->handled_collision = false;
-    }
+}
+
+// Releases the handler's aux value; the collision_aux_t itself is in the scene arena
+void collision_aux_free(collision_aux_t *collision_aux) {
+    collision_aux->aux_freer(collision_aux->aux);
 }
 
 void create_collision(scene_t *scene, body_t *body1, body_t *body2, collision_handler_t handler, void *aux, free_func_t freer) {
@@ -169,20 +121,80 @@ void create_collision(scene_t *scene, body_t *body1, body_t *body2, collision_ha
     assert(body1);
     assert(body2);
 
-    collision_aux_t *collision_aux = malloc(sizeof(collision_aux_t));
-    assert(collision_aux);
+    collision_aux_t *collision_aux = scene_alloc(scene, sizeof(collision_aux_t));
     collision_aux->body1 = body1;
     collision_aux->body2 = body2;
     collision_aux->handler = handler;
     collision_aux->aux = aux;
     collision_aux->aux_freer = freer;
     collision_aux->handled_collision = false;
+    collision_aux->hint = SEPARATING_AXIS_NONE;
+
+    free_func_t collision_freer = (freer && aux) ? (free_func_t)collision_aux_free : NULL;
+    scene_add_n_bodies_force_creator(scene, (force_creator_t)force_creator_collision, collision_aux,
+                                     forces_body_array(scene, body1, body2), 2, collision_freer);
+}
 
-    list_t *bodies = list_init(2, NULL);
-    list_add(bodies, body1);
-    list_add(bodies, body2);
+// The narrowphase of a collision rule: the same test as force_creator_collision()
+bool collision_rule_group(body_t *body1, body_t *body2, separating_axis_t *hint,
+                          collision_info_t *out, collision_aux_t *aux) {
+    if (!forces_bounding_circles_overlap(body1, body2)) {
+        return false;
+    }
+    return find_body_collision_cached(body1, body2, hint, out);
+}
+
+// Calls the handler once when two bodies start touching, like force_creator_collision()
+void collision_contact_group(body_t *body1, body_t *body2, const contact_t *contact,
+                             collision_aux_t *aux) {
+    if (contact->state == CONTACT_ENTER && aux->handler) {
+        aux->handler(body1, body2, contact->axis, aux->aux);
+    }
+}
+
+// A collision_aux_t for rules and handlers that get their bodies from the scene,
+// so only the handler fields are used
+collision_aux_t *collision_aux_init_unpaired(scene_t *scene, collision_handler_t handler,
+                                             void *aux, free_func_t freer) {
+    collision_aux_t *collision_aux = scene_alloc(scene, sizeof(collision_aux_t));
+    collision_aux->body1 = NULL;
+    collision_aux->body2 = NULL;
+    collision_aux->handler = handler;
+    collision_aux->aux = aux;
+    collision_aux->aux_freer = freer;
+    collision_aux->handled_collision = false;
+    collision_aux->hint = SEPARATING_AXIS_NONE;
+    return collision_aux;
+}
+
+void create_group_collision(scene_t *scene, size_t group1, size_t group2,
+                            collision_handler_t handler, void *aux, free_func_t freer) {
+    assert(scene);
+
+    collision_aux_t *collision_aux = collision_aux_init_unpaired(scene, handler, aux, freer);
+    free_func_t collision_freer = (freer && aux) ? (free_func_t)collision_aux_free : NULL;
+    scene_add_collision_rule(scene, group1, group2, (collision_rule_t)collision_rule_group,
+                             (contact_handler_t)collision_contact_group, collision_aux,
+                             collision_freer);
+}
+
+void create_category_collision(scene_t *scene, size_t group1, size_t group2) {
+    assert(scene);
+
+    scene_add_collision_rule(scene, group1, group2, (collision_rule_t)collision_rule_group,
+                             NULL, NULL, NULL);
+}
+
+void create_category_handler(scene_t *scene, size_t category1, size_t category2,
+                             collision_handler_t handler, void *aux, free_func_t freer) {
+    assert(scene);
+    assert(handler);
 
-    scene_add_bodies_force_creator(scene, (force_creator_t)force_creator_collision, collision_aux, bodies, freer);
+    collision_aux_t *collision_aux = collision_aux_init_unpaired(scene, handler, aux, freer);
+    free_func_t collision_freer = (freer && aux) ? (free_func_t)collision_aux_free : NULL;
+    scene_set_category_handler(scene, category1, category2,
+                               (contact_handler_t)collision_contact_group, collision_aux,
+                               collision_freer);
 }
 
 void collision_handler_destructive_collision(body_t *body1, body_t *body2, vector_t axis, void *aux) {
@@ -209,8 +221,8 @@ void create_physics_collision(scene_t *scene, double elasticity, body_t *body1,
     assert(body1);
     assert(body2);
 
-    double *aux = malloc(sizeof(double));
+    double *aux = scene_alloc(scene, sizeof(double));
     *aux = elasticity;
 
-    create_collision(scene, body1, body2, (collision_handler_t) collision_handler_physics_collision, aux, free);
+    create_collision(scene, body1, body2, (collision_handler_t) collision_handler_physics_collision, aux, NULL);
 }
\ No newline at end of file
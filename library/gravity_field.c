@@ -0,0 +1,322 @@
+#include "array.h"
+#include "gravity_field.h"
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Cells stop splitting at this depth, so bodies at the same position share a leaf
+// instead of splitting forever
+const size_t GRAVITY_FIELD_MAX_DEPTH = 48;
+// Leaves hold up to this many bodies before splitting; summing a few bodies
+// directly is cheaper than walking down to each one
+const size_t GRAVITY_FIELD_LEAF_SIZE = 8;
+
+// A body as seen by one application of the field
+typedef struct gravity_body {
+    body_t *body;
+    vector_t position;
+    double mass;
+    vector_t force;
+    // The next body in the same leaf, or SIZE_MAX
+    size_t next;
+} gravity_body_t;
+
+typedef struct gravity_cell {
+    // The square the cell covers
+    vector_t center;
+    double half_size;
+    // The total mass in the cell, and its center of mass. While the tree is built,
+    // center_of_mass holds the sum of each body's mass times its position.
+    double mass;
+    vector_t center_of_mass;
+    // How far a body must be from the center of mass to be pulled by the cell as a whole
+    double open_distance;
+    // The first of the cell's four children, which are stored together,
+    // or SIZE_MAX if the cell is a leaf
+    size_t first_child;
+    // For a leaf, its first body (the rest are chained through next), or SIZE_MAX,
+    // and how many bodies it holds
+    size_t first_body;
+    size_t num_bodies;
+} gravity_cell_t;
+
+ARRAY_DECLARE(gravity_handle_array, body_handle_t)
+ARRAY_DECLARE(gravity_body_array, gravity_body_t)
+ARRAY_DECLARE(gravity_cell_array, gravity_cell_t)
+ARRAY_DECLARE(gravity_index_array, size_t)
+
+typedef struct gravity_field {
+    double G;
+    double min_distance;
+    double theta;
+    gravity_handle_array_t handles;
+    // Scratch space, rebuilt each time the field is applied
+    gravity_body_array_t bodies;
+    gravity_cell_array_t cells;
+    gravity_index_array_t stack;
+} gravity_field_t;
+
+gravity_field_t *gravity_field_init(double G, double min_distance, double theta) {
+    assert(min_distance >= 0);
+    assert(theta >= 0);
+
+    gravity_field_t *field = malloc(sizeof(gravity_field_t));
+    assert(field);
+
+    field->G = G;
+    field->min_distance = min_distance;
+    field->theta = theta;
+    gravity_handle_array_init(&field->handles, 0);
+    gravity_body_array_init(&field->bodies, 0);
+    gravity_cell_array_init(&field->cells, 0);
+    gravity_index_array_init(&field->stack, 0);
+
+    return field;
+}
+
+void gravity_field_free(gravity_field_t *field) {
+    assert(field);
+
+    gravity_handle_array_free(&field->handles);
+    gravity_body_array_free(&field->bodies);
+    gravity_cell_array_free(&field->cells);
+    gravity_index_array_free(&field->stack);
+    free(field);
+}
+
+void gravity_field_add_body(gravity_field_t *field, body_t *body) {
+    assert(field);
+    assert(body);
+    assert(!body_is_static(body));
+
+    gravity_handle_array_add(&field->handles, body_get_handle(body));
+}
+
+size_t gravity_field_num_bodies(gravity_field_t *field) {
+    assert(field);
+
+    return gravity_handle_array_size(&field->handles);
+}
+
+void gravity_field_set_theta(gravity_field_t *field, double theta) {
+    assert(field);
+    assert(theta >= 0);
+
+    field->theta = theta;
+}
+
+// remove_if() predicate: drops handles to bodies that have been freed
+bool gravity_field_handle_is_dead(body_handle_t *handle, void *aux) {
+    return body_from_handle(*handle) == NULL;
+}
+
+// Drops the freed bodies, then reads the positions and masses of the rest
+void gravity_field_gather(gravity_field_t *field) {
+    gravity_handle_array_remove_if(&field->handles, gravity_field_handle_is_dead, NULL);
+    gravity_body_array_clear(&field->bodies);
+    ARRAY_FOR_EACH(body_handle_t, handle, &field->handles) {
+        body_t *body = body_from_handle(*handle);
+        gravity_body_t b = {.body = body, .position = body_get_centroid(body),
+                            .mass = body_get_mass(body), .force = VEC_ZERO, .next = SIZE_MAX};
+        gravity_body_array_add(&field->bodies, b);
+    }
+}
+
+// The pull on a body of a mass at offset (dx, dy) is the offset times this,
+// or nothing within min_distance. The hot loops below work on plain doubles.
+double gravity_field_pull_scale(gravity_field_t *field, double body_mass, double mass,
+                                double dx, double dy) {
+    double r2 = dx * dx + dy * dy;
+    if (r2 <= field->min_distance * field->min_distance) {
+        return 0;
+    }
+    return field->G * body_mass * mass / (r2 * sqrt(r2));
+}
+
+// Sums every pair, applying each pull to both bodies
+void gravity_field_apply_exact(gravity_field_t *field) {
+    gravity_body_t *bodies = field->bodies.data;
+    size_t num_bodies = gravity_body_array_size(&field->bodies);
+    for (size_t i = 0; i < num_bodies; i++) {
+        for (size_t j = i + 1; j < num_bodies; j++) {
+            double dx = bodies[j].position.x - bodies[i].position.x;
+            double dy = bodies[j].position.y - bodies[i].position.y;
+            double scale = gravity_field_pull_scale(field, bodies[i].mass, bodies[j].mass, dx, dy);
+            bodies[i].force.x += scale * dx;
+            bodies[i].force.y += scale * dy;
+            bodies[j].force.x -= scale * dx;
+            bodies[j].force.y -= scale * dy;
+        }
+    }
+}
+
+gravity_cell_t gravity_field_make_cell(vector_t center, double half_size) {
+    return (gravity_cell_t){.center = center, .half_size = half_size, .mass = 0,
+                            .center_of_mass = VEC_ZERO, .open_distance = INFINITY,
+                            .first_child = SIZE_MAX, .first_body = SIZE_MAX,
+                            .num_bodies = 0};
+}
+
+// Which of a cell's children a position falls in: bit 0 for the right half, bit 1 for the top
+size_t gravity_field_quadrant(gravity_cell_t *cell, vector_t position) {
+    return (position.x >= cell->center.x ? 1 : 0) + (position.y >= cell->center.y ? 2 : 0);
+}
+
+// Gives a leaf four children and moves its bodies into them
+void gravity_field_split(gravity_field_t *field, size_t cell_idx) {
+    size_t first_child = gravity_cell_array_size(&field->cells);
+    gravity_cell_t cell = *gravity_cell_array_get(&field->cells, cell_idx);
+    double half = cell.half_size / 2;
+    for (size_t q = 0; q < 4; q++) {
+        vector_t center = {.x = cell.center.x + ((q & 1) ? half : -half),
+                           .y = cell.center.y + ((q & 2) ? half : -half)};
+        gravity_cell_array_add(&field->cells, gravity_field_make_cell(center, half));
+    }
+
+    size_t next;
+    for (size_t i = cell.first_body; i != SIZE_MAX; i = next) {
+        gravity_body_t *body = gravity_body_array_get(&field->bodies, i);
+        next = body->next;
+        size_t quadrant = gravity_field_quadrant(&cell, body->position);
+        gravity_cell_t *child = gravity_cell_array_get(&field->cells, first_child + quadrant);
+        body->next = child->first_body;
+        child->first_body = i;
+        child->num_bodies++;
+        child->mass += body->mass;
+        child->center_of_mass = vec_add(child->center_of_mass,
+                                        vec_multiply(body->mass, body->position));
+    }
+
+    gravity_cell_t *parent = gravity_cell_array_get(&field->cells, cell_idx);
+    parent->first_child = first_child;
+    parent->first_body = SIZE_MAX;
+    parent->num_bodies = 0;
+}
+
+void gravity_field_insert(gravity_field_t *field, size_t body_idx) {
+    gravity_body_t *body = gravity_body_array_get(&field->bodies, body_idx);
+    vector_t weighted = vec_multiply(body->mass, body->position);
+    size_t cell_idx = 0;
+    for (size_t depth = 0; ; depth++) {
+        // Cells are added while descending, so they are looked up by index
+        gravity_cell_t *cell = gravity_cell_array_get(&field->cells, cell_idx);
+        if (cell->first_child == SIZE_MAX) {
+            if (cell->num_bodies < GRAVITY_FIELD_LEAF_SIZE || depth >= GRAVITY_FIELD_MAX_DEPTH) {
+                cell->mass += body->mass;
+                cell->center_of_mass = vec_add(cell->center_of_mass, weighted);
+                body->next = cell->first_body;
+                cell->first_body = body_idx;
+                cell->num_bodies++;
+                return;
+            }
+            gravity_field_split(field, cell_idx);
+            cell = gravity_cell_array_get(&field->cells, cell_idx);
+        }
+        cell->mass += body->mass;
+        cell->center_of_mass = vec_add(cell->center_of_mass, weighted);
+        cell_idx = cell->first_child + gravity_field_quadrant(cell, body->position);
+    }
+}
+
+// Builds the quadtree over the gathered bodies, with cell 0 as the root
+void gravity_field_build(gravity_field_t *field) {
+    gravity_cell_array_clear(&field->cells);
+    size_t num_bodies = gravity_body_array_size(&field->bodies);
+    vector_t min = field->bodies.data[0].position;
+    vector_t max = min;
+    for (size_t i = 1; i < num_bodies; i++) {
+        vector_t p = field->bodies.data[i].position;
+        min = (vector_t){.x = fmin(min.x, p.x), .y = fmin(min.y, p.y)};
+        max = (vector_t){.x = fmax(max.x, p.x), .y = fmax(max.y, p.y)};
+    }
+    // A little larger than the bodies' bounds, so none sits exactly on the edge
+    double half_size = fmax(max.x - min.x, max.y - min.y) / 2 * 1.001 + 1e-9;
+    vector_t center = vec_multiply(0.5, vec_add(min, max));
+    gravity_cell_array_add(&field->cells, gravity_field_make_cell(center, half_size));
+    for (size_t i = 0; i < num_bodies; i++) {
+        gravity_field_insert(field, i);
+    }
+
+    // The cell's width over theta, plus how far its center of mass is off center,
+    // since bodies just past the width / theta limit may be close to the mass (Barnes 1994)
+    ARRAY_FOR_EACH(gravity_cell_t, cell, &field->cells) {
+        if (cell->mass > 0) {
+            cell->center_of_mass = vec_multiply(1 / cell->mass, cell->center_of_mass);
+            double offset = vec_magnitude(vec_subtract(cell->center_of_mass, cell->center));
+            cell->open_distance = 2 * cell->half_size / field->theta + offset;
+        }
+    }
+}
+
+// The pull of the whole tree on one body
+vector_t gravity_field_tree_force(gravity_field_t *field, size_t body_idx) {
+    gravity_body_t *bodies = field->bodies.data;
+    gravity_cell_t *cells = field->cells.data;
+    double x = bodies[body_idx].position.x;
+    double y = bodies[body_idx].position.y;
+    double mass = bodies[body_idx].mass;
+    vector_t force = VEC_ZERO;
+
+    gravity_index_array_clear(&field->stack);
+    gravity_index_array_add(&field->stack, 0);
+    while (gravity_index_array_size(&field->stack) > 0) {
+        size_t cell_idx = gravity_index_array_swap_remove(&field->stack,
+                                                          gravity_index_array_size(&field->stack) - 1);
+        gravity_cell_t *cell = &cells[cell_idx];
+        if (cell->mass == 0) {
+            continue;
+        }
+        if (cell->first_child == SIZE_MAX) {
+            for (size_t j = cell->first_body; j != SIZE_MAX; j = bodies[j].next) {
+                if (j != body_idx) {
+                    double dx = bodies[j].position.x - x;
+                    double dy = bodies[j].position.y - y;
+                    double scale = gravity_field_pull_scale(field, mass, bodies[j].mass, dx, dy);
+                    force.x += scale * dx;
+                    force.y += scale * dy;
+                }
+            }
+            continue;
+        }
+        // A cell that might hold bodies within min_distance is always opened, since
+        // those bodies don't pull at all; this includes any cell holding the body itself
+        double gap_x = fmax(fabs(x - cell->center.x) - cell->half_size, 0);
+        double gap_y = fmax(fabs(y - cell->center.y) - cell->half_size, 0);
+        double gap2 = gap_x * gap_x + gap_y * gap_y;
+        bool near = gap2 == 0 || gap2 <= field->min_distance * field->min_distance;
+        double dx = cell->center_of_mass.x - x;
+        double dy = cell->center_of_mass.y - y;
+        if (!near && dx * dx + dy * dy > cell->open_distance * cell->open_distance) {
+            double scale = gravity_field_pull_scale(field, mass, cell->mass, dx, dy);
+            force.x += scale * dx;
+            force.y += scale * dy;
+            continue;
+        }
+        for (size_t q = 0; q < 4; q++) {
+            gravity_index_array_add(&field->stack, cell->first_child + q);
+        }
+    }
+    return force;
+}
+
+void gravity_field_apply(gravity_field_t *field) {
+    assert(field);
+
+    gravity_field_gather(field);
+    if (gravity_body_array_size(&field->bodies) < 2) {
+        return;
+    }
+    if (field->theta == 0) {
+        gravity_field_apply_exact(field);
+    }
+    else {
+        gravity_field_build(field);
+        for (size_t i = 0; i < gravity_body_array_size(&field->bodies); i++) {
+            field->bodies.data[i].force = gravity_field_tree_force(field, i);
+        }
+    }
+    ARRAY_FOR_EACH(gravity_body_t, b, &field->bodies) {
+        body_add_force(b->body, b->force);
+    }
+}
\ No newline at end of file
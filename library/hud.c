@@ -1,3 +1,4 @@
+#include "array.h"
 #include "hud.h"
 #include <assert.h>
 #include <stdio.h>
@@ -5,12 +6,6 @@
 
 const size_t HUD_INIT_NUM_WIDGETS = 5;
 
-typedef struct hud {
-    list_t *widgets;
-    void *aux;
-    free_func_t aux_freer;
-} hud_t;
-
 typedef struct widget {
     SDL_Surface *surface;
     SDL_Rect orientation;
@@ -20,6 +15,14 @@ typedef struct widget {
     free_func_t aux_freer;
 } widget_t;
 
+ARRAY_DECLARE(widget_array, widget_t *)
+
+typedef struct hud {
+    widget_array_t widgets;
+    void *aux;
+    free_func_t aux_freer;
+} hud_t;
+
 widget_t *widget_init(SDL_Surface *surface, SDL_Rect orientation, double angle, widget_func_t tick_func, void *aux, free_func_t aux_freer) {
     widget_t *widget = malloc(sizeof(widget_t));
     assert(widget);
@@ -95,8 +98,7 @@ void widget_set_rect(widget_t *widget, SDL_Rect coordinates){
 hud_t *hud_init(void *aux, free_func_t aux_freer) {
     hud_t *hud = malloc(sizeof(hud_t));
     assert(hud);
-    list_t *widgets = list_init(HUD_INIT_NUM_WIDGETS, (free_func_t)widget_free);
-    hud->widgets = widgets;
+    widget_array_init(&hud->widgets, HUD_INIT_NUM_WIDGETS);
     hud->aux = aux;
     hud->aux_freer = aux_freer;
     
@@ -106,7 +108,10 @@ hud_t *hud_init(void *aux, free_func_t aux_freer) {
 void hud_free(hud_t *hud) {
     assert(hud);
 
-    list_free(hud->widgets);
+    ARRAY_FOR_EACH(widget_t *, widget, &hud->widgets) {
+        widget_free(*widget);
+    }
+    widget_array_free(&hud->widgets);
     if (hud->aux && hud->aux_freer) {
         hud->aux_freer(hud->aux);
     }
@@ -118,27 +123,29 @@ void hud_add_widget(hud_t *hud, widget_t *widget) {
     assert(widget);
     assert(hud);
 
-    list_add(hud->widgets, widget);
+    widget_array_add(&hud->widgets, widget);
 }
 
 void hud_tick(hud_t *hud) {
     assert(hud);
 
-    list_t *widgets = hud->widgets;
-    assert(widgets);
-    for (size_t i = 0; i < list_size(widgets); i++) {
-        widget_t *widget = (widget_t *)list_get(widgets, i);
-        if (widget->tick_func) {
-            widget->tick_func(widget);
+    ARRAY_FOR_EACH(widget_t *, widget, &hud->widgets) {
+        if ((*widget)->tick_func) {
+            (*widget)->tick_func(*widget);
         }
+    }
+}
+
+size_t hud_num_widgets(hud_t *hud) {
+    assert(hud);
 
-    } 
+    return widget_array_size(&hud->widgets);
 }
 
-list_t *hud_get_widgets(hud_t *hud) {
+widget_t *hud_get_widget(hud_t *hud, size_t idx) {
     assert(hud);
 
-    return hud->widgets;
+    return *widget_array_get(&hud->widgets, idx);
 }
 
 void *hud_get_aux(hud_t *hud) {
@@ -0,0 +1,142 @@
+#include "body.h"
+#include "physics_store.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+const size_t PHYSICS_STORE_SIZE_SCALE = 2;
+// The number of double arrays in a store, all carved out of one allocation
+const size_t PHYSICS_STORE_NUM_COLUMNS = 11;
+
+// Moves the store into allocations with room for capacity bodies
+void physics_store_alloc(physics_store_t *store, size_t capacity) {
+    // pos_x is the first column, so it is the start of the previous allocation
+    double *old_columns = store->pos_x;
+    double *columns = malloc(sizeof(double) * PHYSICS_STORE_NUM_COLUMNS * capacity);
+    assert(columns);
+    body_t **bodies = malloc(sizeof(body_t *) * capacity);
+    assert(bodies);
+
+    double **cols[] = {&store->pos_x, &store->pos_y, &store->vel_x, &store->vel_y,
+                       &store->inv_mass, &store->force_x, &store->force_y,
+                       &store->impulse_x, &store->impulse_y, &store->step_x, &store->step_y};
+    for (size_t i = 0; i < PHYSICS_STORE_NUM_COLUMNS; i++) {
+        double *old = *cols[i];
+        *cols[i] = columns + i * capacity;
+        if (old) {
+            memcpy(*cols[i], old, sizeof(double) * store->size);
+        }
+    }
+    if (store->bodies) {
+        memcpy(bodies, store->bodies, sizeof(body_t *) * store->size);
+    }
+
+    free(old_columns);
+    free(store->bodies);
+    store->bodies = bodies;
+    store->capacity = capacity;
+}
+
+physics_store_t *physics_store_init(size_t initial_size) {
+    physics_store_t *store = malloc(sizeof(physics_store_t));
+    assert(store);
+
+    if (initial_size == 0) {
+        initial_size = 1;
+    }
+
+    memset(store, 0, sizeof(physics_store_t));
+    physics_store_alloc(store, initial_size);
+
+    return store;
+}
+
+void physics_store_free(physics_store_t *store) {
+    assert(store);
+
+    free(store->pos_x);
+    free(store->bodies);
+    free(store);
+}
+
+void physics_store_add(physics_store_t *store, body_t *body) {
+    assert(store);
+    assert(body);
+
+    if (store->size == store->capacity) {
+        physics_store_alloc(store, store->capacity * PHYSICS_STORE_SIZE_SCALE);
+    }
+
+    body_attach_physics_store(body, store, store->size);
+    store->size++;
+}
+
+void physics_store_remove(physics_store_t *store, body_t *body) {
+    assert(store);
+    assert(body);
+
+    size_t idx = body_get_physics_index(body);
+    assert(idx < store->size);
+    body_detach_physics_store(body);
+
+    size_t last = --store->size;
+    if (idx != last) {
+        store->pos_x[idx] = store->pos_x[last];
+        store->pos_y[idx] = store->pos_y[last];
+        store->vel_x[idx] = store->vel_x[last];
+        store->vel_y[idx] = store->vel_y[last];
+        store->inv_mass[idx] = store->inv_mass[last];
+        store->force_x[idx] = store->force_x[last];
+        store->force_y[idx] = store->force_y[last];
+        store->impulse_x[idx] = store->impulse_x[last];
+        store->impulse_y[idx] = store->impulse_y[last];
+        store->step_x[idx] = store->step_x[last];
+        store->step_y[idx] = store->step_y[last];
+        store->bodies[idx] = store->bodies[last];
+        body_set_physics_index(store->bodies[idx], idx);
+    }
+}
+
+void physics_store_integrate_velocities(physics_store_t *store, double dt) {
+    assert(store);
+
+    double *restrict vel_x = store->vel_x;
+    double *restrict vel_y = store->vel_y;
+    double *restrict force_x = store->force_x;
+    double *restrict force_y = store->force_y;
+    double *restrict impulse_x = store->impulse_x;
+    double *restrict impulse_y = store->impulse_y;
+    double *restrict step_x = store->step_x;
+    double *restrict step_y = store->step_y;
+    const double *restrict inv_mass = store->inv_mass;
+
+    for (size_t i = 0; i < store->size; i++) {
+        double old_vx = vel_x[i];
+        double old_vy = vel_y[i];
+        double new_vx = old_vx + dt * (inv_mass[i] * force_x[i]) + inv_mass[i] * impulse_x[i];
+        double new_vy = old_vy + dt * (inv_mass[i] * force_y[i]) + inv_mass[i] * impulse_y[i];
+        vel_x[i] = new_vx;
+        vel_y[i] = new_vy;
+        force_x[i] = 0;
+        force_y[i] = 0;
+        impulse_x[i] = 0;
+        impulse_y[i] = 0;
+        // Move by the average velocity over the tick
+        step_x[i] = dt * (0.5 * (old_vx + new_vx));
+        step_y[i] = dt * (0.5 * (old_vy + new_vy));
+    }
+}
+
+void physics_store_integrate_positions(physics_store_t *store) {
+    assert(store);
+
+    double *restrict pos_x = store->pos_x;
+    double *restrict pos_y = store->pos_y;
+    const double *restrict step_x = store->step_x;
+    const double *restrict step_y = store->step_y;
+
+    for (size_t i = 0; i < store->size; i++) {
+        pos_x[i] += step_x[i];
+        pos_y[i] += step_y[i];
+    }
+}
\ No newline at end of file
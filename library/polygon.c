@@ -1,53 +1,149 @@
 #include "polygon.h"
+#include "vec_batch.h"
 #include <assert.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 double const POLYGON_INF_VAL = 10000;
+const size_t POLYGON_SIZE_SCALE = 2;
 
-double polygon_area(list_t *polygon) {
+// Points x and y into a single block holding capacity x's followed by capacity y's
+void polygon_alloc_coords(polygon_t *polygon, size_t capacity) {
+    double *coords = arena_alloc_or_malloc(polygon->arena, sizeof(double) * 2 * capacity);
+
+    polygon->x = coords;
+    polygon->y = coords + capacity;
+    polygon->capacity = capacity;
+}
+
+polygon_t *polygon_init(size_t initial_size) {
+    arena_t *arena = arena_get_current();
+    polygon_t *polygon = arena_alloc_or_malloc(arena, sizeof(polygon_t));
+    polygon->arena = arena;
+
+    if (initial_size == 0) {
+        initial_size = 1;
+    }
+    polygon_alloc_coords(polygon, initial_size);
+    polygon->num_vertices = 0;
+
+    return polygon;
+}
+
+void polygon_free(polygon_t *polygon) {
+    assert(polygon);
+
+    if (polygon->arena) {
+        return;
+    }
+
+    free(polygon->x);
+    free(polygon);
+}
+
+polygon_t *polygon_copy(polygon_t *polygon) {
+    assert(polygon);
+
+    polygon_t *copy = polygon_init(polygon->num_vertices);
+    memcpy(copy->x, polygon->x, sizeof(double) * polygon->num_vertices);
+    memcpy(copy->y, polygon->y, sizeof(double) * polygon->num_vertices);
+    copy->num_vertices = polygon->num_vertices;
+
+    return copy;
+}
+
+size_t polygon_num_vertices(polygon_t *polygon) {
+    assert(polygon);
+
+    return polygon->num_vertices;
+}
+
+vector_t polygon_get_vertex(polygon_t *polygon, size_t index) {
+    assert(polygon);
+    assert(index < polygon->num_vertices);
+
+    return (vector_t){.x = polygon->x[index], .y = polygon->y[index]};
+}
+
+void polygon_set_vertex(polygon_t *polygon, size_t index, vector_t vertex) {
+    assert(polygon);
+    assert(index < polygon->num_vertices);
+
+    polygon->x[index] = vertex.x;
+    polygon->y[index] = vertex.y;
+}
+
+void polygon_add_vertex(polygon_t *polygon, vector_t vertex) {
+    assert(polygon);
+
+    if (polygon->num_vertices == polygon->capacity) {
+        double *old_x = polygon->x;
+        double *old_y = polygon->y;
+        polygon_alloc_coords(polygon, polygon->capacity * POLYGON_SIZE_SCALE);
+        memcpy(polygon->x, old_x, sizeof(double) * polygon->num_vertices);
+        memcpy(polygon->y, old_y, sizeof(double) * polygon->num_vertices);
+        if (!polygon->arena) {
+            free(old_x);
+        }
+    }
+
+    polygon->x[polygon->num_vertices] = vertex.x;
+    polygon->y[polygon->num_vertices] = vertex.y;
+    polygon->num_vertices++;
+}
+
+double polygon_area(polygon_t *polygon) {
+    size_t n = polygon->num_vertices;
     double area = 0;
-    for (size_t i = 0; i < list_size(polygon); i++) {
-        vector_t *vector1 = list_get(polygon, i);
-        vector_t *vector2 = list_get(polygon, (i + 1) % list_size(polygon));
-        area += vec_cross(*vector1, *vector2);
+    for (size_t i = 0; i < n; i++) {
+        size_t j = (i + 1) % n;
+        area += polygon->x[i] * polygon->y[j] - polygon->y[i] * polygon->x[j];
     }
     return 0.5 * fabs(area);
 }
 
-vector_t polygon_centroid(list_t *polygon) {
+vector_t polygon_centroid(polygon_t *polygon) {
+    size_t n = polygon->num_vertices;
     double c_x = 0;
     double c_y = 0;
+    // The signed area, so clockwise polygons (negative area) also come out right
+    double area = 0;
 
-    for (size_t i = 0; i < list_size(polygon); i++) {
-        vector_t *vector1 = list_get(polygon, i);
-        vector_t *vector2 = list_get(polygon, (i + 1) % list_size(polygon));
+    for (size_t i = 0; i < n; i++) {
+        size_t j = (i + 1) % n;
+        double cross = polygon->x[i] * polygon->y[j] - polygon->y[i] * polygon->x[j];
 
-        c_x += (vector1->x + vector2->x) * vec_cross(*vector1, *vector2);
-        c_y += (vector1->y + vector2->y) * vec_cross(*vector1, *vector2);       
+        c_x += (polygon->x[i] + polygon->x[j]) * cross;
+        c_y += (polygon->y[i] + polygon->y[j]) * cross;
+        area += 0.5 * cross;
     }
 
-    vector_t centroid = {.x = 1 / (6 * polygon_area(polygon)) * c_x, 
-                         .y = 1 / (6 * polygon_area(polygon)) * c_y};
+    vector_t centroid = {.x = 1 / (6 * area) * c_x, 
+                         .y = 1 / (6 * area) * c_y};
     return centroid;
 }
 
-void polygon_translate(list_t *polygon, vector_t translation) {
-    for (size_t i = 0; i < list_size(polygon); i++) {
-        vector_t *v = list_get(polygon, i);
-        *v = vec_add(*v, translation);
+void polygon_edge_normals(polygon_t *polygon, polygon_t *normals) {
+    assert(polygon);
+    assert(normals);
+
+    size_t n = polygon->num_vertices;
+    normals->num_vertices = 0;
+    for (size_t i = 0; i < n; i++) {
+        size_t j = (i + 1) % n;
+        vector_t edge = vec_unit((vector_t){.x = polygon->x[i] - polygon->x[j],
+                                            .y = polygon->y[i] - polygon->y[j]});
+        // The edge rotated a quarter turn counterclockwise
+        polygon_add_vertex(normals, (vector_t){.x = -edge.y, .y = edge.x});
     }
 }
 
-void polygon_rotate(list_t *polygon, double angle, vector_t point) {
-    // Translate all vertices so that point is the origin
-    polygon_translate(polygon, vec_negate(point));
-    // Rotate about the point
-    for (size_t i = 0; i < list_size(polygon); i++) {
-        vector_t *v = list_get(polygon, i);
-        *v = vec_rotate(*v, angle);
-    }
-    // Return to (0, 0) origin
-    polygon_translate(polygon, point);
+void polygon_translate(polygon_t *polygon, vector_t translation) {
+    vec_batch_translate(polygon->x, polygon->y, polygon->num_vertices, translation);
+}
+
+void polygon_rotate(polygon_t *polygon, double angle, vector_t point) {
+    vec_batch_rotate(polygon->x, polygon->y, polygon->num_vertices, cos(angle), sin(angle), point);
 }
\ No newline at end of file
@@ -1,6 +1,14 @@
+#include "aabb_tree.h"
+#include "arena.h"
+#include "physics_store.h"
 #include "scene.h"
+#include "spatial_grid.h"
+#include "sweep_prune.h"
+#include "thread_pool.h"
 #include <assert.h>
+#include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -8,28 +16,240 @@ const size_t SCENE_INIT_MAX_BODIES = 10;
 const size_t SCENE_INIT_FORCE_FUNC_COUNT = 10;
 const size_t SCENE_INIT_NUM_LAYERS = 2;
 const size_t SCENE_DEFAULT_LAYER = 1;
-
-typedef struct scene {
-    list_t *layers;
-    size_t num_layers;
-    list_t *force_funcs;
-    vector_t dimensions;
-    bool paused;
-} scene_t;
+// A level builds a few megabytes of bodies, shapes and force data
+const size_t SCENE_ARENA_BLOCK_SIZE = 1 << 18;
+// Dead force records are compacted away once they outnumber the live ones
+const size_t SCENE_FORCE_COMPACT_MIN = 64;
+const size_t SCENE_MAX_COLLISION_GROUPS = 32;
+// A bit larger than a car, so most bodies touch only a few cells
+const double SCENE_DEFAULT_GRID_CELL_SIZE = 128;
+// The fewest narrow phase tests worth waking another thread for
+const size_t SCENE_NARROW_PHASE_GRAIN = 64;
+// How far the bounding volume trees' fat boxes reach beyond the bodies' boxes,
+// and how many seconds of a body's motion they cover on top of that
+const double SCENE_TREE_MARGIN = 8;
+const double SCENE_TREE_LOOKAHEAD = 0.1;
 
 typedef struct force_struct {
     force_creator_t forcer;
     void *aux;
     free_func_t freer;
-    list_t *bodies;
+    // Allocated from the scene arena
+    body_t **bodies;
+    size_t num_bodies;
+    // Set once one of the bodies is removed; skipped until compacted away
+    bool dead;
 } force_struct_t;
 
+// The built-in force kinds, each kept in its own array, and custom force creators
+typedef enum force_kind {
+    FORCE_KIND_CUSTOM,
+    FORCE_KIND_DRAG,
+    FORCE_KIND_ACCELERATION,
+    FORCE_KIND_SPRING,
+    FORCE_KIND_GRAVITY
+} force_kind_t;
+
+// A force on one body proportional to its velocity
+typedef struct drag_force {
+    body_t *body;
+    double gamma;
+    bool dead;
+} drag_force_t;
+
+// A force on one body proportional to its mass
+typedef struct acceleration_force {
+    body_t *body;
+    vector_t acceleration;
+    bool dead;
+} acceleration_force_t;
+
+// A force pulling two bodies together: k * r for a spring,
+// G * m1 * m2 / r^2 for gravity (which is skipped within min_distance)
+typedef struct pair_force {
+    body_t *body1;
+    body_t *body2;
+    double coef;
+    double min_distance;
+    bool dead;
+} pair_force_t;
+
+// Which force record in which array
+typedef struct force_ref {
+    force_kind_t kind;
+    size_t index;
+} force_ref_t;
+
+ARRAY_DECLARE(index_array, size_t)
+ARRAY_DECLARE(drag_force_array, drag_force_t)
+ARRAY_DECLARE(acceleration_force_array, acceleration_force_t)
+ARRAY_DECLARE(pair_force_array, pair_force_t)
+ARRAY_DECLARE(force_ref_array, force_ref_t)
+
+// What the scene knows about a body, indexed by the body's pool index
+typedef struct body_record {
+    // The layer the body is in, or SIZE_MAX if it is not in one
+    size_t layer;
+    // The force records acting on the body; may include records that have since died
+    force_ref_array_t forces;
+    // Bit g is set if the body is in collision group g
+    uint32_t groups;
+    // Indices into the scene's contact pairs of the pairs the body is in
+    index_array_t pairs;
+    // Counts the bodies that joined the scene before this one, so pairs are put
+    // in the same order whichever pool slots the bodies happen to get
+    uint64_t order;
+} body_record_t;
+
+ARRAY_DECLARE(aabb_array, aabb_t)
+
+typedef struct collision_group {
+    body_array_t members;
+    // Bumped whenever a member is added or removed, or a static member is moved
+    size_t version;
+    // The members' bounding boxes, computed at most once per tick
+    aabb_array_t boxes;
+    size_t boxes_tick;
+    // For the grid broadphase: the indices in members of the static and dynamic members.
+    // The static members rarely move, so their grid is only rebuilt when the version changes;
+    // the dynamic members' grid is rebuilt at most once per tick.
+    index_array_t static_ranks;
+    index_array_t dynamic_ranks;
+    spatial_grid_t *static_grid;
+    size_t static_version;
+    spatial_grid_t *grid;
+    size_t grid_tick;
+    // For the tree broadphase and scene_query_box(): a tree of the members' boxes,
+    // NULL until first needed, with each member's proxy in it and each proxy's member
+    aabb_tree_t *tree;
+    index_array_t proxies;
+    index_array_t proxy_ranks;
+    // The scene's move count when the tree was last brought up to date
+    size_t tree_moves;
+} collision_group_t;
+
+// A pair of bodies a collision rule was run on. Each unordered pair
+// is registered at most once per rule, with body1 the one that joined the scene first.
+// Pairs stay registered for as long as the broadphase keeps finding them.
+typedef struct contact_pair {
+    body_t *body1;
+    body_t *body2;
+    size_t rule;
+    // The last tick the rule was run on the pair
+    size_t tick;
+    // What the rule returned that tick
+    bool touching;
+    // The axis that last separated the pair, for the rule's narrow phase
+    separating_axis_t hint;
+} contact_pair_t;
+
+ARRAY_DECLARE(contact_pair_array, contact_pair_t)
+ARRAY_DECLARE(contact_array, contact_t)
+
+// A pair the broadphase found for the rule being run, waiting for its narrow phase test
+typedef struct narrow_test {
+    body_t *body1;
+    body_t *body2;
+    // The pair's index in the scene's contact pairs
+    size_t pair;
+} narrow_test_t;
+
+ARRAY_DECLARE(narrow_test_array, narrow_test_t)
+
+typedef struct collision_rule_struct {
+    size_t group1;
+    size_t group2;
+    collision_rule_t rule;
+    contact_handler_t handler;
+    void *aux;
+    free_func_t freer;
+    // The rule's index in the scene
+    size_t id;
+    // For the sweep and prune broadphase, and the group versions it was last updated with
+    sweep_prune_t *sap;
+    size_t group1_version;
+    size_t group2_version;
+    // The contacts found this tick, waiting to be dispatched to handler
+    contact_array_t contacts;
+} collision_rule_struct_t;
+
+// An entry of the category handler table. Both orders of a pair of categories
+// share a handler; the mirrored entry is marked swapped and doesn't own aux.
+typedef struct category_handler {
+    contact_handler_t handler;
+    void *aux;
+    free_func_t freer;
+    bool swapped;
+} category_handler_t;
+
+ARRAY_DECLARE(layer_array, body_array_t)
+ARRAY_DECLARE(force_array, force_struct_t)
+ARRAY_DECLARE(body_record_array, body_record_t)
+ARRAY_DECLARE(collision_group_array, collision_group_t)
+ARRAY_DECLARE(collision_rule_array, collision_rule_struct_t)
+
+typedef struct scene {
+    layer_array_t layers;
+    // The non-static bodies of each layer, in the same order; these are the ones ticked
+    layer_array_t dynamic_layers;
+    force_array_t force_funcs;
+    drag_force_array_t drag_forces;
+    acceleration_force_array_t acceleration_forces;
+    pair_force_array_t spring_forces;
+    pair_force_array_t gravity_forces;
+    // Counts the dead records in all the force arrays
+    size_t num_dead_forces;
+    body_record_array_t records;
+    // Bodies marked by body_remove() since the last tick
+    body_array_t removed;
+    // Static bodies moved since their groups last heard of it
+    body_array_t static_moved;
+    collision_group_array_t groups;
+    collision_rule_array_t collision_rules;
+    contact_pair_array_t pairs;
+    // BODY_NUM_CATEGORIES x BODY_NUM_CATEGORIES handlers, indexed by the categories
+    // of body1 and body2; NULL until scene_set_category_handler() is first called
+    category_handler_t *category_handlers;
+    // The size of the contact buffer on the last tick
+    size_t num_contacts;
+    scene_broadphase_t broadphase;
+    double grid_cell_size;
+    size_t tick_count;
+    // Bumped whenever bodies may have moved since the last bump:
+    // once each tick before finding contacts and once after moving the bodies
+    size_t move_count;
+    // The number of bodies that have joined the scene (see body_record_t)
+    uint64_t num_joined;
+    // Scratch space for merging grid query results and sorting tree query results
+    index_array_t candidates;
+    // What scene_query_box() last found
+    body_array_t query_results;
+    narrow_test_array_t narrow_tests;
+    // NULL unless the scene tests pairs on several threads. Each thread but the
+    // calling one writes its contacts and collision stats to its own slot,
+    // which are merged in thread order.
+    thread_pool_t *pool;
+    contact_array_t *thread_contacts;
+    collision_stats_t *thread_stats;
+    vector_t dimensions;
+    // Drawn beneath the bodies of terrain_layer; NULL if the scene has none
+    terrain_t *terrain;
+    size_t terrain_layer;
+    bool paused;
+    arena_t *arena;
+    // NULL unless the scene was created with soa_physics
+    physics_store_t *physics;
+} scene_t;
+
 void scene_add_layer(scene_t *scene) {
     assert(scene);
 
-    list_t *new_layer = list_init(SCENE_INIT_MAX_BODIES, (free_func_t) body_free);
-    list_add(scene->layers, new_layer);
-    scene->num_layers++;
+    body_array_t new_layer;
+    body_array_init(&new_layer, SCENE_INIT_MAX_BODIES);
+    layer_array_add(&scene->layers, new_layer);
+    body_array_t new_dynamic_layer;
+    body_array_init(&new_dynamic_layer, SCENE_INIT_MAX_BODIES);
+    layer_array_add(&scene->dynamic_layers, new_dynamic_layer);
 }
 
 void scene_add_n_layers(scene_t *scene, size_t n) {
@@ -46,60 +266,226 @@ void scene_free_force_func(force_struct_t *f) {
     if (f->freer) {
         f->freer(f->aux);
     }
-
-    list_free(f->bodies);
-
-    free(f);
 }
 
 scene_t *scene_init(vector_t dimensions) {
+    scene_options_t options = {.soa_physics = false, .broadphase = SCENE_BROADPHASE_GRID,
+                               .grid_cell_size = 0, .num_threads = 1};
+    return scene_init_with_options(dimensions, options);
+}
+
+scene_t *scene_init_with_options(vector_t dimensions, scene_options_t options) {
     assert(dimensions.x > 0);
     assert(dimensions.y > 0);
 
     scene_t *new_scene = malloc(sizeof(scene_t));
     assert(new_scene);
 
-    list_t *layers = list_init(SCENE_INIT_NUM_LAYERS, (free_func_t) list_free);
-    list_t *force_funcs = list_init(SCENE_INIT_FORCE_FUNC_COUNT, 
-                                   (free_func_t) scene_free_force_func);
-
-    new_scene->layers = layers;
-    new_scene->num_layers = 0;
-    new_scene->force_funcs = force_funcs;
+    layer_array_init(&new_scene->layers, SCENE_INIT_NUM_LAYERS);
+    layer_array_init(&new_scene->dynamic_layers, SCENE_INIT_NUM_LAYERS);
+    force_array_init(&new_scene->force_funcs, SCENE_INIT_FORCE_FUNC_COUNT);
+    drag_force_array_init(&new_scene->drag_forces, 0);
+    acceleration_force_array_init(&new_scene->acceleration_forces, 0);
+    pair_force_array_init(&new_scene->spring_forces, 0);
+    pair_force_array_init(&new_scene->gravity_forces, 0);
+    new_scene->num_dead_forces = 0;
+    body_record_array_init(&new_scene->records, SCENE_INIT_MAX_BODIES);
+    body_array_init(&new_scene->removed, SCENE_INIT_MAX_BODIES);
+    body_array_init(&new_scene->static_moved, 0);
+    collision_group_array_init(&new_scene->groups, 0);
+    collision_rule_array_init(&new_scene->collision_rules, 0);
+    contact_pair_array_init(&new_scene->pairs, 0);
+    new_scene->category_handlers = NULL;
+    new_scene->num_contacts = 0;
+    new_scene->broadphase = options.broadphase;
+    new_scene->grid_cell_size = options.grid_cell_size > 0
+        ? options.grid_cell_size
+        : SCENE_DEFAULT_GRID_CELL_SIZE;
+    new_scene->tick_count = 0;
+    new_scene->move_count = 0;
+    new_scene->num_joined = 0;
+    index_array_init(&new_scene->candidates, 0);
+    body_array_init(&new_scene->query_results, 0);
     new_scene->dimensions = dimensions;
+    new_scene->terrain = NULL;
+    new_scene->terrain_layer = 0;
     new_scene->paused = false;
+    new_scene->arena = arena_init(SCENE_ARENA_BLOCK_SIZE);
+    new_scene->physics = options.soa_physics ? physics_store_init(SCENE_INIT_MAX_BODIES) : NULL;
+    narrow_test_array_init(&new_scene->narrow_tests, 0);
+    new_scene->pool = NULL;
+    new_scene->thread_contacts = NULL;
+    new_scene->thread_stats = NULL;
+    if (options.num_threads > 1) {
+        new_scene->pool = thread_pool_init(options.num_threads);
+        new_scene->thread_contacts = malloc(sizeof(contact_array_t) * options.num_threads);
+        assert(new_scene->thread_contacts);
+        new_scene->thread_stats = calloc(options.num_threads, sizeof(collision_stats_t));
+        assert(new_scene->thread_stats);
+        for (size_t i = 0; i < options.num_threads; i++) {
+            contact_array_init(&new_scene->thread_contacts[i], 0);
+        }
+    }
 
     scene_add_n_layers(new_scene, SCENE_INIT_NUM_LAYERS);
 
     return new_scene;
 }
 
+// Gets the scene's record for a body, adding records up to its pool index if needed
+body_record_t *scene_body_record(scene_t *scene, body_t *body) {
+    size_t idx = body_get_handle(body).index;
+    while (body_record_array_size(&scene->records) <= idx) {
+        body_record_t record = {.layer = SIZE_MAX, .groups = 0, .order = 0};
+        force_ref_array_init(&record.forces, 0);
+        index_array_init(&record.pairs, 0);
+        body_record_array_add(&scene->records, record);
+    }
+    return body_record_array_get(&scene->records, idx);
+}
+
 void scene_free(scene_t *scene) {
     assert(scene);
 
-    list_free(scene->layers);
-    list_free(scene->force_funcs);
+    ARRAY_FOR_EACH(force_struct_t, force, &scene->force_funcs) {
+        if (!force->dead) {
+            scene_free_force_func(force);
+        }
+    }
+    force_array_free(&scene->force_funcs);
+    drag_force_array_free(&scene->drag_forces);
+    acceleration_force_array_free(&scene->acceleration_forces);
+    pair_force_array_free(&scene->spring_forces);
+    pair_force_array_free(&scene->gravity_forces);
+    // Returns the bodies only in collision groups to the body pool; the layers' bodies
+    // are freed below. Each is gathered once, from the first group it is found in,
+    // and freed after, since the other groups still point at it.
+    body_array_clear(&scene->removed);
+    ARRAY_FOR_EACH(collision_group_t, group, &scene->groups) {
+        ARRAY_FOR_EACH(body_t *, body, &group->members) {
+            body_record_t *record = scene_body_record(scene, *body);
+            if (record->layer == SIZE_MAX && record->groups != 0) {
+                record->groups = 0;
+                body_array_add(&scene->removed, *body);
+            }
+        }
+    }
+    ARRAY_FOR_EACH(body_t *, body, &scene->removed) {
+        body_free(*body);
+    }
+    ARRAY_FOR_EACH(body_record_t, record, &scene->records) {
+        force_ref_array_free(&record->forces);
+        index_array_free(&record->pairs);
+    }
+    body_record_array_free(&scene->records);
+    body_array_free(&scene->removed);
+    body_array_free(&scene->static_moved);
+    ARRAY_FOR_EACH(collision_group_t, group, &scene->groups) {
+        body_array_free(&group->members);
+        aabb_array_free(&group->boxes);
+        index_array_free(&group->static_ranks);
+        index_array_free(&group->dynamic_ranks);
+        spatial_grid_free(group->static_grid);
+        spatial_grid_free(group->grid);
+        if (group->tree) {
+            aabb_tree_free(group->tree);
+        }
+        index_array_free(&group->proxies);
+        index_array_free(&group->proxy_ranks);
+    }
+    collision_group_array_free(&scene->groups);
+    ARRAY_FOR_EACH(collision_rule_struct_t, rule, &scene->collision_rules) {
+        if (rule->freer) {
+            rule->freer(rule->aux);
+        }
+        if (rule->sap) {
+            sweep_prune_free(rule->sap);
+        }
+        contact_array_free(&rule->contacts);
+    }
+    collision_rule_array_free(&scene->collision_rules);
+    if (scene->category_handlers) {
+        for (size_t i = 0; i < BODY_NUM_CATEGORIES * BODY_NUM_CATEGORIES; i++) {
+            category_handler_t *entry = &scene->category_handlers[i];
+            if (entry->handler && !entry->swapped && entry->freer) {
+                entry->freer(entry->aux);
+            }
+        }
+        free(scene->category_handlers);
+    }
+    contact_pair_array_free(&scene->pairs);
+    index_array_free(&scene->candidates);
+    body_array_free(&scene->query_results);
+    narrow_test_array_free(&scene->narrow_tests);
+    if (scene->pool) {
+        for (size_t i = 0; i < thread_pool_num_threads(scene->pool); i++) {
+            contact_array_free(&scene->thread_contacts[i]);
+        }
+        free(scene->thread_contacts);
+        free(scene->thread_stats);
+        thread_pool_free(scene->pool);
+    }
+
+    // Returns the bodies to the body pool; arena shapes go with the arena below
+    ARRAY_FOR_EACH(body_array_t, layer, &scene->layers) {
+        ARRAY_FOR_EACH(body_t *, body, layer) {
+            body_free(*body);
+        }
+        body_array_free(layer);
+    }
+    layer_array_free(&scene->layers);
+    ARRAY_FOR_EACH(body_array_t, layer, &scene->dynamic_layers) {
+        body_array_free(layer);
+    }
+    layer_array_free(&scene->dynamic_layers);
+
+    if (scene->terrain) {
+        terrain_free(scene->terrain);
+    }
+    if (scene->physics) {
+        physics_store_free(scene->physics);
+    }
+    arena_free(scene->arena);
     free(scene);
 }
 
+void *scene_alloc(scene_t *scene, size_t size) {
+    assert(scene);
+
+    return arena_alloc(scene->arena, size);
+}
+
+void scene_begin_build(scene_t *scene) {
+    assert(scene);
+
+    arena_set_current(scene->arena);
+}
+
+void scene_end_build(scene_t *scene) {
+    assert(scene);
+
+    if (arena_get_current() == scene->arena) {
+        arena_set_current(NULL);
+    }
+}
+
 size_t scene_num_layers(scene_t *scene) {
     assert(scene);
 
-    return(scene->num_layers);
+    return layer_array_size(&scene->layers);
 }
 
-list_t *scene_get_layer(scene_t *scene, size_t idx) {
+body_array_t *scene_get_layer(scene_t *scene, size_t idx) {
     assert(scene);
-    assert(idx < scene->num_layers);
 
-    return (list_t *)list_get(scene->layers, idx);
+    return layer_array_get(&scene->layers, idx);
 }
 
 size_t scene_num_bodies(scene_t *scene) {
     assert(scene);
     size_t num_bodies = 0;
-    for (size_t i = 0; i < scene->num_layers; i++) {
-        num_bodies += list_size(scene_get_layer(scene, i));
+    ARRAY_FOR_EACH(body_array_t, layer, &scene->layers) {
+        num_bodies += body_array_size(layer);
     }
     return num_bodies;
 }
@@ -108,20 +494,41 @@ void scene_add_body(scene_t *scene, body_t *body) {
     assert(scene);
     assert(body);
 
-    list_t *default_layer = scene_get_layer(scene, SCENE_DEFAULT_LAYER);
-    list_add(default_layer, body);
+    scene_add_body_in_layer(scene, body, SCENE_DEFAULT_LAYER);
+}
+
+// Gets a body's record, numbering the body if it is not yet in a layer or group
+body_record_t *scene_join_body(scene_t *scene, body_t *body) {
+    body_record_t *record = scene_body_record(scene, body);
+    if (record->layer == SIZE_MAX && record->groups == 0) {
+        record->order = scene->num_joined++;
+        body_set_removal_queue(body, &scene->removed);
+        body_set_move_queue(body, &scene->static_moved);
+        if (body_is_removed(body)) {
+            body_array_add(&scene->removed, body);
+        }
+    }
+    return record;
 }
 
 void scene_add_body_in_layer(scene_t *scene, body_t *body, size_t layer_no) {
     assert(scene);
     assert(body);
     
-    while (layer_no >= scene->num_layers) {
+    while (layer_no >= scene_num_layers(scene)) {
         scene_add_layer(scene);
     }
     
-    list_t *layer = scene_get_layer(scene, layer_no);
-    list_add(layer, body);
+    body_array_add(scene_get_layer(scene, layer_no), body);
+    if (!body_is_static(body)) {
+        body_array_add(layer_array_get(&scene->dynamic_layers, layer_no), body);
+        if (scene->physics) {
+            physics_store_add(scene->physics, body);
+        }
+    }
+    // Nothing to interpolate from until the body has been ticked
+    body_save_previous_state(body);
+    scene_join_body(scene, body)->layer = layer_no;
 }
 
 vector_t scene_get_dimensions(scene_t *scene) {
@@ -138,72 +545,555 @@ void scene_set_dimensions(scene_t *scene, vector_t dimensions) {
     scene->dimensions = dimensions;
 }
 
+void scene_set_terrain(scene_t *scene, terrain_t *terrain, size_t layer_no) {
+    assert(scene);
+
+    if (scene->terrain) {
+        terrain_free(scene->terrain);
+    }
+    while (layer_no >= scene_num_layers(scene)) {
+        scene_add_layer(scene);
+    }
+    scene->terrain = terrain;
+    scene->terrain_layer = layer_no;
+}
+
+terrain_t *scene_get_terrain(scene_t *scene) {
+    assert(scene);
+
+    return scene->terrain;
+}
+
+size_t scene_get_terrain_layer(scene_t *scene) {
+    assert(scene);
+
+    return scene->terrain_layer;
+}
+
+collision_group_t *scene_get_collision_group(scene_t *scene, size_t group) {
+    assert(group < SCENE_MAX_COLLISION_GROUPS);
+
+    while (collision_group_array_size(&scene->groups) <= group) {
+        collision_group_t new_group;
+        body_array_init(&new_group.members, SCENE_INIT_MAX_BODIES);
+        new_group.version = 0;
+        aabb_array_init(&new_group.boxes, 0);
+        new_group.boxes_tick = 0;
+        index_array_init(&new_group.static_ranks, 0);
+        index_array_init(&new_group.dynamic_ranks, 0);
+        new_group.static_grid = spatial_grid_init(scene->grid_cell_size);
+        new_group.static_version = SIZE_MAX;
+        new_group.grid = spatial_grid_init(scene->grid_cell_size);
+        new_group.grid_tick = 0;
+        new_group.tree = NULL;
+        index_array_init(&new_group.proxies, 0);
+        index_array_init(&new_group.proxy_ranks, 0);
+        new_group.tree_moves = 0;
+        collision_group_array_add(&scene->groups, new_group);
+    }
+    return collision_group_array_get(&scene->groups, group);
+}
+
+void scene_add_to_collision_group(scene_t *scene, body_t *body, size_t group) {
+    assert(scene);
+    assert(body);
+    assert(group < SCENE_MAX_COLLISION_GROUPS);
+
+    body_record_t *record = scene_join_body(scene, body);
+    uint32_t bit = (uint32_t)1 << group;
+    if (record->groups & bit) {
+        return;
+    }
+    record->groups |= bit;
+
+    collision_group_t *g = scene_get_collision_group(scene, group);
+    body_array_add(&g->members, body);
+    // The new member is not in the boxes yet
+    g->version++;
+    g->boxes_tick = 0;
+    g->grid_tick = 0;
+}
+
+void scene_add_collision_rule(scene_t *scene, size_t group1, size_t group2,
+                              collision_rule_t rule, contact_handler_t handler,
+                              void *aux, free_func_t freer) {
+    assert(scene);
+    assert(rule);
+
+    scene_get_collision_group(scene, group1);
+    scene_get_collision_group(scene, group2);
+
+    collision_rule_struct_t r = {.group1 = group1, .group2 = group2,
+                                 .rule = rule, .handler = handler, .aux = aux, .freer = freer,
+                                 .id = collision_rule_array_size(&scene->collision_rules),
+                                 .sap = NULL, .group1_version = 0, .group2_version = 0};
+    if (scene->broadphase == SCENE_BROADPHASE_SWEEP_PRUNE) {
+        r.sap = sweep_prune_init();
+    }
+    contact_array_init(&r.contacts, 0);
+    collision_rule_array_add(&scene->collision_rules, r);
+}
+
+void scene_set_category_handler(scene_t *scene, size_t category1, size_t category2,
+                                 contact_handler_t handler, void *aux, free_func_t freer) {
+    assert(scene);
+    assert(category1 < BODY_NUM_CATEGORIES);
+    assert(category2 < BODY_NUM_CATEGORIES);
+    assert(handler);
+
+    if (!scene->category_handlers) {
+        scene->category_handlers = calloc(BODY_NUM_CATEGORIES * BODY_NUM_CATEGORIES,
+                                          sizeof(category_handler_t));
+        assert(scene->category_handlers);
+    }
+    category_handler_t *entry =
+        &scene->category_handlers[category1 * BODY_NUM_CATEGORIES + category2];
+    category_handler_t *mirror =
+        &scene->category_handlers[category2 * BODY_NUM_CATEGORIES + category1];
+    assert(!entry->handler);
+    *entry = (category_handler_t){.handler = handler, .aux = aux, .freer = freer,
+                                  .swapped = false};
+    if (mirror != entry) {
+        *mirror = (category_handler_t){.handler = handler, .aux = aux, .freer = NULL,
+                                       .swapped = true};
+    }
+}
+
 void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
                                     void *aux, list_t *bodies, free_func_t freer) {
     assert(scene);
+    assert(bodies);
+
+    size_t num_bodies = list_size(bodies);
+    body_t **body_arr = scene_alloc(scene, sizeof(body_t *) * num_bodies);
+    for (size_t i = 0; i < num_bodies; i++) {
+        body_arr[i] = list_get(bodies, i);
+    }
+    list_free(bodies);
+
+    scene_add_n_bodies_force_creator(scene, forcer, aux, body_arr, num_bodies, freer);
+}
+
+// Points a body's record at a force record acting on it
+void scene_add_force_ref(scene_t *scene, body_t *body, force_kind_t kind, size_t index) {
+    force_ref_t ref = {.kind = kind, .index = index};
+    force_ref_array_add(&scene_body_record(scene, body)->forces, ref);
+}
+
+void scene_add_n_bodies_force_creator(scene_t *scene, force_creator_t forcer, void *aux,
+                                      body_t **bodies, size_t num_bodies, free_func_t freer) {
+    assert(scene);
     assert(forcer);
     assert(aux);
     assert(bodies);
 
-    force_struct_t *f = malloc(sizeof(force_struct_t));
-    assert(f);
-    f->forcer = forcer;
-    f->aux = aux;
-    f->bodies = bodies;
-    f->freer = freer;
-    list_add(scene->force_funcs, f);
+    size_t idx = force_array_size(&scene->force_funcs);
+    force_struct_t f = {.forcer = forcer, .aux = aux, .freer = freer,
+                        .bodies = bodies, .num_bodies = num_bodies, .dead = false};
+    force_array_add(&scene->force_funcs, f);
+    for (size_t i = 0; i < num_bodies; i++) {
+        scene_add_force_ref(scene, bodies[i], FORCE_KIND_CUSTOM, idx);
+    }
 }
 
-void scene_delete_bodies_and_forces(scene_t *scene) {
+void scene_add_drag(scene_t *scene, double gamma, body_t *body) {
+    assert(scene);
+    assert(body);
+
+    drag_force_t f = {.body = body, .gamma = gamma, .dead = false};
+    scene_add_force_ref(scene, body, FORCE_KIND_DRAG, drag_force_array_size(&scene->drag_forces));
+    drag_force_array_add(&scene->drag_forces, f);
+}
+
+void scene_add_acceleration(scene_t *scene, vector_t acceleration, body_t *body) {
+    assert(scene);
+    assert(body);
+
+    acceleration_force_t f = {.body = body, .acceleration = acceleration, .dead = false};
+    scene_add_force_ref(scene, body, FORCE_KIND_ACCELERATION,
+                        acceleration_force_array_size(&scene->acceleration_forces));
+    acceleration_force_array_add(&scene->acceleration_forces, f);
+}
+
+// Adds a spring or gravity record to one of the pair force arrays
+void scene_add_pair_force(scene_t *scene, force_kind_t kind, pair_force_array_t *forces,
+                          pair_force_t f) {
+    size_t idx = pair_force_array_size(forces);
+    pair_force_array_add(forces, f);
+    scene_add_force_ref(scene, f.body1, kind, idx);
+    scene_add_force_ref(scene, f.body2, kind, idx);
+}
+
+void scene_add_spring(scene_t *scene, double k, body_t *body1, body_t *body2) {
+    assert(scene);
+    assert(body1);
+    assert(body2);
+
+    pair_force_t f = {.body1 = body1, .body2 = body2, .coef = k, .min_distance = 0,
+                      .dead = false};
+    scene_add_pair_force(scene, FORCE_KIND_SPRING, &scene->spring_forces, f);
+}
+
+void scene_add_gravity(scene_t *scene, double G, double min_distance,
+                       body_t *body1, body_t *body2) {
     assert(scene);
+    assert(body1);
+    assert(body2);
+    assert(min_distance >= 0);
+
+    pair_force_t f = {.body1 = body1, .body2 = body2, .coef = G, .min_distance = min_distance,
+                      .dead = false};
+    scene_add_pair_force(scene, FORCE_KIND_GRAVITY, &scene->gravity_forces, f);
+}
 
-    for (size_t i = 0; i < scene->num_layers; i++) {
-        list_t *layer = scene_get_layer(scene, i);
-        size_t body_idx = 0;
-        while (body_idx < list_size(layer)) {
-            body_t *body = (body_t *)list_get(layer, body_idx);
-            if (body_is_removed(body)) {
-                list_remove(layer, body_idx);
-
-                size_t force_funcs_idx = 0;
-                while (force_funcs_idx < list_size(scene->force_funcs)) {
-                    force_struct_t *force = list_get(scene->force_funcs, force_funcs_idx);
-
-                    bool removed = false;
-                    for (size_t i = 0; i < list_size(force->bodies); i++) {
-                        body_t *b = list_get(force->bodies, i);
-                        if (body == b) {
-                            list_remove(scene->force_funcs, force_funcs_idx);
-                            scene_free_force_func(force);
-                            removed = true;
-                            break;
-                        }
-                    }
-                    if (!removed) {
-                        force_funcs_idx++;
-                    }
-                }
-
-                body_free(body);
+// Marks a force record dead, freeing a custom force creator's aux.
+// Its slot stays in place, so the other bodies' references to it remain valid.
+void scene_kill_force(scene_t *scene, force_ref_t ref) {
+    bool *dead = NULL;
+    switch (ref.kind) {
+        case FORCE_KIND_CUSTOM: {
+            force_struct_t *f = force_array_get(&scene->force_funcs, ref.index);
+            if (!f->dead) {
+                scene_free_force_func(f);
+            }
+            dead = &f->dead;
+            break;
+        }
+        case FORCE_KIND_DRAG: {
+            dead = &drag_force_array_get(&scene->drag_forces, ref.index)->dead;
+            break;
+        }
+        case FORCE_KIND_ACCELERATION: {
+            dead = &acceleration_force_array_get(&scene->acceleration_forces, ref.index)->dead;
+            break;
+        }
+        case FORCE_KIND_SPRING: {
+            dead = &pair_force_array_get(&scene->spring_forces, ref.index)->dead;
+            break;
+        }
+        case FORCE_KIND_GRAVITY: {
+            dead = &pair_force_array_get(&scene->gravity_forces, ref.index)->dead;
+            break;
+        }
+    }
+    assert(dead);
+    if (!*dead) {
+        *dead = true;
+        scene->num_dead_forces++;
+    }
+}
+
+// remove_if() predicates: drop force records that have died
+bool scene_force_is_dead(force_struct_t *force, void *aux) {
+    return force->dead;
+}
+
+bool scene_drag_force_is_dead(drag_force_t *force, void *aux) {
+    return force->dead;
+}
+
+bool scene_acceleration_force_is_dead(acceleration_force_t *force, void *aux) {
+    return force->dead;
+}
+
+bool scene_pair_force_is_dead(pair_force_t *force, void *aux) {
+    return force->dead;
+}
+
+// Re-adds the references to a compacted array of pair forces
+void scene_add_pair_force_refs(scene_t *scene, force_kind_t kind, pair_force_array_t *forces) {
+    for (size_t i = 0; i < pair_force_array_size(forces); i++) {
+        pair_force_t *f = pair_force_array_get(forces, i);
+        scene_add_force_ref(scene, f->body1, kind, i);
+        scene_add_force_ref(scene, f->body2, kind, i);
+    }
+}
+
+// Drops the dead force records, then points the bodies' records at the new indices
+void scene_compact_forces(scene_t *scene) {
+    force_array_remove_if(&scene->force_funcs, scene_force_is_dead, NULL);
+    drag_force_array_remove_if(&scene->drag_forces, scene_drag_force_is_dead, NULL);
+    acceleration_force_array_remove_if(&scene->acceleration_forces,
+                                       scene_acceleration_force_is_dead, NULL);
+    pair_force_array_remove_if(&scene->spring_forces, scene_pair_force_is_dead, NULL);
+    pair_force_array_remove_if(&scene->gravity_forces, scene_pair_force_is_dead, NULL);
+    scene->num_dead_forces = 0;
+
+    ARRAY_FOR_EACH(body_record_t, record, &scene->records) {
+        force_ref_array_clear(&record->forces);
+    }
+    for (size_t i = 0; i < force_array_size(&scene->force_funcs); i++) {
+        force_struct_t *f = force_array_get(&scene->force_funcs, i);
+        for (size_t j = 0; j < f->num_bodies; j++) {
+            scene_add_force_ref(scene, f->bodies[j], FORCE_KIND_CUSTOM, i);
+        }
+    }
+    for (size_t i = 0; i < drag_force_array_size(&scene->drag_forces); i++) {
+        scene_add_force_ref(scene, drag_force_array_get(&scene->drag_forces, i)->body,
+                            FORCE_KIND_DRAG, i);
+    }
+    for (size_t i = 0; i < acceleration_force_array_size(&scene->acceleration_forces); i++) {
+        scene_add_force_ref(scene,
+                            acceleration_force_array_get(&scene->acceleration_forces, i)->body,
+                            FORCE_KIND_ACCELERATION, i);
+    }
+    scene_add_pair_force_refs(scene, FORCE_KIND_SPRING, &scene->spring_forces);
+    scene_add_pair_force_refs(scene, FORCE_KIND_GRAVITY, &scene->gravity_forces);
+}
+
+// The number of force records, live or dead
+size_t scene_num_force_records(scene_t *scene) {
+    return force_array_size(&scene->force_funcs) + drag_force_array_size(&scene->drag_forces)
+        + acceleration_force_array_size(&scene->acceleration_forces)
+        + pair_force_array_size(&scene->spring_forces)
+        + pair_force_array_size(&scene->gravity_forces);
+}
+
+// Orders bodies by when they joined the scene, to put the two bodies of a pair
+// in a canonical order
+uint64_t scene_body_key(scene_t *scene, body_t *body) {
+    return scene_body_record(scene, body)->order;
+}
+
+// Finds a rule's contact pair for two bodies, in O(number of pairs either body is in).
+// Returns SIZE_MAX if the rule has no pair for them.
+size_t scene_find_pair(scene_t *scene, size_t rule, body_t *body1, body_t *body2) {
+    // Bodies in collision groups already have records, so neither lookup moves the other
+    body_record_t *record1 = scene_body_record(scene, body1);
+    body_record_t *record2 = scene_body_record(scene, body2);
+    body_t *other = body2;
+    if (index_array_size(&record2->pairs) < index_array_size(&record1->pairs)) {
+        record1 = record2;
+        other = body1;
+    }
+    ARRAY_FOR_EACH(size_t, idx, &record1->pairs) {
+        contact_pair_t *pair = contact_pair_array_get(&scene->pairs, *idx);
+        if (pair->rule == rule && (pair->body1 == other || pair->body2 == other)) {
+            return *idx;
+        }
+    }
+    return SIZE_MAX;
+}
+
+// Registers a pair, not yet touching, and returns its index
+size_t scene_add_pair(scene_t *scene, size_t rule, body_t *body1, body_t *body2) {
+    if (scene_body_key(scene, body2) < scene_body_key(scene, body1)) {
+        body_t *swap = body1;
+        body1 = body2;
+        body2 = swap;
+    }
+    contact_pair_t pair = {.body1 = body1, .body2 = body2, .rule = rule,
+                           .tick = scene->tick_count, .touching = false,
+                           .hint = SEPARATING_AXIS_NONE};
+    size_t idx = contact_pair_array_size(&scene->pairs);
+    contact_pair_array_add(&scene->pairs, pair);
+    index_array_add(&scene_body_record(scene, body1)->pairs, idx);
+    index_array_add(&scene_body_record(scene, body2)->pairs, idx);
+    return idx;
+}
+
+// Replaces one of a body's references to a contact pair (or drops it, if to is SIZE_MAX)
+void scene_move_pair_ref(scene_t *scene, body_t *body, size_t from, size_t to) {
+    index_array_t *refs = &scene_body_record(scene, body)->pairs;
+    for (size_t i = 0; i < index_array_size(refs); i++) {
+        if (refs->data[i] == from) {
+            if (to == SIZE_MAX) {
+                index_array_swap_remove(refs, i);
             }
             else {
-                body_idx++;
+                refs->data[i] = to;
             }
+            return;
         }
+    }
+}
+
+// Unregisters a contact pair. The last pair moves into its slot,
+// so only the references of the four bodies involved change.
+void scene_remove_pair(scene_t *scene, size_t idx) {
+    contact_pair_t *pair = contact_pair_array_get(&scene->pairs, idx);
+    scene_move_pair_ref(scene, pair->body1, idx, SIZE_MAX);
+    scene_move_pair_ref(scene, pair->body2, idx, SIZE_MAX);
 
+    size_t last = contact_pair_array_size(&scene->pairs) - 1;
+    if (idx != last) {
+        contact_pair_t *moved = contact_pair_array_get(&scene->pairs, last);
+        scene_move_pair_ref(scene, moved->body1, last, idx);
+        scene_move_pair_ref(scene, moved->body2, last, idx);
     }
+    contact_pair_array_swap_remove(&scene->pairs, idx);
 }
 
-void scene_for_each(scene_t *scene, body_func_t f, void *args) {
+// Unregisters the pairs no rule was run on this tick.
+// The ones that were touching get an exit contact.
+void scene_remove_stale_pairs(scene_t *scene) {
+    // Downwards, so the pair moved into a removed slot has already been checked
+    for (size_t i = contact_pair_array_size(&scene->pairs); i > 0; i--) {
+        contact_pair_t *pair = contact_pair_array_get(&scene->pairs, i - 1);
+        if (pair->tick == scene->tick_count) {
+            continue;
+        }
+        if (pair->touching && !body_is_trigger(pair->body1) && !body_is_trigger(pair->body2)) {
+            // The pair is stored in join order. If that is not the rule's group order,
+            // body1 can't be in both groups (see scene_queue_collision_pair()), so check it.
+            collision_rule_struct_t *rule = collision_rule_array_get(&scene->collision_rules,
+                                                                     pair->rule);
+            uint32_t bit1 = (uint32_t)1 << rule->group1;
+            bool in_order = scene_body_record(scene, pair->body1)->groups & bit1;
+            body_t *body1 = in_order ? pair->body1 : pair->body2;
+            body_t *body2 = in_order ? pair->body2 : pair->body1;
+            contact_t contact = {.body1 = body_get_handle(body1), .body2 = body_get_handle(body2),
+                                 .axis = VEC_ZERO, .overlap = 0, .state = CONTACT_EXIT};
+            contact_array_add(&rule->contacts, contact);
+        }
+        scene_remove_pair(scene, i - 1);
+    }
+}
+
+// remove_if() predicate: drops (and frees) removed bodies; aux is the scene
+bool scene_body_is_removed(body_t **body, scene_t *scene) {
+    if (body_is_removed(*body)) {
+        if (scene->physics && !body_is_static(*body)) {
+            physics_store_remove(scene->physics, *body);
+        }
+        body_free(*body);
+        return true;
+    }
+    return false;
+}
+
+// remove_if() predicate: drops removed bodies from a dynamic layer or collision group
+// without freeing them
+bool scene_body_is_removed_from_group(body_t **body, void *aux) {
+    return body_is_removed(*body);
+}
+
+// Takes a group's removed members out of its tree, before they are taken out of
+// the members, and renumbers the other proxies' members to match
+void scene_remove_tree_proxies(collision_group_t *group) {
+    size_t kept = 0;
+    for (size_t i = 0; i < index_array_size(&group->proxies); i++) {
+        size_t proxy = group->proxies.data[i];
+        if (body_is_removed(*body_array_get(&group->members, i))) {
+            aabb_tree_remove(group->tree, proxy);
+        }
+        else {
+            group->proxies.data[kept] = proxy;
+            group->proxy_ranks.data[proxy] = kept;
+            kept++;
+        }
+    }
+    group->proxies.size = kept;
+}
+
+// Bumps the version of the groups of each static body moved since the last call,
+// so their static members are re-indexed
+void scene_apply_static_moves(scene_t *scene) {
+    ARRAY_FOR_EACH(body_t *, body, &scene->static_moved) {
+        body_clear_move_queued(*body);
+        uint32_t groups = scene_body_record(scene, *body)->groups;
+        for (size_t i = 0; i < collision_group_array_size(&scene->groups); i++) {
+            if (groups & ((uint32_t)1 << i)) {
+                collision_group_array_get(&scene->groups, i)->version++;
+            }
+        }
+    }
+    body_array_clear(&scene->static_moved);
+}
+
+void scene_delete_bodies_and_forces(scene_t *scene) {
     assert(scene);
-    assert(f);
 
-    for (size_t i = 0; i < scene->num_layers; i++) {
-        list_t *layer = scene_get_layer(scene, i);
-        for (size_t j = 0; j < list_size(layer); j++) {
-            f((body_t *)list_get(layer, j), args);
+    // Before the moved bodies can be freed
+    scene_apply_static_moves(scene);
+    if (body_array_size(&scene->removed) == 0) {
+        return;
+    }
+
+    // Kill the force records acting on each removed body
+    size_t num_layers = scene_num_layers(scene);
+    bool *layer_touched = calloc(num_layers, sizeof(bool));
+    assert(layer_touched);
+    uint32_t groups_touched = 0;
+    // Bodies only in collision groups are kept at the front of removed, to be freed
+    // once the groups have dropped them; the layers free the others
+    size_t num_unlayered = 0;
+    ARRAY_FOR_EACH(body_t *, body, &scene->removed) {
+        body_record_t *record = scene_body_record(scene, *body);
+        ARRAY_FOR_EACH(force_ref_t, ref, &record->forces) {
+            scene_kill_force(scene, *ref);
+        }
+        // The pool slot will be reused by a new body
+        force_ref_array_clear(&record->forces);
+        while (index_array_size(&record->pairs) > 0) {
+            scene_remove_pair(scene, record->pairs.data[index_array_size(&record->pairs) - 1]);
+        }
+        if (record->layer != SIZE_MAX) {
+            layer_touched[record->layer] = true;
+        }
+        else {
+            scene->removed.data[num_unlayered++] = *body;
         }
+        record->layer = SIZE_MAX;
+        groups_touched |= record->groups;
+        record->groups = 0;
     }
+
+    for (size_t i = 0; i < collision_group_array_size(&scene->groups); i++) {
+        if (groups_touched & ((uint32_t)1 << i)) {
+            collision_group_t *group = collision_group_array_get(&scene->groups, i);
+            if (group->tree) {
+                scene_remove_tree_proxies(group);
+            }
+            body_array_remove_if(&group->members, scene_body_is_removed_from_group, NULL);
+            group->version++;
+            group->boxes_tick = 0;
+            group->grid_tick = 0;
+        }
+    }
+    for (size_t i = 0; i < num_unlayered; i++) {
+        body_free(scene->removed.data[i]);
+    }
+    body_array_clear(&scene->removed);
+
+    // Only layers that lost a body are compacted, keeping their draw order
+    for (size_t i = 0; i < num_layers; i++) {
+        if (layer_touched[i]) {
+            // The dynamic layer first, since the other pass frees the bodies
+            body_array_remove_if(layer_array_get(&scene->dynamic_layers, i),
+                                 scene_body_is_removed_from_group, NULL);
+            body_array_remove_if(scene_get_layer(scene, i),
+                                 (body_array_pred_t)scene_body_is_removed, scene);
+        }
+    }
+    free(layer_touched);
+
+    size_t num_live = scene_num_force_records(scene) - scene->num_dead_forces;
+    if (scene->num_dead_forces >= SCENE_FORCE_COMPACT_MIN && scene->num_dead_forces > num_live) {
+        scene_compact_forces(scene);
+    }
+}
+
+// Calls f on every body in layers. f may add bodies, so the layers may grow
+// while they are walked; indices stay valid where pointers would not.
+void scene_for_each_in_layers(layer_array_t *layers, body_func_t f, void *args) {
+    for (size_t i = 0; i < layer_array_size(layers); i++) {
+        for (size_t j = 0; j < body_array_size(layer_array_get(layers, i)); j++) {
+            f(*body_array_get(layer_array_get(layers, i), j), args);
+        }
+    }
+}
+
+void scene_for_each(scene_t *scene, body_func_t f, void *args) {
+    assert(scene);
+    assert(f);
+
+    scene_for_each_in_layers(&scene->layers, f, args);
+}
+
+// Like scene_for_each(), but skips static bodies
+void scene_for_each_dynamic(scene_t *scene, body_func_t f, void *args) {
+    scene_for_each_in_layers(&scene->dynamic_layers, f, args);
 }
 
 // Helper function to use body_tick() with the scene_for_each() abstraction
@@ -211,23 +1101,513 @@ void scene_helper_body_tick(body_t *body, void *dt) {
     body_tick(body, *(double *)dt);
 }
 
+// Helper function to use body_run_tick_funcs() with the scene_for_each() abstraction
+void scene_helper_run_tick_funcs(body_t *body, void *dt) {
+    body_run_tick_funcs(body, *(double *)dt);
+}
+
+// Computes a group's current bounding boxes, unless that was already done this tick
+void scene_update_group_boxes(scene_t *scene, collision_group_t *group) {
+    if (group->boxes_tick == scene->tick_count) {
+        return;
+    }
+
+    aabb_array_clear(&group->boxes);
+    ARRAY_FOR_EACH(body_t *, body, &group->members) {
+        aabb_array_add(&group->boxes, body_get_aabb(*body));
+    }
+    group->boxes_tick = scene->tick_count;
+}
+
+// Indexes the bounding boxes of some of a group's members
+void scene_build_group_grid(scene_t *scene, collision_group_t *group, spatial_grid_t *grid,
+                            index_array_t *ranks) {
+    aabb_array_clear(&group->boxes);
+    ARRAY_FOR_EACH(size_t, rank, ranks) {
+        aabb_array_add(&group->boxes, body_get_aabb(*body_array_get(&group->members, *rank)));
+    }
+    // The boxes now only cover some members
+    group->boxes_tick = 0;
+
+    aabb_t bounds = {.min = VEC_ZERO, .max = scene->dimensions};
+    spatial_grid_build(grid, bounds, group->boxes.data, aabb_array_size(&group->boxes));
+}
+
+// Indexes a group's static members if the members have changed or one was moved,
+// and its dynamic members' current bounding boxes if not done yet this tick
+void scene_update_group_grid(scene_t *scene, collision_group_t *group) {
+    if (group->static_version != group->version) {
+        index_array_clear(&group->static_ranks);
+        index_array_clear(&group->dynamic_ranks);
+        for (size_t i = 0; i < body_array_size(&group->members); i++) {
+            bool is_static = body_is_static(*body_array_get(&group->members, i));
+            index_array_add(is_static ? &group->static_ranks : &group->dynamic_ranks, i);
+        }
+        scene_build_group_grid(scene, group, group->static_grid, &group->static_ranks);
+        group->static_version = group->version;
+        group->grid_tick = 0;
+    }
+    if (group->grid_tick != scene->tick_count) {
+        scene_build_group_grid(scene, group, group->grid, &group->dynamic_ranks);
+        group->grid_tick = scene->tick_count;
+    }
+}
+
+// Brings a group's tree up to date if bodies may have moved since it last was,
+// inserting new members and moving the others. A member's proxy only moves
+// once the member leaves its fat box, so members standing still cost little.
+void scene_update_group_tree(scene_t *scene, collision_group_t *group) {
+    if (!group->tree) {
+        group->tree = aabb_tree_init(SCENE_TREE_MARGIN);
+        group->tree_moves = SIZE_MAX;
+    }
+    size_t num_members = body_array_size(&group->members);
+    if (group->tree_moves == scene->move_count && index_array_size(&group->proxies) == num_members) {
+        return;
+    }
+
+    for (size_t i = 0; i < num_members; i++) {
+        body_t *body = *body_array_get(&group->members, i);
+        if (i >= index_array_size(&group->proxies)) {
+            size_t proxy = aabb_tree_insert(group->tree, body_get_aabb(body));
+            index_array_add(&group->proxies, proxy);
+            while (index_array_size(&group->proxy_ranks) <= proxy) {
+                index_array_add(&group->proxy_ranks, SIZE_MAX);
+            }
+            group->proxy_ranks.data[proxy] = i;
+        }
+        else {
+            vector_t displacement = vec_multiply(SCENE_TREE_LOOKAHEAD, body_get_velocity(body));
+            aabb_tree_move(group->tree, group->proxies.data[i], body_get_aabb(body), displacement);
+        }
+    }
+    group->tree_moves = scene->move_count;
+}
+
+int scene_compare_indices(const void *a, const void *b) {
+    size_t x = *(const size_t *)a;
+    size_t y = *(const size_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Puts the indices in members of the members whose fat boxes in the group's tree
+// overlap a box in the scene's candidates, in increasing order
+void scene_query_group_tree(scene_t *scene, collision_group_t *group, aabb_t box) {
+    const size_t *hits;
+    size_t num_hits = aabb_tree_query(group->tree, box, &hits);
+    index_array_clear(&scene->candidates);
+    for (size_t k = 0; k < num_hits; k++) {
+        index_array_add(&scene->candidates, group->proxy_ranks.data[hits[k]]);
+    }
+    if (num_hits > 1) {
+        qsort(scene->candidates.data, num_hits, sizeof(size_t), scene_compare_indices);
+    }
+}
+
+bool scene_boxes_overlap(aabb_t box1, aabb_t box2) {
+    return box1.min.x <= box2.max.x && box2.min.x <= box1.max.x
+        && box1.min.y <= box2.max.y && box2.min.y <= box1.max.y;
+}
+
+size_t scene_query_box(scene_t *scene, size_t group, aabb_t box, body_t ***results) {
+    assert(scene);
+    assert(results);
+
+    collision_group_t *g = scene_get_collision_group(scene, group);
+    scene_update_group_tree(scene, g);
+    scene_query_group_tree(scene, g, box);
+    body_array_clear(&scene->query_results);
+    ARRAY_FOR_EACH(size_t, rank, &scene->candidates) {
+        body_t *body = *body_array_get(&g->members, *rank);
+        if (scene_boxes_overlap(body_get_aabb(body), box)) {
+            body_array_add(&scene->query_results, body);
+        }
+    }
+    *results = scene->query_results.data;
+    return body_array_size(&scene->query_results);
+}
+
+// Queues a narrow phase test of a pair of bodies with overlapping bounding boxes
+void scene_queue_collision_pair(scene_t *scene, collision_rule_struct_t *rule,
+                                body_t *body1, body_t *body2) {
+    if (body1 == body2 || (body_is_static(body1) && body_is_static(body2))
+        || !body_can_collide(body1, body2)) {
+        return;
+    }
+    // If each body is in both groups, the pair comes up in both orders; only run one
+    uint32_t bit1 = (uint32_t)1 << rule->group1;
+    uint32_t bit2 = (uint32_t)1 << rule->group2;
+    if ((scene_body_record(scene, body1)->groups & bit2)
+        && (scene_body_record(scene, body2)->groups & bit1)
+        && scene_body_key(scene, body2) < scene_body_key(scene, body1)) {
+        return;
+    }
+
+    size_t idx = scene_find_pair(scene, rule->id, body1, body2);
+    if (idx == SIZE_MAX) {
+        idx = scene_add_pair(scene, rule->id, body1, body2);
+    }
+    contact_pair_array_get(&scene->pairs, idx)->tick = scene->tick_count;
+    narrow_test_t test = {.body1 = body1, .body2 = body2, .pair = idx};
+    narrow_test_array_add(&scene->narrow_tests, test);
+}
+
+// What thread_pool_run() needs to run one rule's narrow phase
+typedef struct narrow_phase_run {
+    scene_t *scene;
+    collision_rule_struct_t *rule;
+} narrow_phase_run_t;
+
+// Runs the narrow phase tests from begin to end. Each test only changes its own pair,
+// and the contacts go to the chunk's own buffer, so chunks can run at the same time.
+void scene_run_narrow_tests(size_t begin, size_t end, size_t chunk, narrow_phase_run_t *run) {
+    scene_t *scene = run->scene;
+    collision_rule_struct_t *rule = run->rule;
+    contact_array_t *contacts = chunk == 0 ? &rule->contacts : &scene->thread_contacts[chunk];
+    const narrow_test_t *tests = scene->narrow_tests.data;
+    for (size_t i = begin; i < end; i++) {
+        contact_pair_t *pair = &scene->pairs.data[tests[i].pair];
+        collision_info_t info;
+        bool touching = rule->rule(tests[i].body1, tests[i].body2, &pair->hint, &info, rule->aux);
+        bool report = touching || pair->touching;
+        // Triggers only report contacts starting
+        if (body_is_trigger(tests[i].body1) || body_is_trigger(tests[i].body2)) {
+            report = touching && !pair->touching;
+        }
+        if (report) {
+            contact_t contact = {.body1 = body_get_handle(tests[i].body1),
+                                 .body2 = body_get_handle(tests[i].body2),
+                                 .axis = VEC_ZERO, .overlap = 0};
+            if (touching) {
+                contact.axis = info.axis;
+                contact.overlap = info.min_overlap;
+                contact.state = pair->touching ? CONTACT_STAY : CONTACT_ENTER;
+            }
+            else {
+                contact.state = CONTACT_EXIT;
+            }
+            contact_array_add(contacts, contact);
+        }
+        pair->touching = touching;
+    }
+    if (chunk != 0) {
+        // Handed to the calling thread once every chunk is done
+        scene->thread_stats[chunk] = collision_get_stats();
+        collision_reset_stats();
+    }
+}
+
+// Runs the queued narrow phase tests, on several threads if the scene has them.
+// The chunks' contacts are appended in chunk order, which is the order the tests were queued.
+void scene_run_queued_tests(scene_t *scene, collision_rule_struct_t *rule) {
+    narrow_phase_run_t run = {.scene = scene, .rule = rule};
+    size_t num_tests = narrow_test_array_size(&scene->narrow_tests);
+    if (!scene->pool) {
+        scene_run_narrow_tests(0, num_tests, 0, &run);
+        return;
+    }
+
+    thread_pool_run(scene->pool, num_tests, SCENE_NARROW_PHASE_GRAIN,
+                    (thread_pool_task_t)scene_run_narrow_tests, &run);
+    for (size_t t = 1; t < thread_pool_num_threads(scene->pool); t++) {
+        ARRAY_FOR_EACH(contact_t, contact, &scene->thread_contacts[t]) {
+            contact_array_add(&rule->contacts, *contact);
+        }
+        contact_array_clear(&scene->thread_contacts[t]);
+        collision_add_stats(scene->thread_stats[t]);
+        scene->thread_stats[t] = (collision_stats_t){.tests = 0, .box_rejections = 0,
+                                                     .warm_starts = 0, .warm_hits = 0};
+    }
+}
+
+void scene_run_collision_rule_grid(scene_t *scene, collision_rule_struct_t *rule,
+                                   collision_group_t *group1, collision_group_t *group2) {
+    scene_update_group_grid(scene, group2);
+    for (size_t i = 0; i < body_array_size(&group1->members); i++) {
+        body_t *body1 = *body_array_get(&group1->members, i);
+        aabb_t box = body_get_aabb(body1);
+
+        // Merge the hits from both grids, in order of their index in group2
+        const size_t *dynamic_hits;
+        size_t num_dynamic = spatial_grid_query(group2->grid, box, &dynamic_hits);
+        const size_t *static_hits = NULL;
+        size_t num_static = 0;
+        if (!body_is_static(body1)) {
+            num_static = spatial_grid_query(group2->static_grid, box, &static_hits);
+        }
+        const size_t *dynamic_ranks = group2->dynamic_ranks.data;
+        const size_t *static_ranks = group2->static_ranks.data;
+        index_array_clear(&scene->candidates);
+        size_t d = 0, s = 0;
+        while (d < num_dynamic || s < num_static) {
+            if (s == num_static
+                || (d < num_dynamic && dynamic_ranks[dynamic_hits[d]] < static_ranks[static_hits[s]])) {
+                index_array_add(&scene->candidates, dynamic_ranks[dynamic_hits[d++]]);
+            }
+            else {
+                index_array_add(&scene->candidates, static_ranks[static_hits[s++]]);
+            }
+        }
+
+        ARRAY_FOR_EACH(size_t, rank, &scene->candidates) {
+            scene_queue_collision_pair(scene, rule, body1, *body_array_get(&group2->members, *rank));
+        }
+    }
+}
+
+void scene_run_collision_rule_sweep_prune(scene_t *scene, collision_rule_struct_t *rule,
+                                          collision_group_t *group1, collision_group_t *group2) {
+    scene_update_group_boxes(scene, group1);
+    scene_update_group_boxes(scene, group2);
+    bool rebuild = rule->group1_version != group1->version
+        || rule->group2_version != group2->version;
+    sweep_prune_update(rule->sap, group1->boxes.data, aabb_array_size(&group1->boxes),
+                       group2->boxes.data, aabb_array_size(&group2->boxes), rebuild);
+    rule->group1_version = group1->version;
+    rule->group2_version = group2->version;
+
+    const sweep_prune_pair_t *pairs;
+    size_t num_pairs = sweep_prune_get_pairs(rule->sap, &pairs);
+    for (size_t k = 0; k < num_pairs; k++) {
+        scene_queue_collision_pair(scene, rule, *body_array_get(&group1->members, pairs[k].index1),
+                                 *body_array_get(&group2->members, pairs[k].index2));
+    }
+}
+
+// The tree's fat boxes only narrow down the candidates; each is then
+// checked against the member's own box, so the pairs match the other broadphases
+void scene_run_collision_rule_tree(scene_t *scene, collision_rule_struct_t *rule,
+                                   collision_group_t *group1, collision_group_t *group2) {
+    scene_update_group_boxes(scene, group1);
+    scene_update_group_boxes(scene, group2);
+    scene_update_group_tree(scene, group2);
+    for (size_t i = 0; i < body_array_size(&group1->members); i++) {
+        body_t *body1 = *body_array_get(&group1->members, i);
+        aabb_t box1 = group1->boxes.data[i];
+        scene_query_group_tree(scene, group2, box1);
+        ARRAY_FOR_EACH(size_t, rank, &scene->candidates) {
+            if (scene_boxes_overlap(box1, group2->boxes.data[*rank])) {
+                scene_queue_collision_pair(scene, rule, body1,
+                                           *body_array_get(&group2->members, *rank));
+            }
+        }
+    }
+}
+
+// Tests every pair, like registering a force creator per pair
+void scene_run_collision_rule_brute_force(scene_t *scene, collision_rule_struct_t *rule,
+                                          collision_group_t *group1, collision_group_t *group2) {
+    scene_update_group_boxes(scene, group1);
+    scene_update_group_boxes(scene, group2);
+    size_t num_boxes1 = aabb_array_size(&group1->boxes);
+    size_t num_boxes2 = aabb_array_size(&group2->boxes);
+    for (size_t i = 0; i < num_boxes1; i++) {
+        aabb_t box1 = group1->boxes.data[i];
+        for (size_t j = 0; j < num_boxes2; j++) {
+            if (scene_boxes_overlap(box1, group2->boxes.data[j])) {
+                scene_queue_collision_pair(scene, rule, *body_array_get(&group1->members, i),
+                                         *body_array_get(&group2->members, j));
+            }
+        }
+    }
+}
+
+// Calls a collision rule on every pair from its two groups with overlapping bounding boxes.
+// Pairs are visited in order of group1 member, then group2 member, whatever the broadphase.
+void scene_run_collision_rule(scene_t *scene, collision_rule_struct_t *rule) {
+    collision_group_t *group1 = collision_group_array_get(&scene->groups, rule->group1);
+    collision_group_t *group2 = collision_group_array_get(&scene->groups, rule->group2);
+    narrow_test_array_clear(&scene->narrow_tests);
+
+    switch (scene->broadphase) {
+        case SCENE_BROADPHASE_GRID: {
+            scene_run_collision_rule_grid(scene, rule, group1, group2);
+            break;
+        }
+        case SCENE_BROADPHASE_SWEEP_PRUNE: {
+            scene_run_collision_rule_sweep_prune(scene, rule, group1, group2);
+            break;
+        }
+        case SCENE_BROADPHASE_AABB_TREE: {
+            scene_run_collision_rule_tree(scene, rule, group1, group2);
+            break;
+        }
+        case SCENE_BROADPHASE_BRUTE_FORCE: {
+            scene_run_collision_rule_brute_force(scene, rule, group1, group2);
+            break;
+        }
+    }
+    scene_run_queued_tests(scene, rule);
+}
+
+// The first phase of collision handling: runs every rule and fills the contact buffer.
+// Only the scene's broadphase and pair state change.
+void scene_detect_contacts(scene_t *scene) {
+    scene->num_contacts = 0;
+    // Bodies may have been moved since the last tick
+    scene->move_count++;
+    scene_apply_static_moves(scene);
+    ARRAY_FOR_EACH(collision_rule_struct_t, rule, &scene->collision_rules) {
+        scene_run_collision_rule(scene, rule);
+    }
+    scene_remove_stale_pairs(scene);
+    ARRAY_FOR_EACH(collision_rule_struct_t, rule, &scene->collision_rules) {
+        scene->num_contacts += contact_array_size(&rule->contacts);
+    }
+}
+
+// Calls the category handler for a contact of a rule without a handler of its own
+void scene_dispatch_by_category(scene_t *scene, body_t *body1, body_t *body2,
+                                const contact_t *contact) {
+    if (!scene->category_handlers) {
+        return;
+    }
+    size_t category1 = body_get_collision_category(body1);
+    size_t category2 = body_get_collision_category(body2);
+    category_handler_t *entry =
+        &scene->category_handlers[category1 * BODY_NUM_CATEGORIES + category2];
+    if (!entry->handler) {
+        return;
+    }
+    if (!entry->swapped) {
+        entry->handler(body1, body2, contact, entry->aux);
+        return;
+    }
+    contact_t flipped = *contact;
+    flipped.body1 = contact->body2;
+    flipped.body2 = contact->body1;
+    flipped.axis = vec_negate(contact->axis);
+    entry->handler(body2, body1, &flipped, entry->aux);
+}
+
+// If one of a contact's bodies is a trigger the other one uses up, returns the trigger
+body_t *scene_contact_trigger(body_t *body1, body_t *body2) {
+    if (body_is_trigger(body1) && body_retires_trigger(body1, body2)) {
+        return body1;
+    }
+    if (body_is_trigger(body2) && body_retires_trigger(body2, body1)) {
+        return body2;
+    }
+    return NULL;
+}
+
+// The second phase: calls each rule's handler on its contacts.
+// Handlers may add rules, so the rules are looked up by index each time.
+void scene_dispatch_contacts(scene_t *scene) {
+    size_t num_rules = collision_rule_array_size(&scene->collision_rules);
+    for (size_t i = 0; i < num_rules; i++) {
+        collision_rule_struct_t *rule = collision_rule_array_get(&scene->collision_rules, i);
+        contact_handler_t handler = rule->handler;
+        void *aux = rule->aux;
+        // Nothing adds contacts while they are dispatched, so the buffer stays put
+        // even if a new rule moves the rules array
+        const contact_t *contacts = rule->contacts.data;
+        size_t num_contacts = contact_array_size(&rule->contacts);
+        for (size_t k = 0; k < num_contacts; k++) {
+            // Bodies are only freed after the tick, so both handles still resolve
+            body_t *body1 = body_from_handle(contacts[k].body1);
+            body_t *body2 = body_from_handle(contacts[k].body2);
+            // A trigger that has been used up (or removed some other way) is only
+            // reported to bodies that can't use it
+            body_t *trigger = scene_contact_trigger(body1, body2);
+            if (trigger && body_is_removed(trigger)) {
+                continue;
+            }
+            if (handler) {
+                handler(body1, body2, &contacts[k], aux);
+            } else {
+                scene_dispatch_by_category(scene, body1, body2, &contacts[k]);
+            }
+            if (trigger) {
+                body_remove(trigger);
+            }
+        }
+        contact_array_clear(&collision_rule_array_get(&scene->collision_rules, i)->contacts);
+    }
+}
+
+size_t scene_num_contacts(scene_t *scene) {
+    assert(scene);
+
+    return scene->num_contacts;
+}
+
+// Helper function to use body_save_previous_state() with the scene_for_each() abstraction
+void scene_helper_save_state(body_t *body, void *aux) {
+    body_save_previous_state(body);
+}
+
+// Applies every live force, one pass per built-in kind and then the custom force creators
+void scene_apply_forces(scene_t *scene) {
+    ARRAY_FOR_EACH(drag_force_t, f, &scene->drag_forces) {
+        if (!f->dead) {
+            body_add_force(f->body, vec_multiply(-f->gamma, body_get_velocity(f->body)));
+        }
+    }
+    ARRAY_FOR_EACH(acceleration_force_t, f, &scene->acceleration_forces) {
+        if (!f->dead) {
+            body_add_force(f->body, vec_multiply(body_get_mass(f->body), f->acceleration));
+        }
+    }
+    // k * r in the direction of r is just k times the displacement
+    ARRAY_FOR_EACH(pair_force_t, f, &scene->spring_forces) {
+        if (!f->dead) {
+            vector_t force = vec_multiply(f->coef, vec_subtract(body_get_centroid(f->body2),
+                                                                body_get_centroid(f->body1)));
+            body_add_force(f->body1, force);
+            body_add_force(f->body2, vec_negate(force));
+        }
+    }
+    ARRAY_FOR_EACH(pair_force_t, f, &scene->gravity_forces) {
+        if (f->dead) {
+            continue;
+        }
+        vector_t r12 = vec_subtract(body_get_centroid(f->body2), body_get_centroid(f->body1));
+        double r2 = vec_dot(r12, r12);
+        if (r2 > f->min_distance * f->min_distance) {
+            // The magnitude G * m1 * m2 / r^2, times r12 / r for the direction
+            double r = sqrt(r2);
+            double scale = f->coef * body_get_mass(f->body1) * body_get_mass(f->body2) / (r2 * r);
+            vector_t force = vec_multiply(scale, r12);
+            body_add_force(f->body1, force);
+            body_add_force(f->body2, vec_negate(force));
+        }
+    }
+    for (size_t i = 0; i < force_array_size(&scene->force_funcs); i++) {
+        force_struct_t *f = force_array_get(&scene->force_funcs, i);
+        if (!f->dead) {
+            f->forcer(f->aux);
+        }
+    }
+}
+
 void scene_tick(scene_t *scene, double dt) {
     assert(scene);
+
+    // Done even while paused, so a paused scene renders standing still.
+    // Static bodies keep their state up to date themselves.
+    scene_for_each_dynamic(scene, scene_helper_save_state, NULL);
     
     if (scene->paused) {
         return;
     }
     
-    for (size_t i = 0; i < list_size(scene->force_funcs); i++) {
-        force_struct_t *f = list_get(scene->force_funcs, i);
-        f->forcer(f->aux);
-    }
+    scene_apply_forces(scene);
 
-    double *d = malloc(sizeof(double));
-    assert(d);
-    *d = dt;
-    scene_for_each(scene, scene_helper_body_tick, (void *)d);
-    free(d);
+    scene->tick_count++;
+    scene_detect_contacts(scene);
+    scene_dispatch_contacts(scene);
+
+    if (scene->physics) {
+        // Same steps as body_tick(), but each integration step is one linear pass
+        physics_store_integrate_velocities(scene->physics, dt);
+        scene_for_each_dynamic(scene, scene_helper_run_tick_funcs, &dt);
+        physics_store_integrate_positions(scene->physics);
+    }
+    else {
+        scene_for_each_dynamic(scene, scene_helper_body_tick, &dt);
+    }
+    scene->move_count++;
 
     scene_delete_bodies_and_forces(scene);
 }
@@ -1,10 +1,10 @@
 #include "polygon.h"
 #include "sdl_wrapper.h"
+#include "vec_batch.h"
 #include <assert.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 
 const char WINDOW_TITLE[] = "FURIOUS AND FAST";
 const int WINDOW_WIDTH = 1000;
@@ -37,10 +37,17 @@ key_handler_t key_handler = NULL;
  */
 uint32_t key_start_timestamp;
 /**
- * The value of clock() when time_since_last_tick() was last called.
- * Initially 0.
+ * The value of SDL_GetPerformanceCounter() when time_since_last_tick()
+ * was last called. Initially 0.
  */
-clock_t last_clock = 0;
+uint64_t last_counter = 0;
+/**
+ * Scratch space for converting polygon vertices to pixels,
+ * grown as needed and reused across draws.
+ */
+double *draw_x = NULL, *draw_y = NULL;
+int16_t *draw_x_points = NULL, *draw_y_points = NULL;
+size_t draw_capacity = 0;
 
 /** Computes the center of the window in pixel coordinates */
 vector_t get_window_center(void) {
@@ -179,9 +186,26 @@ void sdl_clear(void) {
     SDL_RenderClear(renderer);
 }
 
-void sdl_draw_polygon(list_t *points, rgb_color_t color) {
+/** Makes sure the drawing scratch space fits n vertices */
+void reserve_draw_space(size_t n) {
+    if (n <= draw_capacity) {
+        return;
+    }
+    draw_x = realloc(draw_x, sizeof(*draw_x) * n);
+    draw_y = realloc(draw_y, sizeof(*draw_y) * n);
+    draw_x_points = realloc(draw_x_points, sizeof(*draw_x_points) * n);
+    draw_y_points = realloc(draw_y_points, sizeof(*draw_y_points) * n);
+    assert(draw_x && draw_y && draw_x_points && draw_y_points);
+    draw_capacity = n;
+}
+
+void sdl_draw_polygon(polygon_t *points, rgb_color_t color) {
+    sdl_draw_polygon_offset(points, VEC_ZERO, color);
+}
+
+void sdl_draw_polygon_offset(polygon_t *points, vector_t offset, rgb_color_t color) {
     // Check parameters
-    size_t n = list_size(points);
+    size_t n = points->num_vertices;
     assert(n >= 3);
     assert(0 <= color.r && color.r <= 1);
     assert(0 <= color.g && color.g <= 1);
@@ -189,26 +213,62 @@ void sdl_draw_polygon(list_t *points, rgb_color_t color) {
 
     vector_t window_center = get_window_center();
 
-    // Convert each vertex to a point on screen
-    int16_t *x_points = malloc(sizeof(*x_points) * n),
-            *y_points = malloc(sizeof(*y_points) * n);
-    assert(x_points != NULL);
-    assert(y_points != NULL);
+    // Convert every vertex to a point on screen in one pass
+    // (the same mapping as get_window_position(), with the offset folded in)
+    double scale = get_scene_scale(window_center);
+    vector_t pixel_scale = {.x = scale, .y = -scale};
+    vector_t pixel_offset = {.x = window_center.x + scale * (offset.x - center.x),
+                             .y = window_center.y - scale * (offset.y - center.y)};
+    reserve_draw_space(n);
+    vec_batch_scale_offset(points->x, points->y, draw_x, draw_y, n, pixel_scale, pixel_offset);
     for (size_t i = 0; i < n; i++) {
-        vector_t *vertex = list_get(points, i);
-        vector_t pixel = get_window_position(*vertex, window_center);
-        x_points[i] = pixel.x;
-        y_points[i] = pixel.y;
+        draw_x_points[i] = round(draw_x[i]);
+        draw_y_points[i] = round(draw_y[i]);
     }
 
     // Draw polygon with the given color
     filledPolygonRGBA(
         renderer,
-        x_points, y_points, n,
+        draw_x_points, draw_y_points, n,
         color.r * 255, color.g * 255, color.b * 255, 255
     );
-    free(x_points);
-    free(y_points);
+}
+
+/**
+ * Draws the rows of a terrain that are on screen.
+ * Each row is drawn as one rectangle per run of cells with the same surface.
+ */
+void sdl_draw_terrain(terrain_t *terrain, vector_t offset, vector_t center, vector_t max_dims) {
+    vector_t cell = terrain_get_cell_size(terrain);
+    size_t cols = terrain_num_cols(terrain);
+    double bottom = center.y - max_dims.y / 2.;
+    double top = center.y + max_dims.y / 2.;
+    size_t first_row = (size_t)fmax(0, floor(bottom / cell.y));
+    size_t end_row = (size_t)fmax(0, fmin(terrain_num_rows(terrain), ceil(top / cell.y)));
+
+    polygon_t *rect = polygon_init(4);
+    for (size_t i = 0; i < 4; i++) {
+        polygon_add_vertex(rect, VEC_ZERO);
+    }
+    for (size_t row = first_row; row < end_row; row++) {
+        size_t col = 0;
+        while (col < cols) {
+            size_t surface = terrain_get_cell(terrain, col, row);
+            size_t end_col = col + 1;
+            while (end_col < cols && terrain_get_cell(terrain, end_col, row) == surface) {
+                end_col++;
+            }
+            double x0 = col * cell.x, x1 = end_col * cell.x;
+            double y0 = row * cell.y, y1 = (row + 1) * cell.y;
+            polygon_set_vertex(rect, 0, (vector_t){.x = x0, .y = y0});
+            polygon_set_vertex(rect, 1, (vector_t){.x = x1, .y = y0});
+            polygon_set_vertex(rect, 2, (vector_t){.x = x1, .y = y1});
+            polygon_set_vertex(rect, 3, (vector_t){.x = x0, .y = y1});
+            sdl_draw_polygon_offset(rect, offset, terrain_get_surface(terrain, surface).color);
+            col = end_col;
+        }
+    }
+    polygon_free(rect);
 }
 
 void sdl_show(void) {
@@ -247,33 +307,38 @@ void sdl_render_window(window_t *window) {
     scene_t *scene = window_get_scene(window);
     assert(scene);
     vector_t max_dims = window_get_dims(window);
-    vector_t center = window_get_center(window);
+    // Draw between the last two ticks, so motion is smooth whatever the tick rate
+    vector_t center = window_get_render_center(window);
+    double alpha = window_get_interpolation(window);
     vector_t window_center = {.x = max_dims.x / 2., max_dims.y / 2.};
+    vector_t window_trans = vec_subtract(window_center, center);
+    terrain_t *terrain = scene_get_terrain(scene);
     size_t num_layers = scene_num_layers(scene);
     for (size_t i = 0; i < num_layers; i++) {
-        list_t *layer = scene_get_layer(scene, i);
-        size_t num_bodies = list_size(layer);
+        if (terrain && i == scene_get_terrain_layer(scene)) {
+            sdl_draw_terrain(terrain, window_trans, center, max_dims);
+        }
+        body_array_t *layer = scene_get_layer(scene, i);
+        size_t num_bodies = body_array_size(layer);
         for (size_t j = 0; j < num_bodies; j++) {
-            body_t *body = (body_t *)list_get(layer, j);
-            vector_t c = body_get_centroid(body);
+            body_t *body = *body_array_get(layer, j);
+            vector_t c = body_get_interpolated_centroid(body, alpha);
             double r = body_get_bounding_radius(body);
             double dx = fabs(c.x - center.x);
             double dy = fabs(c.y - center.y);
             if (dx < r + max_dims.x / 2. && dy < r + max_dims.y / 2.) {
                 if (body_get_surface(body) && !body_get_debug_mode(body)) {
-                    vector_t scene_c = body_get_centroid(body);
-                    vector_t window_c = scene_to_window_space(window, scene_c);
+                    vector_t window_c = vec_add(c, window_trans);
                     // Convert to degrees and clockwise orientation
-                    double rot_angle = -body_get_rotation(body) * 180. / M_PI;
+                    double rot_angle = -body_get_interpolated_rotation(body, alpha) * 180. / M_PI;
                     sdl_render_sprite(body_get_surface(body), window_c, body_get_dimensions(body), rot_angle);
                 }
                 else {
-                    // Translate the shape to window space
-                    list_t *shape = body_get_shape(body);
-                    vector_t window_trans = vec_subtract(window_center, center);
-                    polygon_translate(shape, window_trans);
-                    sdl_draw_polygon(shape, body_get_color(body));
-                    list_free(shape);
+                    // Translate the shape to window space while drawing it.
+                    // Polygons are only interpolated in position, not rotation.
+                    vector_t lag = vec_subtract(c, body_get_centroid(body));
+                    sdl_draw_polygon_offset(body_get_shape_nocpy(body), vec_add(window_trans, lag),
+                                            body_get_color(body));
                 }
             }
         }
@@ -282,11 +347,8 @@ void sdl_render_window(window_t *window) {
     // Render the HUD
     hud_t *hud = window_get_hud(window);
     if (hud) {
-        list_t *widgets = hud_get_widgets(hud);
-        assert(widgets);
-
-        for (size_t i = 0; i < list_size(widgets); i++) {
-            widget_t *widget = list_get(widgets, i);
+        for (size_t i = 0; i < hud_num_widgets(hud); i++) {
+            widget_t *widget = hud_get_widget(hud, i);
             SDL_Surface *surface = widget_get_surface(widget);
             if (surface) {
                 SDL_Rect orientation = widget_get_rect(widget);
@@ -305,10 +367,11 @@ void sdl_on_key(key_handler_t handler) {
 }
 
 double time_since_last_tick(void) {
-    clock_t now = clock();
-    double difference = last_clock
-        ? (double) (now - last_clock) / CLOCKS_PER_SEC
+    // Wall-clock time; clock() measures CPU time, which stops while the process sleeps
+    uint64_t now = SDL_GetPerformanceCounter();
+    double difference = last_counter
+        ? (double) (now - last_counter) / SDL_GetPerformanceFrequency()
         : 0.0; // return 0 the first time this is called
-    last_clock = now;
+    last_counter = now;
     return difference;
 }
\ No newline at end of file
@@ -0,0 +1,198 @@
+#include "array.h"
+#include "spatial_grid.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+// The cells a box touches, from col0 to col1 and row0 to row1 inclusive
+typedef struct grid_cell_range {
+    size_t col0;
+    size_t col1;
+    size_t row0;
+    size_t row1;
+} grid_cell_range_t;
+
+ARRAY_DECLARE(grid_index_array, size_t)
+ARRAY_DECLARE(grid_box_array, aabb_t)
+ARRAY_DECLARE(grid_range_array, grid_cell_range_t)
+
+typedef struct spatial_grid {
+    double cell_size;
+    vector_t origin;
+    size_t cols;
+    size_t rows;
+    grid_box_array_t boxes;
+    grid_range_array_t ranges;
+    // The boxes in cell c are cell_items[cell_start[c]] up to cell_items[cell_start[c + 1]]
+    grid_index_array_t cell_start;
+    grid_index_array_t cell_items;
+    // The query each box was last found by, so boxes spanning several cells are reported once
+    grid_index_array_t last_query;
+    size_t query_count;
+    grid_index_array_t results;
+} spatial_grid_t;
+
+spatial_grid_t *spatial_grid_init(double cell_size) {
+    assert(cell_size > 0);
+
+    spatial_grid_t *grid = malloc(sizeof(spatial_grid_t));
+    assert(grid);
+
+    grid->cell_size = cell_size;
+    grid->origin = VEC_ZERO;
+    grid->cols = 0;
+    grid->rows = 0;
+    grid_box_array_init(&grid->boxes, 0);
+    grid_range_array_init(&grid->ranges, 0);
+    grid_index_array_init(&grid->cell_start, 0);
+    grid_index_array_init(&grid->cell_items, 0);
+    grid_index_array_init(&grid->last_query, 0);
+    grid->query_count = 0;
+    grid_index_array_init(&grid->results, 0);
+
+    return grid;
+}
+
+void spatial_grid_free(spatial_grid_t *grid) {
+    assert(grid);
+
+    grid_box_array_free(&grid->boxes);
+    grid_range_array_free(&grid->ranges);
+    grid_index_array_free(&grid->cell_start);
+    grid_index_array_free(&grid->cell_items);
+    grid_index_array_free(&grid->last_query);
+    grid_index_array_free(&grid->results);
+    free(grid);
+}
+
+// Converts a coordinate to a cell row or column, clamped to the grid
+size_t spatial_grid_cell_coord(double x, double origin, double cell_size, size_t count) {
+    double cell = floor((x - origin) / cell_size);
+    if (!(cell > 0)) {
+        return 0;
+    }
+    if (cell >= count) {
+        return count - 1;
+    }
+    return (size_t)cell;
+}
+
+grid_cell_range_t spatial_grid_cell_range(spatial_grid_t *grid, aabb_t box) {
+    return (grid_cell_range_t){
+        .col0 = spatial_grid_cell_coord(box.min.x, grid->origin.x, grid->cell_size, grid->cols),
+        .col1 = spatial_grid_cell_coord(box.max.x, grid->origin.x, grid->cell_size, grid->cols),
+        .row0 = spatial_grid_cell_coord(box.min.y, grid->origin.y, grid->cell_size, grid->rows),
+        .row1 = spatial_grid_cell_coord(box.max.y, grid->origin.y, grid->cell_size, grid->rows)
+    };
+}
+
+bool spatial_grid_boxes_overlap(aabb_t a, aabb_t b) {
+    return a.min.x <= b.max.x && b.min.x <= a.max.x
+        && a.min.y <= b.max.y && b.min.y <= a.max.y;
+}
+
+void spatial_grid_build(spatial_grid_t *grid, aabb_t bounds, const aabb_t *boxes, size_t num_boxes) {
+    assert(grid);
+    assert(num_boxes == 0 || boxes);
+
+    grid->origin = bounds.min;
+    grid->cols = (size_t)fmax(1, ceil((bounds.max.x - bounds.min.x) / grid->cell_size));
+    grid->rows = (size_t)fmax(1, ceil((bounds.max.y - bounds.min.y) / grid->cell_size));
+    size_t num_cells = grid->cols * grid->rows;
+
+    grid_box_array_clear(&grid->boxes);
+    grid_box_array_reserve(&grid->boxes, num_boxes);
+    grid_range_array_clear(&grid->ranges);
+    grid_range_array_reserve(&grid->ranges, num_boxes);
+    for (size_t i = 0; i < num_boxes; i++) {
+        grid_box_array_add(&grid->boxes, boxes[i]);
+        grid_range_array_add(&grid->ranges, spatial_grid_cell_range(grid, boxes[i]));
+    }
+
+    // Count the boxes in each cell, then turn the counts into start offsets
+    // (a counting sort, so each cell's boxes end up contiguous)
+    grid_index_array_clear(&grid->cell_start);
+    grid_index_array_reserve(&grid->cell_start, num_cells + 1);
+    for (size_t c = 0; c <= num_cells; c++) {
+        grid_index_array_add(&grid->cell_start, 0);
+    }
+    size_t *start = grid->cell_start.data;
+    const grid_cell_range_t *ranges = grid->ranges.data;
+    for (size_t i = 0; i < num_boxes; i++) {
+        grid_cell_range_t r = ranges[i];
+        for (size_t row = r.row0; row <= r.row1; row++) {
+            for (size_t col = r.col0; col <= r.col1; col++) {
+                start[row * grid->cols + col + 1]++;
+            }
+        }
+    }
+    for (size_t c = 0; c < num_cells; c++) {
+        start[c + 1] += start[c];
+    }
+
+    // Fill each cell from its start, using start[c] as a cursor; this leaves
+    // start[c] at the end of cell c, i.e. the start of cell c + 1
+    grid_index_array_clear(&grid->cell_items);
+    grid_index_array_reserve(&grid->cell_items, start[num_cells]);
+    grid->cell_items.size = start[num_cells];
+    for (size_t i = 0; i < num_boxes; i++) {
+        grid_cell_range_t r = ranges[i];
+        for (size_t row = r.row0; row <= r.row1; row++) {
+            for (size_t col = r.col0; col <= r.col1; col++) {
+                grid->cell_items.data[start[row * grid->cols + col]++] = i;
+            }
+        }
+    }
+    for (size_t c = num_cells; c > 0; c--) {
+        start[c] = start[c - 1];
+    }
+    start[0] = 0;
+
+    grid_index_array_clear(&grid->last_query);
+    grid_index_array_reserve(&grid->last_query, num_boxes);
+    for (size_t i = 0; i < num_boxes; i++) {
+        grid_index_array_add(&grid->last_query, 0);
+    }
+    grid->query_count = 0;
+}
+
+int spatial_grid_compare_indices(const void *a, const void *b) {
+    size_t x = *(const size_t *)a;
+    size_t y = *(const size_t *)b;
+    return (x > y) - (x < y);
+}
+
+size_t spatial_grid_query(spatial_grid_t *grid, aabb_t box, const size_t **results) {
+    assert(grid);
+    assert(results);
+
+    grid_index_array_clear(&grid->results);
+    if (grid_box_array_size(&grid->boxes) > 0) {
+        size_t query = ++grid->query_count;
+        size_t *last_query = grid->last_query.data;
+        const size_t *start = grid->cell_start.data;
+
+        grid_cell_range_t r = spatial_grid_cell_range(grid, box);
+        for (size_t row = r.row0; row <= r.row1; row++) {
+            for (size_t col = r.col0; col <= r.col1; col++) {
+                size_t cell = row * grid->cols + col;
+                for (size_t k = start[cell]; k < start[cell + 1]; k++) {
+                    size_t i = grid->cell_items.data[k];
+                    if (last_query[i] != query) {
+                        last_query[i] = query;
+                        if (spatial_grid_boxes_overlap(box, grid->boxes.data[i])) {
+                            grid_index_array_add(&grid->results, i);
+                        }
+                    }
+                }
+            }
+        }
+        if (grid_index_array_size(&grid->results) > 1) {
+            qsort(grid->results.data, grid_index_array_size(&grid->results), sizeof(size_t),
+                  spatial_grid_compare_indices);
+        }
+    }
+
+    *results = grid->results.data;
+    return grid_index_array_size(&grid->results);
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "array.h"
+#include "sweep_prune.h"
+#include <assert.h>
+#include <stdlib.h>
+
+// One end of a box's range of y
+typedef struct sap_endpoint {
+    double y;
+    // The box's index in its set
+    size_t index;
+    // Which set the box is in (0 or 1)
+    size_t set;
+    // Whether this is the top of the box rather than the bottom
+    bool is_max;
+} sap_endpoint_t;
+
+ARRAY_DECLARE(sap_endpoint_array, sap_endpoint_t)
+ARRAY_DECLARE(sap_index_array, size_t)
+ARRAY_DECLARE(sap_pair_array, sweep_prune_pair_t)
+
+typedef struct sweep_prune {
+    sap_endpoint_array_t endpoints;
+    // The boxes of each set whose range of y contains the sweep position,
+    // and where each box is in its active array
+    sap_index_array_t active[2];
+    sap_index_array_t active_pos[2];
+    sap_pair_array_t pairs;
+} sweep_prune_t;
+
+sweep_prune_t *sweep_prune_init(void) {
+    sweep_prune_t *sap = malloc(sizeof(sweep_prune_t));
+    assert(sap);
+
+    sap_endpoint_array_init(&sap->endpoints, 0);
+    for (size_t s = 0; s < 2; s++) {
+        sap_index_array_init(&sap->active[s], 0);
+        sap_index_array_init(&sap->active_pos[s], 0);
+    }
+    sap_pair_array_init(&sap->pairs, 0);
+
+    return sap;
+}
+
+void sweep_prune_free(sweep_prune_t *sap) {
+    assert(sap);
+
+    sap_endpoint_array_free(&sap->endpoints);
+    for (size_t s = 0; s < 2; s++) {
+        sap_index_array_free(&sap->active[s]);
+        sap_index_array_free(&sap->active_pos[s]);
+    }
+    sap_pair_array_free(&sap->pairs);
+    free(sap);
+}
+
+// Endpoints are sorted by y; at equal y, bottoms come first so touching boxes overlap
+bool sweep_prune_endpoint_less(const sap_endpoint_t *a, const sap_endpoint_t *b) {
+    if (a->y != b->y) {
+        return a->y < b->y;
+    }
+    return !a->is_max && b->is_max;
+}
+
+int sweep_prune_compare_endpoints(const void *a, const void *b) {
+    if (sweep_prune_endpoint_less(a, b)) {
+        return -1;
+    }
+    return sweep_prune_endpoint_less(b, a) ? 1 : 0;
+}
+
+int sweep_prune_compare_pairs(const void *a, const void *b) {
+    const sweep_prune_pair_t *x = a;
+    const sweep_prune_pair_t *y = b;
+    if (x->index1 != y->index1) {
+        return x->index1 < y->index1 ? -1 : 1;
+    }
+    return (x->index2 > y->index2) - (x->index2 < y->index2);
+}
+
+void sweep_prune_rebuild(sweep_prune_t *sap, const aabb_t *boxes[2], const size_t num_boxes[2]) {
+    sap_endpoint_array_clear(&sap->endpoints);
+    for (size_t s = 0; s < 2; s++) {
+        for (size_t i = 0; i < num_boxes[s]; i++) {
+            sap_endpoint_t bottom = {.y = boxes[s][i].min.y, .index = i, .set = s, .is_max = false};
+            sap_endpoint_t top = {.y = boxes[s][i].max.y, .index = i, .set = s, .is_max = true};
+            sap_endpoint_array_add(&sap->endpoints, bottom);
+            sap_endpoint_array_add(&sap->endpoints, top);
+        }
+    }
+    if (sap_endpoint_array_size(&sap->endpoints) > 1) {
+        qsort(sap->endpoints.data, sap_endpoint_array_size(&sap->endpoints),
+              sizeof(sap_endpoint_t), sweep_prune_compare_endpoints);
+    }
+}
+
+// Moves each endpoint to its box's new y and restores the order.
+// Insertion sort does O(n + number of endpoints that changed order) work.
+void sweep_prune_resort(sweep_prune_t *sap, const aabb_t *boxes[2]) {
+    sap_endpoint_t *endpoints = sap->endpoints.data;
+    size_t n = sap_endpoint_array_size(&sap->endpoints);
+    for (size_t i = 0; i < n; i++) {
+        aabb_t box = boxes[endpoints[i].set][endpoints[i].index];
+        endpoints[i].y = endpoints[i].is_max ? box.max.y : box.min.y;
+    }
+    for (size_t i = 1; i < n; i++) {
+        sap_endpoint_t e = endpoints[i];
+        size_t j = i;
+        while (j > 0 && sweep_prune_endpoint_less(&e, &endpoints[j - 1])) {
+            endpoints[j] = endpoints[j - 1];
+            j--;
+        }
+        endpoints[j] = e;
+    }
+}
+
+void sweep_prune_update(sweep_prune_t *sap, const aabb_t *boxes1, size_t num_boxes1,
+                        const aabb_t *boxes2, size_t num_boxes2, bool rebuild) {
+    assert(sap);
+    assert(num_boxes1 == 0 || boxes1);
+    assert(num_boxes2 == 0 || boxes2);
+
+    const aabb_t *boxes[2] = {boxes1, boxes2};
+    size_t num_boxes[2] = {num_boxes1, num_boxes2};
+    if (rebuild || sap_endpoint_array_size(&sap->endpoints) != 2 * (num_boxes1 + num_boxes2)) {
+        sweep_prune_rebuild(sap, boxes, num_boxes);
+    }
+    else {
+        sweep_prune_resort(sap, boxes);
+    }
+
+    for (size_t s = 0; s < 2; s++) {
+        sap_index_array_clear(&sap->active[s]);
+        sap_index_array_clear(&sap->active_pos[s]);
+        sap_index_array_reserve(&sap->active_pos[s], num_boxes[s]);
+        sap->active_pos[s].size = num_boxes[s];
+    }
+    sap_pair_array_clear(&sap->pairs);
+
+    // Sweep up the y axis; a box that starts is paired with every active box of the other set
+    ARRAY_FOR_EACH(sap_endpoint_t, e, &sap->endpoints) {
+        size_t s = e->set;
+        sap_index_array_t *active = &sap->active[s];
+        size_t *active_pos = sap->active_pos[s].data;
+        if (e->is_max) {
+            size_t pos = active_pos[e->index];
+            size_t last = *sap_index_array_get(active, sap_index_array_size(active) - 1);
+            sap_index_array_swap_remove(active, pos);
+            if (last != e->index) {
+                active_pos[last] = pos;
+            }
+            continue;
+        }
+
+        aabb_t box = boxes[s][e->index];
+        size_t other = 1 - s;
+        ARRAY_FOR_EACH(size_t, j, &sap->active[other]) {
+            aabb_t other_box = boxes[other][*j];
+            if (box.min.x <= other_box.max.x && other_box.min.x <= box.max.x) {
+                sweep_prune_pair_t pair = s == 0
+                    ? (sweep_prune_pair_t){.index1 = e->index, .index2 = *j}
+                    : (sweep_prune_pair_t){.index1 = *j, .index2 = e->index};
+                sap_pair_array_add(&sap->pairs, pair);
+            }
+        }
+        active_pos[e->index] = sap_index_array_size(active);
+        sap_index_array_add(active, e->index);
+    }
+
+    if (sap_pair_array_size(&sap->pairs) > 1) {
+        qsort(sap->pairs.data, sap_pair_array_size(&sap->pairs), sizeof(sweep_prune_pair_t),
+              sweep_prune_compare_pairs);
+    }
+}
+
+size_t sweep_prune_get_pairs(sweep_prune_t *sap, const sweep_prune_pair_t **pairs) {
+    assert(sap);
+    assert(pairs);
+
+    *pairs = sap->pairs.data;
+    return sap_pair_array_size(&sap->pairs);
+}
\ No newline at end of file
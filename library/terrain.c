@@ -0,0 +1,122 @@
+#include "array.h"
+#include "terrain.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+ARRAY_DECLARE(terrain_surface_array, terrain_surface_t)
+
+typedef struct terrain {
+    vector_t cell_size;
+    size_t cols;
+    size_t rows;
+    terrain_surface_array_t surfaces;
+    // The surface id of each cell, row by row from the origin
+    size_t *cells;
+} terrain_t;
+
+terrain_t *terrain_init(vector_t dimensions, vector_t cell_size, terrain_surface_t surface) {
+    assert(dimensions.x > 0);
+    assert(dimensions.y > 0);
+    assert(cell_size.x > 0);
+    assert(cell_size.y > 0);
+
+    terrain_t *terrain = malloc(sizeof(terrain_t));
+    assert(terrain);
+
+    terrain->cell_size = cell_size;
+    terrain->cols = (size_t)fmax(1, ceil(dimensions.x / cell_size.x));
+    terrain->rows = (size_t)fmax(1, ceil(dimensions.y / cell_size.y));
+    terrain_surface_array_init(&terrain->surfaces, 1);
+    terrain_surface_array_add(&terrain->surfaces, surface);
+    // Every cell starts as surface 0
+    terrain->cells = calloc(terrain->cols * terrain->rows, sizeof(size_t));
+    assert(terrain->cells);
+
+    return terrain;
+}
+
+void terrain_free(terrain_t *terrain) {
+    assert(terrain);
+
+    terrain_surface_array_free(&terrain->surfaces);
+    free(terrain->cells);
+    free(terrain);
+}
+
+size_t terrain_add_surface(terrain_t *terrain, terrain_surface_t surface) {
+    assert(terrain);
+
+    terrain_surface_array_add(&terrain->surfaces, surface);
+    return terrain_surface_array_size(&terrain->surfaces) - 1;
+}
+
+// Converts a coordinate to a cell row or column, clamped to the terrain
+size_t terrain_cell_coord(double x, double cell_size, size_t count) {
+    double cell = floor(x / cell_size);
+    if (!(cell > 0)) {
+        return 0;
+    }
+    if (cell >= count) {
+        return count - 1;
+    }
+    return (size_t)cell;
+}
+
+void terrain_fill(terrain_t *terrain, aabb_t area, size_t surface) {
+    assert(terrain);
+    assert(surface < terrain_surface_array_size(&terrain->surfaces));
+
+    for (size_t row = 0; row < terrain->rows; row++) {
+        double y = (row + 0.5) * terrain->cell_size.y;
+        if (y < area.min.y || y > area.max.y) {
+            continue;
+        }
+        for (size_t col = 0; col < terrain->cols; col++) {
+            double x = (col + 0.5) * terrain->cell_size.x;
+            if (area.min.x <= x && x <= area.max.x) {
+                terrain->cells[row * terrain->cols + col] = surface;
+            }
+        }
+    }
+}
+
+terrain_surface_t terrain_surface_at(terrain_t *terrain, vector_t position) {
+    assert(terrain);
+
+    size_t col = terrain_cell_coord(position.x, terrain->cell_size.x, terrain->cols);
+    size_t row = terrain_cell_coord(position.y, terrain->cell_size.y, terrain->rows);
+    return terrain->surfaces.data[terrain->cells[row * terrain->cols + col]];
+}
+
+terrain_surface_t terrain_get_surface(terrain_t *terrain, size_t surface) {
+    assert(terrain);
+
+    return *terrain_surface_array_get(&terrain->surfaces, surface);
+}
+
+size_t terrain_num_cols(terrain_t *terrain) {
+    assert(terrain);
+
+    return terrain->cols;
+}
+
+size_t terrain_num_rows(terrain_t *terrain) {
+    assert(terrain);
+
+    return terrain->rows;
+}
+
+vector_t terrain_get_cell_size(terrain_t *terrain) {
+    assert(terrain);
+
+    return terrain->cell_size;
+}
+
+size_t terrain_get_cell(terrain_t *terrain, size_t col, size_t row) {
+    assert(terrain);
+    assert(col < terrain->cols);
+    assert(row < terrain->rows);
+
+    return terrain->cells[row * terrain->cols + col];
+}
\ No newline at end of file
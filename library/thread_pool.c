@@ -0,0 +1,274 @@
+#include "thread_pool.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE thread_pool_thread_t;
+typedef CRITICAL_SECTION thread_pool_mutex_t;
+typedef CONDITION_VARIABLE thread_pool_cond_t;
+#else
+#include <pthread.h>
+typedef pthread_t thread_pool_thread_t;
+typedef pthread_mutex_t thread_pool_mutex_t;
+typedef pthread_cond_t thread_pool_cond_t;
+#endif
+
+typedef struct thread_pool_worker {
+    thread_pool_t *pool;
+    // The chunk this worker runs
+    size_t chunk;
+    thread_pool_thread_t thread;
+} thread_pool_worker_t;
+
+typedef struct thread_pool {
+    size_t num_threads;
+    // num_threads - 1 workers; the calling thread runs chunk 0
+    thread_pool_worker_t *workers;
+    thread_pool_mutex_t mutex;
+    thread_pool_cond_t work_ready;
+    thread_pool_cond_t work_done;
+    // Bumped for each run, so workers can tell a new run from a spurious wakeup
+    size_t run_count;
+    // The workers that have not finished the current run
+    size_t num_pending;
+    bool stopping;
+    // The current run
+    thread_pool_task_t task;
+    void *aux;
+    size_t count;
+    size_t num_chunks;
+} thread_pool_t;
+
+// Thin wrappers over the platform's threads
+
+void thread_pool_mutex_init(thread_pool_mutex_t *mutex) {
+#ifdef _WIN32
+    InitializeCriticalSection(mutex);
+#else
+    int err = pthread_mutex_init(mutex, NULL);
+    assert(err == 0);
+    (void)err;
+#endif
+}
+
+void thread_pool_mutex_destroy(thread_pool_mutex_t *mutex) {
+#ifdef _WIN32
+    DeleteCriticalSection(mutex);
+#else
+    pthread_mutex_destroy(mutex);
+#endif
+}
+
+void thread_pool_lock(thread_pool_mutex_t *mutex) {
+#ifdef _WIN32
+    EnterCriticalSection(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+void thread_pool_unlock(thread_pool_mutex_t *mutex) {
+#ifdef _WIN32
+    LeaveCriticalSection(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+}
+
+void thread_pool_cond_init(thread_pool_cond_t *cond) {
+#ifdef _WIN32
+    InitializeConditionVariable(cond);
+#else
+    int err = pthread_cond_init(cond, NULL);
+    assert(err == 0);
+    (void)err;
+#endif
+}
+
+void thread_pool_cond_destroy(thread_pool_cond_t *cond) {
+#ifdef _WIN32
+    // Windows condition variables need no cleanup
+    (void)cond;
+#else
+    pthread_cond_destroy(cond);
+#endif
+}
+
+void thread_pool_wait(thread_pool_cond_t *cond, thread_pool_mutex_t *mutex) {
+#ifdef _WIN32
+    SleepConditionVariableCS(cond, mutex, INFINITE);
+#else
+    pthread_cond_wait(cond, mutex);
+#endif
+}
+
+void thread_pool_signal(thread_pool_cond_t *cond) {
+#ifdef _WIN32
+    WakeConditionVariable(cond);
+#else
+    pthread_cond_signal(cond);
+#endif
+}
+
+void thread_pool_broadcast(thread_pool_cond_t *cond) {
+#ifdef _WIN32
+    WakeAllConditionVariable(cond);
+#else
+    pthread_cond_broadcast(cond);
+#endif
+}
+
+// Runs one chunk of the current run, if the run has that many chunks
+void thread_pool_run_chunk(thread_pool_t *pool, size_t chunk) {
+    if (chunk >= pool->num_chunks) {
+        return;
+    }
+    size_t begin = pool->count * chunk / pool->num_chunks;
+    size_t end = pool->count * (chunk + 1) / pool->num_chunks;
+    pool->task(begin, end, chunk, pool->aux);
+}
+
+void thread_pool_worker_loop(thread_pool_worker_t *worker) {
+    thread_pool_t *pool = worker->pool;
+    size_t seen = 0;
+    thread_pool_lock(&pool->mutex);
+    while (true) {
+        while (pool->run_count == seen && !pool->stopping) {
+            thread_pool_wait(&pool->work_ready, &pool->mutex);
+        }
+        if (pool->stopping) {
+            break;
+        }
+        seen = pool->run_count;
+        thread_pool_unlock(&pool->mutex);
+
+        thread_pool_run_chunk(pool, worker->chunk);
+
+        thread_pool_lock(&pool->mutex);
+        pool->num_pending--;
+        if (pool->num_pending == 0) {
+            thread_pool_signal(&pool->work_done);
+        }
+    }
+    thread_pool_unlock(&pool->mutex);
+}
+
+#ifdef _WIN32
+DWORD WINAPI thread_pool_thread_main(LPVOID worker) {
+    thread_pool_worker_loop(worker);
+    return 0;
+}
+#else
+void *thread_pool_thread_main(void *worker) {
+    thread_pool_worker_loop(worker);
+    return NULL;
+}
+#endif
+
+thread_pool_t *thread_pool_init(size_t num_threads) {
+    assert(num_threads > 0);
+
+    thread_pool_t *pool = malloc(sizeof(thread_pool_t));
+    assert(pool);
+
+    pool->num_threads = num_threads;
+    thread_pool_mutex_init(&pool->mutex);
+    thread_pool_cond_init(&pool->work_ready);
+    thread_pool_cond_init(&pool->work_done);
+    pool->run_count = 0;
+    pool->num_pending = 0;
+    pool->stopping = false;
+    pool->task = NULL;
+    pool->aux = NULL;
+    pool->count = 0;
+    pool->num_chunks = 0;
+
+    pool->workers = NULL;
+    if (num_threads > 1) {
+        pool->workers = malloc(sizeof(thread_pool_worker_t) * (num_threads - 1));
+        assert(pool->workers);
+    }
+    for (size_t i = 0; i + 1 < num_threads; i++) {
+        thread_pool_worker_t *worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->chunk = i + 1;
+#ifdef _WIN32
+        worker->thread = CreateThread(NULL, 0, thread_pool_thread_main, worker, 0, NULL);
+        assert(worker->thread);
+#else
+        int err = pthread_create(&worker->thread, NULL, thread_pool_thread_main, worker);
+        assert(err == 0);
+        (void)err;
+#endif
+    }
+
+    return pool;
+}
+
+void thread_pool_free(thread_pool_t *pool) {
+    assert(pool);
+
+    thread_pool_lock(&pool->mutex);
+    pool->stopping = true;
+    thread_pool_broadcast(&pool->work_ready);
+    thread_pool_unlock(&pool->mutex);
+    for (size_t i = 0; i + 1 < pool->num_threads; i++) {
+#ifdef _WIN32
+        WaitForSingleObject(pool->workers[i].thread, INFINITE);
+        CloseHandle(pool->workers[i].thread);
+#else
+        pthread_join(pool->workers[i].thread, NULL);
+#endif
+    }
+
+    thread_pool_cond_destroy(&pool->work_done);
+    thread_pool_cond_destroy(&pool->work_ready);
+    thread_pool_mutex_destroy(&pool->mutex);
+    free(pool->workers);
+    free(pool);
+}
+
+size_t thread_pool_num_threads(thread_pool_t *pool) {
+    assert(pool);
+
+    return pool->num_threads;
+}
+
+void thread_pool_run(thread_pool_t *pool, size_t count, size_t grain,
+                     thread_pool_task_t task, void *aux) {
+    assert(pool);
+    assert(task);
+
+    if (count == 0) {
+        return;
+    }
+    size_t num_chunks = grain > 0 ? count / grain : count;
+    if (num_chunks > pool->num_threads) {
+        num_chunks = pool->num_threads;
+    }
+    if (num_chunks <= 1) {
+        // Not worth waking anyone
+        task(0, count, 0, aux);
+        return;
+    }
+
+    thread_pool_lock(&pool->mutex);
+    pool->task = task;
+    pool->aux = aux;
+    pool->count = count;
+    pool->num_chunks = num_chunks;
+    pool->num_pending = pool->num_threads - 1;
+    pool->run_count++;
+    thread_pool_broadcast(&pool->work_ready);
+    thread_pool_unlock(&pool->mutex);
+
+    thread_pool_run_chunk(pool, 0);
+
+    thread_pool_lock(&pool->mutex);
+    while (pool->num_pending > 0) {
+        thread_pool_wait(&pool->work_done, &pool->mutex);
+    }
+    thread_pool_unlock(&pool->mutex);
+}
\ No newline at end of file
@@ -0,0 +1,486 @@
+#include "vec_batch.h"
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define VEC_BATCH_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and clang only emit SIMD instructions in functions that enable them;
+// MSVC allows the intrinsics anywhere
+#if defined(__GNUC__) || defined(__clang__)
+#define VEC_BATCH_TARGET(isa) __attribute__((target(isa)))
+#else
+#define VEC_BATCH_TARGET(isa)
+#endif
+
+typedef struct vec_batch_impl {
+    void (*translate)(double *x, double *y, size_t n, vector_t t);
+    void (*rotate)(double *x, double *y, size_t n, double c, double s, vector_t p);
+    void (*transform)(const double *sx, const double *sy, double *dx, double *dy,
+                      size_t n, double c, double s, vector_t t);
+    void (*scale_offset)(const double *sx, const double *sy, double *dx, double *dy,
+                         size_t n, vector_t scale, vector_t offset);
+    vector_t (*project)(const double *x, const double *y, size_t n, vector_t axis);
+    aabb_t (*aabb)(const double *x, const double *y, size_t n);
+} vec_batch_impl_t;
+
+// Scalar kernels. These also finish the last few points of the SIMD kernels.
+
+void vec_batch_translate_scalar(double *x, double *y, size_t n, vector_t t) {
+    for (size_t i = 0; i < n; i++) {
+        x[i] += t.x;
+        y[i] += t.y;
+    }
+}
+
+void vec_batch_rotate_scalar(double *x, double *y, size_t n, double c, double s, vector_t p) {
+    for (size_t i = 0; i < n; i++) {
+        double rx = x[i] - p.x;
+        double ry = y[i] - p.y;
+        x[i] = (rx * c - ry * s) + p.x;
+        y[i] = (rx * s + ry * c) + p.y;
+    }
+}
+
+void vec_batch_transform_scalar(const double *sx, const double *sy, double *dx, double *dy,
+                                size_t n, double c, double s, vector_t t) {
+    for (size_t i = 0; i < n; i++) {
+        double x = sx[i];
+        double y = sy[i];
+        dx[i] = (x * c - y * s) + t.x;
+        dy[i] = (x * s + y * c) + t.y;
+    }
+}
+
+void vec_batch_scale_offset_scalar(const double *sx, const double *sy, double *dx, double *dy,
+                                   size_t n, vector_t scale, vector_t offset) {
+    for (size_t i = 0; i < n; i++) {
+        dx[i] = sx[i] * scale.x + offset.x;
+        dy[i] = sy[i] * scale.y + offset.y;
+    }
+}
+
+vector_t vec_batch_project_scalar(const double *x, const double *y, size_t n, vector_t axis) {
+    double min = INFINITY;
+    double max = -INFINITY;
+    for (size_t i = 0; i < n; i++) {
+        double dot = x[i] * axis.x + y[i] * axis.y;
+        min = dot < min ? dot : min;
+        max = dot > max ? dot : max;
+    }
+    return (vector_t){.x = min, .y = max};
+}
+
+aabb_t vec_batch_aabb_scalar(const double *x, const double *y, size_t n) {
+    aabb_t box = {.min = {.x = INFINITY, .y = INFINITY}, .max = {.x = -INFINITY, .y = -INFINITY}};
+    for (size_t i = 0; i < n; i++) {
+        box.min.x = x[i] < box.min.x ? x[i] : box.min.x;
+        box.min.y = y[i] < box.min.y ? y[i] : box.min.y;
+        box.max.x = x[i] > box.max.x ? x[i] : box.max.x;
+        box.max.y = y[i] > box.max.y ? y[i] : box.max.y;
+    }
+    return box;
+}
+
+const vec_batch_impl_t VEC_BATCH_SCALAR_IMPL = {
+    .translate = vec_batch_translate_scalar,
+    .rotate = vec_batch_rotate_scalar,
+    .transform = vec_batch_transform_scalar,
+    .scale_offset = vec_batch_scale_offset_scalar,
+    .project = vec_batch_project_scalar,
+    .aabb = vec_batch_aabb_scalar
+};
+
+#ifdef VEC_BATCH_X86
+
+// SSE2 kernels: two doubles per instruction
+
+VEC_BATCH_TARGET("sse2")
+void vec_batch_translate_sse2(double *x, double *y, size_t n, vector_t t) {
+    __m128d tx = _mm_set1_pd(t.x);
+    __m128d ty = _mm_set1_pd(t.y);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(x + i, _mm_add_pd(_mm_loadu_pd(x + i), tx));
+        _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), ty));
+    }
+    vec_batch_translate_scalar(x + i, y + i, n - i, t);
+}
+
+VEC_BATCH_TARGET("sse2")
+void vec_batch_rotate_sse2(double *x, double *y, size_t n, double c, double s, vector_t p) {
+    __m128d vc = _mm_set1_pd(c);
+    __m128d vs = _mm_set1_pd(s);
+    __m128d px = _mm_set1_pd(p.x);
+    __m128d py = _mm_set1_pd(p.y);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d rx = _mm_sub_pd(_mm_loadu_pd(x + i), px);
+        __m128d ry = _mm_sub_pd(_mm_loadu_pd(y + i), py);
+        __m128d nx = _mm_sub_pd(_mm_mul_pd(rx, vc), _mm_mul_pd(ry, vs));
+        __m128d ny = _mm_add_pd(_mm_mul_pd(rx, vs), _mm_mul_pd(ry, vc));
+        _mm_storeu_pd(x + i, _mm_add_pd(nx, px));
+        _mm_storeu_pd(y + i, _mm_add_pd(ny, py));
+    }
+    vec_batch_rotate_scalar(x + i, y + i, n - i, c, s, p);
+}
+
+VEC_BATCH_TARGET("sse2")
+void vec_batch_transform_sse2(const double *sx, const double *sy, double *dx, double *dy,
+                              size_t n, double c, double s, vector_t t) {
+    __m128d vc = _mm_set1_pd(c);
+    __m128d vs = _mm_set1_pd(s);
+    __m128d tx = _mm_set1_pd(t.x);
+    __m128d ty = _mm_set1_pd(t.y);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d x = _mm_loadu_pd(sx + i);
+        __m128d y = _mm_loadu_pd(sy + i);
+        __m128d nx = _mm_sub_pd(_mm_mul_pd(x, vc), _mm_mul_pd(y, vs));
+        __m128d ny = _mm_add_pd(_mm_mul_pd(x, vs), _mm_mul_pd(y, vc));
+        _mm_storeu_pd(dx + i, _mm_add_pd(nx, tx));
+        _mm_storeu_pd(dy + i, _mm_add_pd(ny, ty));
+    }
+    vec_batch_transform_scalar(sx + i, sy + i, dx + i, dy + i, n - i, c, s, t);
+}
+
+VEC_BATCH_TARGET("sse2")
+void vec_batch_scale_offset_sse2(const double *sx, const double *sy, double *dx, double *dy,
+                                 size_t n, vector_t scale, vector_t offset) {
+    __m128d kx = _mm_set1_pd(scale.x);
+    __m128d ky = _mm_set1_pd(scale.y);
+    __m128d ox = _mm_set1_pd(offset.x);
+    __m128d oy = _mm_set1_pd(offset.y);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(dx + i, _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(sx + i), kx), ox));
+        _mm_storeu_pd(dy + i, _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(sy + i), ky), oy));
+    }
+    vec_batch_scale_offset_scalar(sx + i, sy + i, dx + i, dy + i, n - i, scale, offset);
+}
+
+VEC_BATCH_TARGET("sse2")
+vector_t vec_batch_project_sse2(const double *x, const double *y, size_t n, vector_t axis) {
+    __m128d ax = _mm_set1_pd(axis.x);
+    __m128d ay = _mm_set1_pd(axis.y);
+    __m128d vmin = _mm_set1_pd(INFINITY);
+    __m128d vmax = _mm_set1_pd(-INFINITY);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d dot = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(x + i), ax),
+                                 _mm_mul_pd(_mm_loadu_pd(y + i), ay));
+        vmin = _mm_min_pd(vmin, dot);
+        vmax = _mm_max_pd(vmax, dot);
+    }
+    double mins[2], maxs[2];
+    _mm_storeu_pd(mins, vmin);
+    _mm_storeu_pd(maxs, vmax);
+    vector_t tail = vec_batch_project_scalar(x + i, y + i, n - i, axis);
+    double min = fmin(fmin(mins[0], mins[1]), tail.x);
+    double max = fmax(fmax(maxs[0], maxs[1]), tail.y);
+    return (vector_t){.x = min, .y = max};
+}
+
+VEC_BATCH_TARGET("sse2")
+aabb_t vec_batch_aabb_sse2(const double *x, const double *y, size_t n) {
+    __m128d min_x = _mm_set1_pd(INFINITY);
+    __m128d min_y = _mm_set1_pd(INFINITY);
+    __m128d max_x = _mm_set1_pd(-INFINITY);
+    __m128d max_y = _mm_set1_pd(-INFINITY);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d vx = _mm_loadu_pd(x + i);
+        __m128d vy = _mm_loadu_pd(y + i);
+        min_x = _mm_min_pd(min_x, vx);
+        min_y = _mm_min_pd(min_y, vy);
+        max_x = _mm_max_pd(max_x, vx);
+        max_y = _mm_max_pd(max_y, vy);
+    }
+    double lx[2], ly[2], hx[2], hy[2];
+    _mm_storeu_pd(lx, min_x);
+    _mm_storeu_pd(ly, min_y);
+    _mm_storeu_pd(hx, max_x);
+    _mm_storeu_pd(hy, max_y);
+    aabb_t box = vec_batch_aabb_scalar(x + i, y + i, n - i);
+    box.min.x = fmin(fmin(lx[0], lx[1]), box.min.x);
+    box.min.y = fmin(fmin(ly[0], ly[1]), box.min.y);
+    box.max.x = fmax(fmax(hx[0], hx[1]), box.max.x);
+    box.max.y = fmax(fmax(hy[0], hy[1]), box.max.y);
+    return box;
+}
+
+const vec_batch_impl_t VEC_BATCH_SSE2_IMPL = {
+    .translate = vec_batch_translate_sse2,
+    .rotate = vec_batch_rotate_sse2,
+    .transform = vec_batch_transform_sse2,
+    .scale_offset = vec_batch_scale_offset_sse2,
+    .project = vec_batch_project_sse2,
+    .aabb = vec_batch_aabb_sse2
+};
+
+// AVX2 kernels: four doubles per instruction.
+// FMA is deliberately not used, so results match the other versions exactly.
+// The upper register halves are cleared before calling non-AVX code
+// (the scalar tails, libm), which otherwise stalls on every transition.
+
+VEC_BATCH_TARGET("avx2")
+void vec_batch_translate_avx2(double *x, double *y, size_t n, vector_t t) {
+    __m256d tx = _mm256_set1_pd(t.x);
+    __m256d ty = _mm256_set1_pd(t.y);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(x + i, _mm256_add_pd(_mm256_loadu_pd(x + i), tx));
+        _mm256_storeu_pd(y + i, _mm256_add_pd(_mm256_loadu_pd(y + i), ty));
+    }
+    _mm256_zeroupper();
+    vec_batch_translate_scalar(x + i, y + i, n - i, t);
+}
+
+VEC_BATCH_TARGET("avx2")
+void vec_batch_rotate_avx2(double *x, double *y, size_t n, double c, double s, vector_t p) {
+    __m256d vc = _mm256_set1_pd(c);
+    __m256d vs = _mm256_set1_pd(s);
+    __m256d px = _mm256_set1_pd(p.x);
+    __m256d py = _mm256_set1_pd(p.y);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d rx = _mm256_sub_pd(_mm256_loadu_pd(x + i), px);
+        __m256d ry = _mm256_sub_pd(_mm256_loadu_pd(y + i), py);
+        __m256d nx = _mm256_sub_pd(_mm256_mul_pd(rx, vc), _mm256_mul_pd(ry, vs));
+        __m256d ny = _mm256_add_pd(_mm256_mul_pd(rx, vs), _mm256_mul_pd(ry, vc));
+        _mm256_storeu_pd(x + i, _mm256_add_pd(nx, px));
+        _mm256_storeu_pd(y + i, _mm256_add_pd(ny, py));
+    }
+    _mm256_zeroupper();
+    vec_batch_rotate_scalar(x + i, y + i, n - i, c, s, p);
+}
+
+VEC_BATCH_TARGET("avx2")
+void vec_batch_transform_avx2(const double *sx, const double *sy, double *dx, double *dy,
+                              size_t n, double c, double s, vector_t t) {
+    __m256d vc = _mm256_set1_pd(c);
+    __m256d vs = _mm256_set1_pd(s);
+    __m256d tx = _mm256_set1_pd(t.x);
+    __m256d ty = _mm256_set1_pd(t.y);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d x = _mm256_loadu_pd(sx + i);
+        __m256d y = _mm256_loadu_pd(sy + i);
+        __m256d nx = _mm256_sub_pd(_mm256_mul_pd(x, vc), _mm256_mul_pd(y, vs));
+        __m256d ny = _mm256_add_pd(_mm256_mul_pd(x, vs), _mm256_mul_pd(y, vc));
+        _mm256_storeu_pd(dx + i, _mm256_add_pd(nx, tx));
+        _mm256_storeu_pd(dy + i, _mm256_add_pd(ny, ty));
+    }
+    _mm256_zeroupper();
+    vec_batch_transform_scalar(sx + i, sy + i, dx + i, dy + i, n - i, c, s, t);
+}
+
+VEC_BATCH_TARGET("avx2")
+void vec_batch_scale_offset_avx2(const double *sx, const double *sy, double *dx, double *dy,
+                                 size_t n, vector_t scale, vector_t offset) {
+    __m256d kx = _mm256_set1_pd(scale.x);
+    __m256d ky = _mm256_set1_pd(scale.y);
+    __m256d ox = _mm256_set1_pd(offset.x);
+    __m256d oy = _mm256_set1_pd(offset.y);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(dx + i, _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(sx + i), kx), ox));
+        _mm256_storeu_pd(dy + i, _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(sy + i), ky), oy));
+    }
+    _mm256_zeroupper();
+    vec_batch_scale_offset_scalar(sx + i, sy + i, dx + i, dy + i, n - i, scale, offset);
+}
+
+VEC_BATCH_TARGET("avx2")
+vector_t vec_batch_project_avx2(const double *x, const double *y, size_t n, vector_t axis) {
+    __m256d ax = _mm256_set1_pd(axis.x);
+    __m256d ay = _mm256_set1_pd(axis.y);
+    __m256d vmin = _mm256_set1_pd(INFINITY);
+    __m256d vmax = _mm256_set1_pd(-INFINITY);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d dot = _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(x + i), ax),
+                                    _mm256_mul_pd(_mm256_loadu_pd(y + i), ay));
+        vmin = _mm256_min_pd(vmin, dot);
+        vmax = _mm256_max_pd(vmax, dot);
+    }
+    double mins[4], maxs[4];
+    _mm256_storeu_pd(mins, vmin);
+    _mm256_storeu_pd(maxs, vmax);
+    _mm256_zeroupper();
+    vector_t tail = vec_batch_project_scalar(x + i, y + i, n - i, axis);
+    double min = fmin(fmin(mins[0], mins[1]), fmin(fmin(mins[2], mins[3]), tail.x));
+    double max = fmax(fmax(maxs[0], maxs[1]), fmax(fmax(maxs[2], maxs[3]), tail.y));
+    return (vector_t){.x = min, .y = max};
+}
+
+VEC_BATCH_TARGET("avx2")
+aabb_t vec_batch_aabb_avx2(const double *x, const double *y, size_t n) {
+    __m256d min_x = _mm256_set1_pd(INFINITY);
+    __m256d min_y = _mm256_set1_pd(INFINITY);
+    __m256d max_x = _mm256_set1_pd(-INFINITY);
+    __m256d max_y = _mm256_set1_pd(-INFINITY);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d vx = _mm256_loadu_pd(x + i);
+        __m256d vy = _mm256_loadu_pd(y + i);
+        min_x = _mm256_min_pd(min_x, vx);
+        min_y = _mm256_min_pd(min_y, vy);
+        max_x = _mm256_max_pd(max_x, vx);
+        max_y = _mm256_max_pd(max_y, vy);
+    }
+    double lx[4], ly[4], hx[4], hy[4];
+    _mm256_storeu_pd(lx, min_x);
+    _mm256_storeu_pd(ly, min_y);
+    _mm256_storeu_pd(hx, max_x);
+    _mm256_storeu_pd(hy, max_y);
+    _mm256_zeroupper();
+    aabb_t box = vec_batch_aabb_scalar(x + i, y + i, n - i);
+    for (size_t j = 0; j < 4; j++) {
+        box.min.x = fmin(lx[j], box.min.x);
+        box.min.y = fmin(ly[j], box.min.y);
+        box.max.x = fmax(hx[j], box.max.x);
+        box.max.y = fmax(hy[j], box.max.y);
+    }
+    return box;
+}
+
+const vec_batch_impl_t VEC_BATCH_AVX2_IMPL = {
+    .translate = vec_batch_translate_avx2,
+    .rotate = vec_batch_rotate_avx2,
+    .transform = vec_batch_transform_avx2,
+    .scale_offset = vec_batch_scale_offset_avx2,
+    .project = vec_batch_project_avx2,
+    .aabb = vec_batch_aabb_avx2
+};
+
+bool vec_batch_cpu_has_sse2(void) {
+#if defined(__x86_64__) || defined(_M_X64)
+    // Part of the x86-64 baseline
+    return true;
+#elif defined(__GNUC__) || defined(__clang__)
+    return __builtin_cpu_supports("sse2");
+#else
+    int regs[4];
+    __cpuid(regs, 1);
+    return (regs[3] >> 26) & 1;
+#endif
+}
+
+bool vec_batch_cpu_has_avx2(void) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_cpu_supports("avx2");
+#else
+    int regs[4];
+    __cpuid(regs, 1);
+    bool osxsave = (regs[2] >> 27) & 1;
+    bool avx = (regs[2] >> 28) & 1;
+    // The OS must also save the upper halves of the registers on context switches
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(regs, 7, 0);
+    return (regs[1] >> 5) & 1;
+#endif
+}
+
+#endif // #ifdef VEC_BATCH_X86
+
+const vec_batch_impl_t *VEC_BATCH_IMPL = NULL;
+vec_batch_isa_t VEC_BATCH_ISA = VEC_BATCH_SCALAR;
+
+bool vec_batch_isa_supported(vec_batch_isa_t isa) {
+    switch (isa) {
+        case VEC_BATCH_SCALAR: {
+            return true;
+        }
+#ifdef VEC_BATCH_X86
+        case VEC_BATCH_SSE2: {
+            return vec_batch_cpu_has_sse2();
+        }
+        case VEC_BATCH_AVX2: {
+            return vec_batch_cpu_has_avx2();
+        }
+#endif
+        default: {
+            return false;
+        }
+    }
+}
+
+void vec_batch_set_isa(vec_batch_isa_t isa) {
+    assert(vec_batch_isa_supported(isa));
+
+    VEC_BATCH_ISA = isa;
+    switch (isa) {
+#ifdef VEC_BATCH_X86
+        case VEC_BATCH_AVX2: {
+            VEC_BATCH_IMPL = &VEC_BATCH_AVX2_IMPL;
+            break;
+        }
+        case VEC_BATCH_SSE2: {
+            VEC_BATCH_IMPL = &VEC_BATCH_SSE2_IMPL;
+            break;
+        }
+#endif
+        default: {
+            VEC_BATCH_IMPL = &VEC_BATCH_SCALAR_IMPL;
+            break;
+        }
+    }
+}
+
+// Picks the fastest supported kernels the first time they are needed
+const vec_batch_impl_t *vec_batch_impl(void) {
+    if (!VEC_BATCH_IMPL) {
+        if (vec_batch_isa_supported(VEC_BATCH_AVX2)) {
+            vec_batch_set_isa(VEC_BATCH_AVX2);
+        }
+        else if (vec_batch_isa_supported(VEC_BATCH_SSE2)) {
+            vec_batch_set_isa(VEC_BATCH_SSE2);
+        }
+        else {
+            vec_batch_set_isa(VEC_BATCH_SCALAR);
+        }
+    }
+    return VEC_BATCH_IMPL;
+}
+
+vec_batch_isa_t vec_batch_get_isa(void) {
+    vec_batch_impl();
+    return VEC_BATCH_ISA;
+}
+
+void vec_batch_translate(double *x, double *y, size_t n, vector_t translation) {
+    vec_batch_impl()->translate(x, y, n, translation);
+}
+
+void vec_batch_rotate(double *x, double *y, size_t n, double cos_a, double sin_a, vector_t pivot) {
+    vec_batch_impl()->rotate(x, y, n, cos_a, sin_a, pivot);
+}
+
+void vec_batch_transform(const double *src_x, const double *src_y, double *dst_x, double *dst_y,
+                         size_t n, double cos_a, double sin_a, vector_t translation) {
+    vec_batch_impl()->transform(src_x, src_y, dst_x, dst_y, n, cos_a, sin_a, translation);
+}
+
+void vec_batch_scale_offset(const double *src_x, const double *src_y, double *dst_x, double *dst_y,
+                            size_t n, vector_t scale, vector_t offset) {
+    vec_batch_impl()->scale_offset(src_x, src_y, dst_x, dst_y, n, scale, offset);
+}
+
+vector_t vec_batch_project(const double *x, const double *y, size_t n, vector_t axis) {
+    return vec_batch_impl()->project(x, y, n, axis);
+}
+
+aabb_t vec_batch_aabb(const double *x, const double *y, size_t n) {
+    assert(n > 0);
+
+    return vec_batch_impl()->aabb(x, y, n);
+}
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <stdlib.h>
 
 const size_t WINDOW_INIT_KEY_HANDLERS = 1;
+const double WINDOW_DEFAULT_TICK_RATE = 120;
+const size_t WINDOW_DEFAULT_MAX_CATCH_UP_STEPS = 8;
 
 typedef struct window {
     scene_t *scene;
@@ -16,6 +18,12 @@ typedef struct window {
     list_t *key_handlers;
     hud_t *hud;
     bool clear_scene;
+    // Fixed timestep state (see window_advance())
+    double tick_length;
+    size_t max_catch_up_steps;
+    double accumulator;
+    double interpolation;
+    vector_t prev_center;
 } window_t;
 
 typedef struct key_handler_info {
@@ -50,6 +58,11 @@ window_t *window_init(scene_t *scene, vector_t center, vector_t dims) {
                                      (free_func_t)free_key_handler_info);
     window->hud = NULL;
     window->clear_scene = false;
+    window->tick_length = 1. / WINDOW_DEFAULT_TICK_RATE;
+    window->max_catch_up_steps = WINDOW_DEFAULT_MAX_CATCH_UP_STEPS;
+    window->accumulator = 0;
+    window->interpolation = 1;
+    window->prev_center = center;
 
     return window;
 }
@@ -77,6 +90,7 @@ void window_set_scene(window_t *window, scene_t *new_scene, vector_t new_center)
     scene_free(window->scene);
     window->scene = new_scene;
     window->center = new_center;
+    window->prev_center = new_center;
     window->velocity = VEC_ZERO;
     window->focused_body = NULL;
 }
@@ -122,6 +136,7 @@ void window_follow_body(window_t *window, body_t *body, vector_t focus_offset) {
 void window_tick(window_t *window, double dt) {
     assert(window);
     
+    window->prev_center = window->center;
     scene_t *scene = window->scene;
     scene_tick(window->scene, dt);
 
@@ -157,6 +172,60 @@ void window_tick(window_t *window, double dt) {
     }
 }
 
+void window_set_tick_rate(window_t *window, double hz) {
+    assert(window);
+    assert(hz > 0);
+
+    window->tick_length = 1. / hz;
+}
+
+void window_set_max_catch_up_steps(window_t *window, size_t max_steps) {
+    assert(window);
+    assert(max_steps > 0);
+
+    window->max_catch_up_steps = max_steps;
+}
+
+size_t window_advance(window_t *window, double frame_time) {
+    assert(window);
+    assert(frame_time >= 0);
+
+    // Never try to catch up more than max_catch_up_steps ticks;
+    // if ticks take longer to simulate than they cover, the rest of the time is dropped
+    double max_frame_time = window->max_catch_up_steps * window->tick_length;
+    if (frame_time > max_frame_time) {
+        frame_time = max_frame_time;
+    }
+
+    window->accumulator += frame_time;
+    size_t steps = 0;
+    while (window->accumulator >= window->tick_length && steps < window->max_catch_up_steps) {
+        window_tick(window, window->tick_length);
+        window->accumulator -= window->tick_length;
+        steps++;
+    }
+    if (window->accumulator >= window->tick_length) {
+        window->accumulator = 0;
+    }
+
+    window->interpolation = window->accumulator / window->tick_length;
+    return steps;
+}
+
+double window_get_interpolation(window_t *window) {
+    assert(window);
+
+    return window->interpolation;
+}
+
+vector_t window_get_render_center(window_t *window) {
+    assert(window);
+
+    double alpha = window->interpolation;
+    return vec_add(window->prev_center,
+                   vec_multiply(alpha, vec_subtract(window->center, window->prev_center)));
+}
+
 void window_on_key(window_t *window, char key, key_event_type_t type, double held_time) {
     assert(window);
 
@@ -0,0 +1,72 @@
+#include "scene.h"
+#include "shape.h"
+#include <assert.h>
+#include <stdio.h>
+
+// Checks that bodies only in collision groups (not in any layer) are freed
+// by the scene: when they are removed, and when the scene is freed.
+// Freed bodies' handles go stale (see body_from_handle()).
+
+const vector_t TEST_DIMENSIONS = {.x = 1000, .y = 1000};
+const double TEST_DT = 1. / 60.;
+
+body_t *test_make_body(void) {
+    rgb_color_t color = {.r = 1, .g = 1, .b = 1};
+    return shape_init_circle(10, color, 1, NULL, NULL);
+}
+
+void test_removed_group_body_is_freed(void) {
+    scene_t *scene = scene_init(TEST_DIMENSIONS);
+    body_t *body = test_make_body();
+    scene_add_to_collision_group(scene, body, 0);
+    body_handle_t handle = body_get_handle(body);
+
+    scene_tick(scene, TEST_DT);
+    assert(body_from_handle(handle) == body);
+    body_remove(body);
+    scene_tick(scene, TEST_DT);
+    assert(body_from_handle(handle) == NULL);
+
+    scene_free(scene);
+}
+
+void test_body_removed_before_joining_is_freed(void) {
+    scene_t *scene = scene_init(TEST_DIMENSIONS);
+    body_t *body = test_make_body();
+    body_handle_t handle = body_get_handle(body);
+    body_remove(body);
+    scene_add_to_collision_group(scene, body, 0);
+    scene_add_to_collision_group(scene, body, 1);
+
+    scene_tick(scene, TEST_DT);
+    assert(body_from_handle(handle) == NULL);
+
+    scene_free(scene);
+}
+
+void test_group_bodies_are_freed_with_scene(void) {
+    scene_t *scene = scene_init(TEST_DIMENSIONS);
+    // In two groups, so it must only be freed once
+    body_t *grouped = test_make_body();
+    scene_add_to_collision_group(scene, grouped, 0);
+    scene_add_to_collision_group(scene, grouped, 1);
+    // In a layer as well, so the layer frees it
+    body_t *layered = test_make_body();
+    scene_add_body(scene, layered);
+    scene_add_to_collision_group(scene, layered, 0);
+    body_handle_t grouped_handle = body_get_handle(grouped);
+    body_handle_t layered_handle = body_get_handle(layered);
+
+    scene_tick(scene, TEST_DT);
+    scene_free(scene);
+    assert(body_from_handle(grouped_handle) == NULL);
+    assert(body_from_handle(layered_handle) == NULL);
+}
+
+int main(int argc, char *argv[]) {
+    test_removed_group_body_is_freed();
+    test_body_removed_before_joining_is_freed();
+    test_group_bodies_are_freed_with_scene();
+    printf("scene_groups_test passed\n");
+    return 0;
+}
\ No newline at end of file
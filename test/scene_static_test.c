@@ -0,0 +1,77 @@
+#include "collision.h"
+#include "scene.h"
+#include "shape.h"
+#include <assert.h>
+#include <stdio.h>
+
+// Checks that collision rules and scene_query_box() find a static body
+// where it was last moved to, whichever broadphase the scene uses.
+
+const vector_t TEST_DIMENSIONS = {.x = 1000, .y = 1000};
+const double TEST_DT = 1. / 60.;
+const double TEST_RADIUS = 10;
+const vector_t TEST_DYNAMIC_POSITION = {.x = 100, .y = 100};
+const vector_t TEST_STATIC_POSITION = {.x = 500, .y = 500};
+const size_t TEST_NUM_MOVES = 100;
+
+bool test_rule(body_t *body1, body_t *body2, separating_axis_t *hint,
+               collision_info_t *out, void *aux) {
+    return find_body_collision_cached(body1, body2, hint, out);
+}
+
+void test_handler(body_t *body1, body_t *body2, const contact_t *contact, void *aux) {
+}
+
+body_t *test_make_body(vector_t position) {
+    rgb_color_t color = {.r = 1, .g = 1, .b = 1};
+    body_t *body = shape_init_circle(TEST_RADIUS, color, 1, NULL, NULL);
+    body_set_centroid(body, position);
+    return body;
+}
+
+void test_moved_static_body_collides(scene_broadphase_t broadphase) {
+    scene_options_t options = {.broadphase = broadphase};
+    scene_t *scene = scene_init_with_options(TEST_DIMENSIONS, options);
+    body_t *dynamic = test_make_body(TEST_DYNAMIC_POSITION);
+    scene_add_body(scene, dynamic);
+    scene_add_to_collision_group(scene, dynamic, 0);
+    body_t *wall = test_make_body(TEST_STATIC_POSITION);
+    body_make_static(wall);
+    scene_add_body(scene, wall);
+    scene_add_to_collision_group(scene, wall, 1);
+    scene_add_collision_rule(scene, 0, 1, test_rule, test_handler, NULL, NULL);
+
+    scene_tick(scene, TEST_DT);
+    assert(scene_num_contacts(scene) == 0);
+
+    // Moved several times in one tick; only where it ends up counts
+    for (size_t i = 0; i < TEST_NUM_MOVES; i++) {
+        body_set_centroid(wall, vec_multiply(i, TEST_STATIC_POSITION));
+        body_set_rotation(wall, i);
+    }
+    body_set_centroid(wall, TEST_DYNAMIC_POSITION);
+    scene_tick(scene, TEST_DT);
+    assert(scene_num_contacts(scene) == 1);
+    body_t **results;
+    aabb_t box = body_get_aabb(dynamic);
+    assert(scene_query_box(scene, 1, box, &results) == 1);
+    assert(results[0] == wall);
+
+    // And it is no longer found where it was
+    body_set_centroid(wall, TEST_STATIC_POSITION);
+    scene_tick(scene, TEST_DT);
+    scene_tick(scene, TEST_DT);
+    assert(scene_num_contacts(scene) == 0);
+    assert(scene_query_box(scene, 1, box, &results) == 0);
+
+    scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+    test_moved_static_body_collides(SCENE_BROADPHASE_GRID);
+    test_moved_static_body_collides(SCENE_BROADPHASE_SWEEP_PRUNE);
+    test_moved_static_body_collides(SCENE_BROADPHASE_AABB_TREE);
+    test_moved_static_body_collides(SCENE_BROADPHASE_BRUTE_FORCE);
+    printf("scene_static_test passed\n");
+    return 0;
+}
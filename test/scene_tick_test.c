@@ -0,0 +1,49 @@
+#include "scene.h"
+#include "shape.h"
+#include <assert.h>
+#include <stdio.h>
+
+// Checks that tick functions can add bodies to the scene they are ticked in,
+// even when that grows the layer being walked or adds new layers.
+
+const vector_t TEST_DIMENSIONS = {.x = 1000, .y = 1000};
+const double TEST_DT = 1. / 60.;
+const size_t TEST_NUM_SPAWNED = 100;
+const size_t TEST_SPAWN_LAYER = 5;
+
+body_t *test_make_body(void *info) {
+    rgb_color_t color = {.r = 1, .g = 1, .b = 1};
+    return shape_init_circle(10, color, 1, info, NULL);
+}
+
+// Adds bodies to the spawner's own layer and to a layer that does not exist yet
+void test_spawn_tick(body_t *spawner, void *dt) {
+    scene_t *scene = body_get_info(spawner);
+    for (size_t i = 0; i < TEST_NUM_SPAWNED; i++) {
+        scene_add_body(scene, test_make_body(NULL));
+        scene_add_body_in_layer(scene, test_make_body(NULL), TEST_SPAWN_LAYER);
+    }
+}
+
+void test_tick_adds_bodies(scene_options_t options) {
+    scene_t *scene = scene_init_with_options(TEST_DIMENSIONS, options);
+    body_t *spawner = test_make_body(scene);
+    body_register_tick_func(spawner, test_spawn_tick);
+    scene_add_body(scene, spawner);
+
+    scene_tick(scene, TEST_DT);
+    assert(scene_num_bodies(scene) == 1 + 2 * TEST_NUM_SPAWNED);
+    scene_tick(scene, TEST_DT);
+    assert(scene_num_bodies(scene) == 1 + 4 * TEST_NUM_SPAWNED);
+
+    scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+    scene_options_t options = {.broadphase = SCENE_BROADPHASE_GRID};
+    test_tick_adds_bodies(options);
+    options.soa_physics = true;
+    test_tick_adds_bodies(options);
+    printf("scene_tick_test passed\n");
+    return 0;
+}